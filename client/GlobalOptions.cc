@@ -23,9 +23,9 @@
 
 #include "misc.h"
 #include "client/GlobalOptions.h"
-#include "client/utils/text.h"
-#include "client/utils/TableFormatter.h"
-#include "client/utils/CsvFormatter.h"
+#include "utils/text.h"
+#include "utils/TableFormatter.h"
+#include "utils/CsvFormatter.h"
 
 
 namespace snapper
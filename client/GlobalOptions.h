@@ -26,8 +26,8 @@
 
 #include <snapper/Enum.h>
 
-#include "client/utils/GetOpts.h"
-#include "client/utils/Table.h"
+#include "utils/GetOpts.h"
+#include "utils/Table.h"
 
 
 namespace snapper
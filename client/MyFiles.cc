@@ -21,9 +21,10 @@
  */
 
 
+#include <string.h>
 #include <iostream>
 
-#include "proxy.h"
+#include "proxy/proxy.h"
 #include "utils/text.h"
 #include "GlobalOptions.h"
 
@@ -43,24 +44,29 @@ namespace snapper
 	{
 	    AsciiFileReader asciifile(file, Compression::NONE);
 
-	    string line;
-	    while (asciifile.read_line(line))
+	    string name;
+
+	    const char* line;
+	    size_t size;
+	    while (asciifile.read_line(line, size))
 	    {
-		if (line.empty())
+		if (size == 0)
 		    continue;
 
-		string name = line;
+		const char* p = line;
 
 		// strip optional status
-		if (name[0] != '/')
+		if (p[0] != '/')
 		{
-		    string::size_type pos = name.find(" ");
-		    if (pos == string::npos)
+		    const char* pos = (const char*) memchr(line, ' ', size);
+		    if (!pos)
 			continue;
 
-		    name.erase(0, pos + 1);
+		    p = pos + 1;
 		}
 
+		name.assign(p, line + size);
+
 		Files::iterator it = findAbsolutePath(name);
 		if (it == end())
 		{
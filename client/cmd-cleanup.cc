@@ -35,8 +35,8 @@
 #include "utils/HumanString.h"
 #include "utils/text.h"
 #include "GlobalOptions.h"
-#include "proxy.h"
-#include "cleanup.h"
+#include "proxy/proxy.h"
+#include "proxy/cleanup.h"
 #include "misc.h"
 #include "cmd.h"
 
@@ -27,7 +27,7 @@
 
 #include "utils/text.h"
 #include "GlobalOptions.h"
-#include "proxy.h"
+#include "proxy/proxy.h"
 #include "misc.h"
 
 
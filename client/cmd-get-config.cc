@@ -25,7 +25,7 @@
 
 #include "utils/text.h"
 #include "GlobalOptions.h"
-#include "proxy.h"
+#include "proxy/proxy.h"
 #include "misc.h"
 #include "utils/TableFormatter.h"
 #include "utils/CsvFormatter.h"
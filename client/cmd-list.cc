@@ -33,7 +33,7 @@
 
 #include "utils/text.h"
 #include "GlobalOptions.h"
-#include "proxy.h"
+#include "proxy/proxy.h"
 #include "misc.h"
 #include "utils/TableFormatter.h"
 #include "utils/CsvFormatter.h"
@@ -98,12 +98,17 @@ namespace snapper
 	 * Some help for the output, e.g. check if a snapshot is the default or active
 	 * snapshot, check if a snapshot should be skipped in the output or check if the
 	 * used-space works.
+	 *
+	 * Everything needed for several rows, e.g. the config, the default and active
+	 * snapshot and the post snapshots of pre snapshots, is queried once when the
+	 * object is constructed to avoid one query, possibly a DBus round trip, per row.
 	 */
 	class OutputHelper
 	{
 	public:
 
-	    OutputHelper(const ProxySnapper* snapper, const vector<Column>& columns);
+	    OutputHelper(const ProxySnapper* snapper, const ProxyConfig& config,
+			 const vector<Column>& columns);
 
 	    bool is_default(const ProxySnapshot& snapshot) const
 	    {
@@ -126,9 +131,10 @@ namespace snapper
 		if (snapshot.getType() != SnapshotType::PRE)
 		    return snapshots.end();
 
-		ProxySnapshots::const_iterator it = snapshots.find(snapshot.getNum());
+		map<unsigned int, ProxySnapshots::const_iterator>::const_iterator it =
+		    post_snapshots.find(snapshot.getNum());
 
-		return snapshots.findPost(it);
+		return it != post_snapshots.end() ? it->second : snapshots.end();
 	    }
 
 	    bool is_used_space_broken() const { return used_space_broken; }
@@ -140,11 +146,18 @@ namespace snapper
 	    const ProxySnapper* snapper;
 	    const ProxySnapshots& snapshots;
 
+	    const string subvolume;
+
 	private:
 
 	    ProxySnapshots::const_iterator default_snapshot;
 	    ProxySnapshots::const_iterator active_snapshot;
 
+	    /**
+	     * Post snapshots by the number of their pre snapshot.
+	     */
+	    map<unsigned int, ProxySnapshots::const_iterator> post_snapshots;
+
 	    bool used_space_broken = true;
 
 #ifdef ENABLE_BTRFS
@@ -167,9 +180,10 @@ namespace snapper
 #endif
 
 
-	OutputHelper::OutputHelper(const ProxySnapper* snapper, const vector<Column>& columns)
-	    : snapper(snapper), snapshots(snapper->getSnapshots()), default_snapshot(snapshots.end()),
-	      active_snapshot(snapshots.end())
+	OutputHelper::OutputHelper(const ProxySnapper* snapper, const ProxyConfig& config,
+				   const vector<Column>& columns)
+	    : snapper(snapper), snapshots(snapper->getSnapshots()), subvolume(config.getSubvolume()),
+	      default_snapshot(snapshots.end()), active_snapshot(snapshots.end())
 	{
 	    try
 	    {
@@ -188,13 +202,19 @@ namespace snapper
 		    SN_RETHROW(e);
 	    }
 
+	    // Like ProxySnapshots::findPost() use the first post snapshot found.
+
+	    for (ProxySnapshots::const_iterator it = snapshots.begin(); it != snapshots.end(); ++it)
+	    {
+		if (it->getType() == POST)
+		    post_snapshots.emplace(it->getPreNum(), it);
+	    }
+
 	    // Calculate the used space iff columns include USED_SPACE. Also sets
 	    // used_space_broken (even cached) for use in skip_column.
 
 	    if (find(columns.begin(), columns.end(), Column::USED_SPACE) != columns.end())
 	    {
-		string subvolume = snapper->getConfig().getSubvolume();
-
 #ifdef ENABLE_BTRFS
 
 		try
@@ -397,7 +417,7 @@ namespace snapper
 		    return output_helper.snapper->configName();
 
 		case Column::SUBVOLUME:
-		    return output_helper.snapper->getConfig().getSubvolume();
+		    return output_helper.subvolume;
 
 		case Column::NUMBER:
 		{
@@ -569,7 +589,8 @@ namespace snapper
 
 	void
 	output(GlobalOptions& global_options, const vector<Column>& columns,
-	       const vector<const ProxySnapper*>& snappers, ListMode list_mode)
+	       const vector<const ProxySnapper*>& snappers, const map<string, ProxyConfig>& configs,
+	       ListMode list_mode)
 	{
 	    switch (global_options.output_format())
 	    {
@@ -584,14 +605,14 @@ namespace snapper
 			if (!first_table)
 			    cout << endl;
 
+			OutputHelper output_helper(snapper, configs.at(snapper->configName()), columns);
+
 			if (snappers.size() > 1)
 			{
 			    cout << "Config: " << snapper->configName() << ", subvolume: "
-				 << snapper->getConfig().getSubvolume() << endl;
+				 << output_helper.subvolume << endl;
 			}
 
-			OutputHelper output_helper(snapper, columns);
-
 			TableFormatter formatter(global_options.table_style());
 
 			for (Column column : columns)
@@ -641,7 +662,7 @@ namespace snapper
 
 		    for (const ProxySnapper* snapper : snappers)
 		    {
-			OutputHelper output_helper(snapper, columns);
+			OutputHelper output_helper(snapper, configs.at(snapper->configName()), columns);
 
 			for (const ProxySnapshot& snapshot : output_helper.snapshots)
 			{
@@ -673,7 +694,7 @@ namespace snapper
 			json_object* json_config = json_object_new_array();
 			json_object_object_add(formatter.root(), snapper->configName().c_str(), json_config);
 
-			OutputHelper output_helper(snapper, columns);
+			OutputHelper output_helper(snapper, configs.at(snapper->configName()), columns);
 
 			for (const ProxySnapshot& snapshot : output_helper.snapshots)
 			{
@@ -752,16 +773,28 @@ namespace snapper
 
 	if ((opt = opts.find("all-configs")) == opts.end())
 	{
-	    output(global_options, columns, { snappers->getSnapper(global_options.config()) }, list_mode);
+	    const ProxySnapper* snapper = snappers->getSnapper(global_options.config());
+
+	    map<string, ProxyConfig> configs;
+	    configs.emplace(snapper->configName(), snapper->getConfig());
+
+	    output(global_options, columns, { snapper }, configs, list_mode);
 	}
 	else
 	{
-	    vector<const ProxySnapper*> tmp;
+	    // The configs are already included in the list of configs. The
+	    // snapshots of all configs are loaded at once.
+
+	    map<string, ProxyConfig> configs = snappers->getConfigs();
+
+	    vector<string> config_names;
+	    for (const map<string, ProxyConfig>::value_type& value : configs)
+		config_names.push_back(value.first);
 
-	    for (map<string, ProxyConfig>::value_type it : snappers->getConfigs())
-		tmp.push_back(snappers->getSnapper(it.first));
+	    vector<ProxySnapper*> tmp = snappers->getSnappers(config_names);
 
-	    output(global_options, columns, tmp, list_mode);
+	    output(global_options, columns, vector<const ProxySnapper*>(tmp.begin(), tmp.end()), configs,
+		   list_mode);
 	}
     }
 
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "config.h"
+
+#include <iostream>
+
+#include "utils/text.h"
+#include "GlobalOptions.h"
+#include "proxy/proxy.h"
+
+
+namespace snapper
+{
+
+    using namespace std;
+
+
+#ifdef ENABLE_SELINUX
+
+    void
+    help_resync_selinux()
+    {
+	cout << _("  Resync SELinux contexts:") << '\n'
+	     << _("\tsnapper resync-selinux") << '\n'
+	     << endl;
+    }
+
+
+    void
+    command_resync_selinux(GlobalOptions& global_options, GetOpts& get_opts, ProxySnappers*, ProxySnapper* snapper)
+    {
+	ParsedOpts opts = get_opts.parse("resync-selinux", GetOpts::no_options);
+	if (get_opts.num_args() != 0)
+	{
+	    cerr << _("Command 'resync-selinux' does not take arguments.") << endl;
+	    exit(EXIT_FAILURE);
+	}
+
+	snapper->resyncSelinuxContexts();
+    }
+
+#endif
+
+}
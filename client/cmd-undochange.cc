@@ -27,7 +27,7 @@
 
 #include "utils/text.h"
 #include "GlobalOptions.h"
-#include "proxy.h"
+#include "proxy/proxy.h"
 #include "MyFiles.h"
 
 
@@ -123,39 +123,48 @@ namespace snapper
 		cerr << "internal error" << endl;
 		exit(EXIT_FAILURE);
 	    }
+	}
+
+	// Independent files are restored in parallel. The callbacks are
+	// serialized by doUndo.
+
+	files.doUndo(0, [&global_options](const File& file) {
 
 	    if (global_options.verbose())
 	    {
-		switch (it1->action)
+		switch (file.getAction())
 		{
 		    case CREATE:
-			cout << sformat(_("creating %s"), it2->getAbsolutePath(LOC_SYSTEM).c_str()) << endl;
+			cout << sformat(_("creating %s"), file.getAbsolutePath(LOC_SYSTEM).c_str()) << endl;
 			break;
 		    case MODIFY:
-			cout << sformat(_("modifying %s"), it2->getAbsolutePath(LOC_SYSTEM).c_str()) << endl;
+			cout << sformat(_("modifying %s"), file.getAbsolutePath(LOC_SYSTEM).c_str()) << endl;
 			break;
 		    case DELETE:
-			cout << sformat(_("deleting %s"), it2->getAbsolutePath(LOC_SYSTEM).c_str()) << endl;
+			cout << sformat(_("deleting %s"), file.getAbsolutePath(LOC_SYSTEM).c_str()) << endl;
 			break;
 		}
 	    }
 
-	    if (!it2->doUndo())
+	}, [](const File& file, bool ok) {
+
+	    if (!ok)
 	    {
-		switch (it1->action)
+		switch (file.getAction())
 		{
 		    case CREATE:
-			cerr << sformat(_("failed to create %s"), it2->getAbsolutePath(LOC_SYSTEM).c_str()) << endl;
+			cerr << sformat(_("failed to create %s"), file.getAbsolutePath(LOC_SYSTEM).c_str()) << endl;
 			break;
 		    case MODIFY:
-			cerr << sformat(_("failed to modify %s"), it2->getAbsolutePath(LOC_SYSTEM).c_str()) << endl;
+			cerr << sformat(_("failed to modify %s"), file.getAbsolutePath(LOC_SYSTEM).c_str()) << endl;
 			break;
 		    case DELETE:
-			cerr << sformat(_("failed to delete %s"), it2->getAbsolutePath(LOC_SYSTEM).c_str()) << endl;
+			cerr << sformat(_("failed to delete %s"), file.getAbsolutePath(LOC_SYSTEM).c_str()) << endl;
 			break;
 		}
 	    }
-	}
+
+	});
     }
 
 }
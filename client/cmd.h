@@ -23,7 +23,7 @@
 
 #include "config.h"
 
-#include "proxy.h"
+#include "proxy/proxy.h"
 #include "GlobalOptions.h"
 
 
@@ -157,6 +157,17 @@ namespace snapper
     command_setup_quota(GlobalOptions& global_options, GetOpts& get_opts, ProxySnappers* snappers, ProxySnapper* snapper);
 
 
+#ifdef ENABLE_SELINUX
+
+    void
+    help_resync_selinux();
+
+    void
+    command_resync_selinux(GlobalOptions& global_options, GetOpts& get_opts, ProxySnappers* snappers, ProxySnapper* snapper);
+
+#endif
+
+
     struct CleanupException : public Exception
     {
 	explicit CleanupException(const string& msg) : Exception(msg) {}
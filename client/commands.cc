@@ -21,7 +21,10 @@
  */
 
 
+#include "config.h"
+
 #include <stdio.h>
+#include <string.h>
 #include <iostream>
 
 #include "commands.h"
@@ -227,6 +230,27 @@ command_create_single_snapshot_of_default(DBus::Connection& conn, const string&
 }
 
 
+vector<unsigned int>
+command_create_single_snapshots(DBus::Connection& conn, const vector<string>& config_names,
+				const string& description, const string& cleanup,
+				const map<string, string>& userdata)
+{
+    DBus::MessageMethodCall call(SERVICE, OBJECT, INTERFACE, "CreateSingleSnapshots");
+
+    DBus::Hoho hoho(call);
+    hoho << config_names << description << cleanup << userdata;
+
+    DBus::Message reply = conn.send_with_reply_and_block(call);
+
+    vector<unsigned int> numbers;
+
+    DBus::Hihi hihi(reply);
+    hihi >> numbers;
+
+    return numbers;
+}
+
+
 unsigned int
 command_create_pre_snapshot(DBus::Connection& conn, const string& config_name,
 			    const string& description, const string& cleanup,
@@ -388,6 +412,49 @@ command_get_used_space(DBus::Connection& conn, const string& config_name, unsign
 }
 
 
+vector<uint64_t>
+command_get_used_spaces(DBus::Connection& conn, const string& config_name,
+			const vector<unsigned int>& nums)
+{
+    // The system bus limits the number of pending replies per connection
+    // (usually to 128), so send the calls in chunks.
+
+    const size_t chunk_size = 64;
+
+    vector<uint64_t> used_spaces;
+    used_spaces.reserve(nums.size());
+
+    for (size_t i = 0; i < nums.size(); i += chunk_size)
+    {
+	vector<DBus::PendingCall> pending_calls;
+
+	for (size_t j = i; j < min(i + chunk_size, nums.size()); ++j)
+	{
+	    DBus::MessageMethodCall call(SERVICE, OBJECT, INTERFACE, "GetUsedSpace");
+
+	    DBus::Hoho hoho(call);
+	    hoho << config_name << nums[j];
+
+	    pending_calls.push_back(conn.send_with_reply(call));
+	}
+
+	for (DBus::PendingCall& pending_call : pending_calls)
+	{
+	    DBus::Message reply = pending_call.get_reply();
+
+	    uint64_t used_space;
+
+	    DBus::Hihi hihi(reply);
+	    hihi >> used_space;
+
+	    used_spaces.push_back(used_space);
+	}
+    }
+
+    return used_spaces;
+}
+
+
 string
 command_mount_snapshot(DBus::Connection& conn, const string& config_name,
 		       unsigned int num, bool user_request)
@@ -453,6 +520,27 @@ command_create_comparison(DBus::Connection& conn, const string& config_name, uns
 }
 
 
+vector<bool>
+command_are_comparisons_empty(DBus::Connection& conn, const string& config_name,
+			      const vector<unsigned int>& numbers1,
+			      const vector<unsigned int>& numbers2)
+{
+    DBus::MessageMethodCall call(SERVICE, OBJECT, INTERFACE, "AreComparisonsEmpty");
+
+    DBus::Hoho hoho(call);
+    hoho << config_name << numbers1 << numbers2;
+
+    DBus::Message reply = conn.send_with_reply_and_block(call);
+
+    vector<bool> empty;
+
+    DBus::Hihi hihi(reply);
+    hihi >> empty;
+
+    return empty;
+}
+
+
 void
 command_delete_comparison(DBus::Connection& conn, const string& config_name, unsigned int number1,
 			  unsigned int number2)
@@ -549,6 +637,165 @@ command_get_xfiles_by_pipe(DBus::Connection& conn, const string& config_name, un
 }
 
 
+/**
+ * Reads configs with their snapshots in the format of ListAllByPipe.
+ */
+static vector<XConfigSnapshots>
+read_xconfig_snapshots(DBus::FileDescriptor& fd)
+{
+    vector<XConfigSnapshots> configs;
+
+    FILE* fin = fdopen(fd.get_fd(), "r");
+    if (!fin)
+	SN_THROW(IOErrorException("reading pipe failed, fdopen failed: " + stringerror(errno)));
+
+    char* buffer = nullptr;
+    size_t len = 0;
+
+    while (true)
+    {
+	ssize_t n = getline(&buffer, &len, fin);
+	if (n == -1)
+	{
+	    if (feof(fin) != 0)
+		break;
+
+	    SN_THROW(IOErrorException("reading pipe failed, getline failed: " + stringerror(errno)));
+	}
+
+	if (n > 0 && buffer[n - 1] == '\n')
+	    --n;
+
+	// Fields are separated by exactly one space so empty fields are kept.
+
+	vector<string> fields;
+
+	string::size_type pos1 = 0;
+	while (true)
+	{
+	    const char* pos2 = (const char*) memchr(buffer + pos1, ' ', n - pos1);
+	    if (!pos2)
+	    {
+		fields.emplace_back(buffer + pos1, n - pos1);
+		break;
+	    }
+
+	    fields.emplace_back(buffer + pos1, pos2 - buffer - pos1);
+	    pos1 = pos2 - buffer + 1;
+	}
+
+	const string& keyword = fields[0];
+
+	if (keyword == "config" && fields.size() >= 3)
+	{
+	    XConfigSnapshots config;
+	    config.config_info.config_name = DBus::Pipe::unescape(fields[1]);
+	    config.config_info.subvolume = DBus::Pipe::unescape(fields[2]);
+	    config.error = false;
+	    config.default_snapshot = make_pair(false, 0);
+	    config.active_snapshot = make_pair(false, 0);
+	    configs.push_back(config);
+	    continue;
+	}
+
+	if (configs.empty())
+	    SN_THROW(IOErrorException("reading pipe failed, parse error"));
+
+	XConfigSnapshots& config = configs.back();
+
+	if (keyword == "value" && fields.size() >= 3)
+	{
+	    config.config_info.raw[DBus::Pipe::unescape(fields[1])] = DBus::Pipe::unescape(fields[2]);
+	}
+	else if (keyword == "error")
+	{
+	    config.error = true;
+	}
+	else if (keyword == "default" && fields.size() >= 2)
+	{
+	    config.default_snapshot = make_pair(true, stoul(fields[1]));
+	}
+	else if (keyword == "active" && fields.size() >= 2)
+	{
+	    config.active_snapshot = make_pair(true, stoul(fields[1]));
+	}
+	else if (keyword == "snapshot" && fields.size() >= 8)
+	{
+	    XSnapshot snapshot;
+	    snapshot.num = stoul(fields[1]);
+	    snapshot.type = static_cast<SnapshotType>(stoul(fields[2]));
+	    snapshot.date = stoll(fields[3]);
+	    snapshot.uid = stoul(fields[4]);
+	    snapshot.pre_num = stoul(fields[5]);
+	    snapshot.description = DBus::Pipe::unescape(fields[6]);
+	    snapshot.cleanup = DBus::Pipe::unescape(fields[7]);
+	    config.snapshots.entries.push_back(snapshot);
+	}
+	else if (keyword == "userdata" && fields.size() >= 3)
+	{
+	    if (config.snapshots.entries.empty())
+		SN_THROW(IOErrorException("reading pipe failed, parse error"));
+
+	    config.snapshots.entries.back().userdata[DBus::Pipe::unescape(fields[1])] =
+		DBus::Pipe::unescape(fields[2]);
+	}
+	else if (keyword == "used-space" && fields.size() >= 3)
+	{
+	    config.used_spaces[stoul(fields[1])] = stoull(fields[2]);
+	}
+    }
+
+    free(buffer);
+
+    if (fclose(fin) != 0)
+	SN_THROW(IOErrorException("reading pipe failed, fclose failed: " + stringerror(errno)));
+
+    return configs;
+}
+
+
+vector<XConfigSnapshots>
+command_list_all_by_pipe(DBus::Connection& conn, bool used_space)
+{
+    DBus::MessageMethodCall call(SERVICE, OBJECT, INTERFACE, "ListAllByPipe");
+
+    DBus::Hoho hoho(call);
+    hoho << used_space;
+
+    DBus::Message reply = conn.send_with_reply_and_block(call);
+
+    DBus::FileDescriptor fd;
+
+    DBus::Hihi hihi(reply);
+    hihi >> fd;
+
+    return read_xconfig_snapshots(fd);
+}
+
+
+XConfigSnapshots
+command_list_snapshots_by_pipe(DBus::Connection& conn, const string& config_name)
+{
+    DBus::MessageMethodCall call(SERVICE, OBJECT, INTERFACE, "ListSnapshotsByPipe");
+
+    DBus::Hoho hoho(call);
+    hoho << config_name;
+
+    DBus::Message reply = conn.send_with_reply_and_block(call);
+
+    DBus::FileDescriptor fd;
+
+    DBus::Hihi hihi(reply);
+    hihi >> fd;
+
+    vector<XConfigSnapshots> configs = read_xconfig_snapshots(fd);
+    if (configs.size() != 1 || configs.front().error)
+	SN_THROW(IOErrorException("reading pipe failed, parse error"));
+
+    return configs.front();
+}
+
+
 void
 command_setup_quota(DBus::Connection& conn, const string& config_name)
 {
@@ -561,6 +808,22 @@ command_setup_quota(DBus::Connection& conn, const string& config_name)
 }
 
 
+#ifdef ENABLE_SELINUX
+
+void
+command_resync_selinux_contexts(DBus::Connection& conn, const string& config_name)
+{
+    DBus::MessageMethodCall call(SERVICE, OBJECT, INTERFACE, "ResyncSelinuxContexts");
+
+    DBus::Hoho hoho(call);
+    hoho << config_name;
+
+    conn.send_with_reply_and_block(call);
+}
+
+#endif
+
+
 void
 command_prepare_quota(DBus::Connection& conn, const string& config_name)
 {
@@ -644,6 +907,26 @@ command_sync(DBus::Connection& conn, const string& config_name)
 }
 
 
+vector<unsigned int>
+command_cleanup(DBus::Connection& conn, const string& config_name, const string& algorithm,
+		const map<string, string>& options, bool& cancelled)
+{
+    DBus::MessageMethodCall call(SERVICE, OBJECT, INTERFACE, "Cleanup");
+
+    DBus::Hoho hoho(call);
+    hoho << config_name << algorithm << options;
+
+    DBus::Message reply = conn.send_with_reply_and_block(call);
+
+    vector<unsigned int> nums;
+
+    DBus::Hihi hihi(reply);
+    hihi >> nums >> cancelled;
+
+    return nums;
+}
+
+
 vector<string>
 command_debug(DBus::Connection& conn)
 {
@@ -21,6 +21,8 @@
  */
 
 
+#include "config.h"
+
 #include <string>
 #include <vector>
 #include <map>
@@ -76,6 +78,11 @@ command_create_single_snapshot_of_default(DBus::Connection& conn, const string&
 					  const string& cleanup,
 					  const map<string, string>& userdata);
 
+vector<unsigned int>
+command_create_single_snapshots(DBus::Connection& conn, const vector<string>& config_names,
+				const string& description, const string& cleanup,
+				const map<string, string>& userdata);
+
 unsigned int
 command_create_pre_snapshot(DBus::Connection& conn, const string& config_name,
 			    const string& description, const string& cleanup,
@@ -102,6 +109,13 @@ command_calculate_used_space(DBus::Connection& conn, const string& config_name);
 uint64_t
 command_get_used_space(DBus::Connection& conn, const string& config_name, unsigned int num);
 
+/**
+ * Query the used space of several snapshots. The method calls are pipelined.
+ */
+vector<uint64_t>
+command_get_used_spaces(DBus::Connection& conn, const string& config_name,
+			const vector<unsigned int>& nums);
+
 string
 command_mount_snapshot(DBus::Connection& conn, const string& config_name,
 		       unsigned int num, bool user_request);
@@ -118,6 +132,11 @@ void
 command_create_comparison(DBus::Connection& conn, const string& config_name, unsigned int number1,
 			  unsigned int number2);
 
+vector<bool>
+command_are_comparisons_empty(DBus::Connection& conn, const string& config_name,
+			      const vector<unsigned int>& numbers1,
+			      const vector<unsigned int>& numbers2);
+
 void
 command_delete_comparison(DBus::Connection& conn, const string& config_name, unsigned int number1,
 			  unsigned int number2);
@@ -130,12 +149,23 @@ vector<XFile>
 command_get_xfiles_by_pipe(DBus::Connection& conn, const string& config_name, unsigned int number1,
 			   unsigned int number2);
 
+vector<XConfigSnapshots>
+command_list_all_by_pipe(DBus::Connection& conn, bool used_space);
+
+XConfigSnapshots
+command_list_snapshots_by_pipe(DBus::Connection& conn, const string& config_name);
+
 void
 command_setup_quota(DBus::Connection& conn, const string& config_name);
 
 void
 command_prepare_quota(DBus::Connection& conn, const string& config_name);
 
+#ifdef ENABLE_SELINUX
+void
+command_resync_selinux_contexts(DBus::Connection& conn, const string& config_name);
+#endif
+
 QuotaData
 command_query_quota(DBus::Connection& conn, const string& config_name);
 
@@ -145,5 +175,9 @@ command_query_free_space(DBus::Connection& conn, const string& config_name);
 void
 command_sync(DBus::Connection& conn, const string& config_name);
 
+vector<unsigned int>
+command_cleanup(DBus::Connection& conn, const string& config_name, const string& algorithm,
+		const map<string, string>& options, bool& cancelled);
+
 vector<string>
 command_debug(DBus::Connection& conn);
@@ -116,5 +116,11 @@ error_description(const DBus::ErrorException& e)
     if (name == "error.free_space")
 	return sformat(_("Free space error (%s)."), e.message());
 
+    if (name == "error.unknown_cleanup_algorithm")
+	return _("Unknown cleanup algorithm.");
+
+    if (name == "error.invalid_cleanup_option")
+	return _("Invalid cleanup option.");
+
     return sformat(_("Failure (%s)."), name.c_str());
 }
@@ -27,8 +27,8 @@
 #include <snapper/Snapper.h>
 #include <snapper/AppUtil.h>
 #include <snapper/Enum.h>
-#include "client/utils/text.h"
-#include "client/utils/GetOpts.h"
+#include "utils/text.h"
+#include "utils/GetOpts.h"
 
 
 using namespace snapper;
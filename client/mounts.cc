@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include <algorithm>
+#include <boost/algorithm/string.hpp>
+
+#include <snapper/AsciiFile.h>
+#include <snapper/Exception.h>
+
+#include "mounts.h"
+
+
+using namespace snapper;
+
+
+vector<pair<string, string>>
+read_mounts(const string& path)
+{
+    vector<pair<string, string>> mounts;
+
+    try
+    {
+	AsciiFileReader reader(path, Compression::NONE);
+
+	string line;
+	while (reader.read_line(line))
+	{
+	    vector<string> fields;
+	    boost::split(fields, line, boost::is_any_of(" "));
+
+	    // The optional fields are terminated by a single hyphen followed
+	    // by the filesystem type and the source.
+
+	    if (fields.size() < 7)
+		continue;
+
+	    vector<string>::const_iterator sep = std::find(fields.begin() + 6, fields.end(), "-");
+	    if (fields.end() - sep < 3)
+		continue;
+
+	    mounts.emplace_back(fields[4], sep[1] + " " + sep[2]);
+	}
+    }
+    catch (const Exception& e)
+    {
+	SN_CAUGHT(e);
+    }
+
+    return mounts;
+}
+
+
+string
+filesystem_id(const vector<pair<string, string>>& mounts, const string& path)
+{
+    const pair<string, string>* best = nullptr;
+
+    for (const pair<string, string>& mount : mounts)
+    {
+	const string& mount_point = mount.first;
+
+	if (mount_point != "/" && path != mount_point && !boost::starts_with(path, mount_point + "/"))
+	    continue;
+
+	if (!best || mount_point.size() >= best->first.size())
+	    best = &mount;
+    }
+
+    return best ? best->second : path;
+}
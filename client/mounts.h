@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef SNAPPER_MOUNTS_H
+#define SNAPPER_MOUNTS_H
+
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+using std::pair;
+
+
+/**
+ * Reads the mount points together with the type and source of the
+ * mounted filesystems from a mountinfo file, e.g. /proc/self/mountinfo.
+ * Errors are ignored, the result is then empty or incomplete.
+ */
+vector<pair<string, string>>
+read_mounts(const string& path);
+
+
+/**
+ * Returns an identifier for the filesystem containing path, the type and
+ * source of the mount with the longest matching mount point. For btrfs
+ * all subvolumes of a filesystem share the source. Mount points with
+ * escaped characters are not matched, the path itself is used then.
+ */
+string
+filesystem_id(const vector<pair<string, string>>& mounts, const string& path);
+
+
+#endif
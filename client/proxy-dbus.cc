@@ -20,9 +20,13 @@
  */
 
 
+#include <algorithm>
+
 #include "proxy-dbus.h"
 #include "commands.h"
 #include "utils/text.h"
+#include "proxy/cleanup.h"
+#include "snapper/SnapperTmpl.h"
 
 
 using namespace std;
@@ -57,13 +61,51 @@ void
 ProxySnapperDbus::calculateUsedSpace() const
 {
     command_calculate_used_space(conn(), config_name);
+
+    proxy_snapshots.clearUsedSpace();
+}
+
+
+void
+ProxySnapperDbus::cleanup(const string& algorithm)
+{
+    vector<unsigned int> nums;
+    bool cancelled = false;
+
+    try
+    {
+	nums = command_cleanup(conn(), config_name, algorithm, {}, cancelled);
+    }
+    catch (const DBus::ErrorException& e)
+    {
+	SN_CAUGHT(e);
+
+	// If snapper was just updated and the old snapperd is still running it might not
+	// know the Cleanup method. Then the cleanup is run here.
+
+	if (strcmp(e.name(), "error.unknown_method") != 0)
+	    SN_RETHROW(e);
+
+	do_cleanup(this, algorithm, false);
+	return;
+    }
+
+    for (unsigned int num : nums)
+    {
+	ProxySnapshots::iterator it = proxy_snapshots.find(num);
+	if (it != proxy_snapshots.end())
+	    proxy_snapshots.erase(it);
+    }
+
+    if (cancelled)
+	SN_THROW(CleanupCancelledException());
 }
 
 
 uint64_t
 ProxySnapshotDbus::getUsedSpace() const
 {
-    return command_get_used_space(conn(), configName(), num);
+    return backref->getUsedSpace(num);
 }
 
 
@@ -98,7 +140,42 @@ ProxySnapshotDbus::configName() const
 ProxySnapshotsDbus::ProxySnapshotsDbus(ProxySnapperDbus* backref)
     : backref(backref)
 {
-    XSnapshots tmp = command_list_xsnapshots(conn(), configName());
+    try
+    {
+	XConfigSnapshots x = command_list_snapshots_by_pipe(conn(), configName());
+
+	prefetched = true;
+	default_snapshot = x.default_snapshot;
+	active_snapshot = x.active_snapshot;
+
+	fill(x.snapshots);
+    }
+    catch (const DBus::ErrorException& e)
+    {
+	SN_CAUGHT(e);
+
+	// If snapper was just updated and the old snapperd is still running it might not
+	// know the ListSnapshotsByPipe method.
+
+	if (strcmp(e.name(), "error.unknown_method") != 0)
+	    SN_RETHROW(e);
+
+	fill(command_list_xsnapshots(conn(), configName()));
+    }
+}
+
+
+ProxySnapshotsDbus::ProxySnapshotsDbus(ProxySnapperDbus* backref, const XConfigSnapshots& x)
+    : backref(backref), prefetched(true), default_snapshot(x.default_snapshot),
+      active_snapshot(x.active_snapshot)
+{
+    fill(x.snapshots);
+}
+
+
+void
+ProxySnapshotsDbus::fill(const XSnapshots& tmp)
+{
     for (XSnapshots::const_iterator it = tmp.begin(); it != tmp.end(); ++it)
 	proxy_snapshots.push_back(new ProxySnapshotDbus(this, it->getType(), it->getNum(), it->getDate(),
 							it->getUid(), it->getPreNum(), it->getDescription(),
@@ -109,7 +186,8 @@ ProxySnapshotsDbus::ProxySnapshotsDbus(ProxySnapperDbus* backref)
 ProxySnapshots::const_iterator
 ProxySnapshotsDbus::getDefault() const
 {
-    pair<bool, unsigned int> tmp = command_get_default_snapshot(conn(), configName());
+    pair<bool, unsigned int> tmp = prefetched ? default_snapshot :
+	command_get_default_snapshot(conn(), configName());
 
     return tmp.first ? find(tmp.second) : end();
 }
@@ -118,7 +196,8 @@ ProxySnapshotsDbus::getDefault() const
 ProxySnapshots::iterator
 ProxySnapshotsDbus::getDefault()
 {
-    pair<bool, unsigned int> tmp = command_get_default_snapshot(conn(), configName());
+    pair<bool, unsigned int> tmp = prefetched ? default_snapshot :
+	command_get_default_snapshot(conn(), configName());
 
     return tmp.first ? find(tmp.second) : end();
 }
@@ -127,7 +206,8 @@ ProxySnapshotsDbus::getDefault()
 ProxySnapshots::iterator
 ProxySnapshotsDbus::getActive()
 {
-    pair<bool, unsigned int> tmp = command_get_active_snapshot(conn(), configName());
+    pair<bool, unsigned int> tmp = prefetched ? active_snapshot :
+	command_get_active_snapshot(conn(), configName());
 
     return tmp.first ? find(tmp.second) : end();
 }
@@ -136,12 +216,45 @@ ProxySnapshotsDbus::getActive()
 ProxySnapshots::const_iterator
 ProxySnapshotsDbus::getActive() const
 {
-    pair<bool, unsigned int> tmp = command_get_active_snapshot(conn(), configName());
+    pair<bool, unsigned int> tmp = prefetched ? active_snapshot :
+	command_get_active_snapshot(conn(), configName());
 
     return tmp.first ? find(tmp.second) : end();
 }
 
 
+uint64_t
+ProxySnapshotsDbus::getUsedSpace(unsigned int num) const
+{
+    map<unsigned int, uint64_t>::const_iterator pos = used_spaces.find(num);
+    if (pos != used_spaces.end())
+	return pos->second;
+
+    // A single lookup only queries that snapshot. Further lookups, e.g. when
+    // listing the snapshots, query all remaining snapshots at once.
+
+    vector<unsigned int> nums;
+
+    if (!used_spaces.empty())
+    {
+	for (const_iterator it = begin(); it != end(); ++it)
+	{
+	    if (!it->isCurrent() && used_spaces.find(it->getNum()) == used_spaces.end())
+		nums.push_back(it->getNum());
+	}
+    }
+
+    if (std::find(nums.begin(), nums.end(), num) == nums.end())
+	return used_spaces[num] = command_get_used_space(conn(), configName(), num);
+
+    vector<uint64_t> tmp = command_get_used_spaces(conn(), configName(), nums);
+    for (size_t i = 0; i < nums.size(); ++i)
+	used_spaces[nums[i]] = tmp[i];
+
+    return used_spaces[num];
+}
+
+
 DBus::Connection&
 ProxySnapshotsDbus::conn() const
 {
@@ -156,6 +269,12 @@ ProxySnapshotsDbus::configName() const
 }
 
 
+ProxySnapperDbus::ProxySnapperDbus(ProxySnappersDbus* backref, const XConfigSnapshots& x)
+    : backref(backref), config_name(x.config_info.config_name), proxy_snapshots(this, x)
+{
+}
+
+
 ProxyConfig
 ProxySnapperDbus::getConfig() const
 {
@@ -179,6 +298,17 @@ ProxySnapperDbus::setupQuota()
 }
 
 
+#ifdef ENABLE_SELINUX
+
+void
+ProxySnapperDbus::resyncSelinuxContexts() const
+{
+    command_resync_selinux_contexts(conn(), config_name);
+}
+
+#endif
+
+
 void
 ProxySnapperDbus::prepareQuota() const
 {
@@ -291,6 +421,21 @@ ProxySnapperDbus::createComparison(const ProxySnapshot& lhs, const ProxySnapshot
 }
 
 
+vector<bool>
+ProxySnapperDbus::areComparisonsEmpty(const vector<snapshot_pair_t>& pairs) const
+{
+    vector<unsigned int> nums1, nums2;
+
+    for (const snapshot_pair_t& pair : pairs)
+    {
+	nums1.push_back(pair.first->getNum());
+	nums2.push_back(pair.second->getNum());
+    }
+
+    return command_are_comparisons_empty(conn(), configName(), nums1, nums2);
+}
+
+
 void
 ProxySnapperDbus::syncFilesystem() const
 {
@@ -335,6 +480,78 @@ ProxySnappersDbus::getSnapper(const string& config_name)
 }
 
 
+vector<ProxySnapper*>
+ProxySnappersDbus::getSnappers(const vector<string>& config_names)
+{
+    vector<string> missing;
+
+    for (const string& config_name : config_names)
+    {
+	if (none_of(proxy_snappers.begin(), proxy_snappers.end(),
+		    [&config_name](const unique_ptr<ProxySnapperDbus>& proxy_snapper)
+		    { return proxy_snapper->config_name == config_name; }))
+	    missing.push_back(config_name);
+    }
+
+    // For several configs fetch everything with one call. Configs snapperd
+    // reports as failed are loaded individually below to get the specific
+    // error.
+
+    if (missing.size() > 1)
+    {
+	try
+	{
+	    for (const XConfigSnapshots& x : command_list_all_by_pipe(conn, false))
+	    {
+		if (!x.error && contains(missing, x.config_info.config_name))
+		    proxy_snappers.emplace_back(new ProxySnapperDbus(this, x));
+	    }
+	}
+	catch (const DBus::ErrorException& e)
+	{
+	    SN_CAUGHT(e);
+
+	    // If snapper was just updated and the old snapperd is still running it might not
+	    // know the ListAllByPipe method.
+
+	    if (strcmp(e.name(), "error.unknown_method") != 0)
+		SN_RETHROW(e);
+	}
+    }
+
+    vector<ProxySnapper*> ret;
+
+    for (const string& config_name : config_names)
+	ret.push_back(getSnapper(config_name));
+
+    return ret;
+}
+
+
+vector<ProxySnapshots::const_iterator>
+ProxySnappersDbus::createSingleSnapshots(const vector<string>& config_names, const SCD& scd)
+{
+    // Load the snapshots before creating the new ones, otherwise the new
+    // snapshots would be added twice.
+
+    vector<ProxySnapper*> tmp = getSnappers(config_names);
+
+    vector<unsigned int> nums = command_create_single_snapshots(conn, config_names, scd.description,
+								 scd.cleanup, scd.userdata);
+
+    vector<ProxySnapshots::const_iterator> ret;
+
+    for (size_t i = 0; i < tmp.size(); ++i)
+    {
+	ProxySnapshotsDbus& proxy_snapshots = dynamic_cast<ProxySnapperDbus*>(tmp[i])->proxy_snapshots;
+	proxy_snapshots.emplace_back(new ProxySnapshotDbus(&proxy_snapshots, nums[i]));
+	ret.push_back(--proxy_snapshots.end());
+    }
+
+    return ret;
+}
+
+
 map<string, ProxyConfig>
 ProxySnappersDbus::getConfigs() const
 {
@@ -27,7 +27,7 @@
 #include "dbus/DBusMessage.h"
 #include "dbus/DBusConnection.h"
 
-#include "proxy.h"
+#include "proxy/proxy.h"
 
 
 class ProxySnapshotDbus;
@@ -35,6 +35,9 @@ class ProxySnapshotsDbus;
 class ProxySnapperDbus;
 class ProxySnappersDbus;
 
+struct XSnapshots;
+struct XConfigSnapshots;
+
 
 /**
  * Concrete class of ProxySnapshot for DBus communication. Store all snapshot
@@ -93,19 +96,50 @@ public:
 
     ProxySnapshotsDbus(ProxySnapperDbus* backref);
 
+    /**
+     * Uses the snapshots and the default and active snapshot already
+     * fetched by ListAllByPipe.
+     */
+    ProxySnapshotsDbus(ProxySnapperDbus* backref, const XConfigSnapshots& x);
+
     virtual iterator getDefault() override;
     virtual const_iterator getDefault() const override;
 
     virtual iterator getActive() override;
     virtual const_iterator getActive() const override;
 
+    /**
+     * Returns the used space of the snapshot. The first call only queries
+     * the snapshot, later calls query the used space of all remaining
+     * snapshots at once.
+     */
+    uint64_t getUsedSpace(unsigned int num) const;
+
+    /**
+     * Drops the used space queried so far.
+     */
+    void clearUsedSpace() const { used_spaces.clear(); }
+
     DBus::Connection& conn() const;
     const string& configName() const;
 
 private:
 
+    void fill(const XSnapshots& x);
+
     ProxySnapperDbus* backref;
 
+    /**
+     * Whether default_snapshot and active_snapshot were fetched with the
+     * snapshots. Otherwise they are queried on every call.
+     */
+    bool prefetched = false;
+
+    std::pair<bool, unsigned int> default_snapshot;
+    std::pair<bool, unsigned int> active_snapshot;
+
+    mutable map<unsigned int, uint64_t> used_spaces;
+
 };
 
 
@@ -118,6 +152,8 @@ public:
 	: backref(backref), config_name(config_name), proxy_snapshots(this)
     {}
 
+    ProxySnapperDbus(ProxySnappersDbus* backref, const XConfigSnapshots& x);
+
     virtual const string& configName() const override { return config_name; }
 
     virtual ProxyConfig getConfig() const override;
@@ -138,6 +174,8 @@ public:
     virtual ProxyComparison createComparison(const ProxySnapshot& lhs, const ProxySnapshot& rhs,
 					     bool mount) override;
 
+    virtual vector<bool> areComparisonsEmpty(const vector<snapshot_pair_t>& pairs) const override;
+
     virtual void syncFilesystem() const override;
 
     virtual ProxySnapshots& getSnapshots() override { return proxy_snapshots; }
@@ -145,6 +183,10 @@ public:
 
     virtual void setupQuota() override;
 
+#ifdef ENABLE_SELINUX
+    virtual void resyncSelinuxContexts() const override;
+#endif
+
     virtual void prepareQuota() const override;
 
     virtual QuotaData queryQuotaData() const override;
@@ -153,6 +195,8 @@ public:
 
     virtual void calculateUsedSpace() const override;
 
+    virtual void cleanup(const string& algorithm) override;
+
     DBus::Connection& conn() const;
 
 private:
@@ -184,6 +228,11 @@ public:
 
     virtual ProxySnapper* getSnapper(const string& config_name) override;
 
+    virtual vector<ProxySnapper*> getSnappers(const vector<string>& config_names) override;
+
+    virtual vector<ProxySnapshots::const_iterator> createSingleSnapshots(const vector<string>& config_names,
+									 const SCD& scd) override;
+
     virtual map<string, ProxyConfig> getConfigs() const override;
 
     virtual vector<string> debug() const override;
@@ -36,7 +36,7 @@
 #include "utils/GetOpts.h"
 
 #include "errors.h"
-#include "proxy.h"
+#include "proxy/proxy.h"
 #include "GlobalOptions.h"
 #include "cmd.h"
 
@@ -157,6 +157,9 @@ main(int argc, char** argv)
 	Cmd("rollback", command_rollback, help_rollback, true),
 #endif
 	Cmd("setup-quota", command_setup_quota, help_setup_quota, true),
+#ifdef ENABLE_SELINUX
+	Cmd("resync-selinux", command_resync_selinux, help_resync_selinux, true),
+#endif
 	Cmd("cleanup", command_cleanup, help_cleanup, false),
 	Cmd("debug", command_debug, help_debug, false)
     };
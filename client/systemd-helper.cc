@@ -24,15 +24,21 @@
 #include "config.h"
 
 #include <stdlib.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
 #include <iostream>
+#include <algorithm>
+#include <exception>
+#include <boost/thread.hpp>
 
 #include "utils/text.h"
 #include "utils/GetOpts.h"
 
-#include "proxy.h"
-#include "cleanup.h"
+#include "proxy/proxy.h"
 #include "errors.h"
 #include "misc.h"
+#include "mounts.h"
 
 
 using namespace snapper;
@@ -43,8 +49,38 @@ using namespace std;
 // snapper-<name>.service'.
 
 
+/**
+ * Messages for one config. They are collected and printed at once so that
+ * the output of configs processed in parallel does not interleave.
+ */
+class Report
+{
+public:
+
+    void out(const string& message) { messages.emplace_back(false, message); }
+    void err(const string& message) { messages.emplace_back(true, message); }
+
+    void failed(const string& message) { err(message); ok = false; }
+
+    bool is_ok() const { return ok; }
+
+    void print() const
+    {
+	for (const pair<bool, string>& message : messages)
+	    (message.first ? cerr : cout) << message.second << endl;
+    }
+
+private:
+
+    vector<pair<bool, string>> messages;
+
+    bool ok = true;
+
+};
+
+
 bool
-call_with_error_check(std::function<void()> func)
+call_with_error_check(std::function<void()> func, std::function<void(const string&)> error)
 {
     try
     {
@@ -53,120 +89,299 @@ call_with_error_check(std::function<void()> func)
     }
     catch (const DBus::ErrorException& e)
     {
-	cerr << error_description(e) << endl;
+	error(error_description(e));
 	return false;
     }
     catch (const DBus::FatalException& e)
     {
-	cerr << "failure (" << e.what() << ")." << endl;
+	error(string("failure (") + e.what() + ").");
 	return false;
     }
 }
 
 
 bool
-timeline(ProxySnappers* snappers, const map<string, string>& userdata)
+call_with_error_check(std::function<void()> func)
 {
-    bool ok = true;
+    return call_with_error_check(func, [](const string& message) { cerr << message << endl; });
+}
+
+
+bool
+call_with_error_check(std::function<void()> func, Report& report)
+{
+    return call_with_error_check(func, [&report](const string& message) { report.err(message); });
+}
+
+
+/**
+ * Returns the names of the configs fulfilling pred grouped by filesystem.
+ */
+vector<vector<string>>
+group_configs(const map<string, ProxyConfig>& configs, std::function<bool(const ProxyConfig&)> pred)
+{
+    const vector<pair<string, string>> mounts = read_mounts("/proc/self/mountinfo");
+
+    map<string, vector<string>> tmp;
 
-    map<string, ProxyConfig> configs = snappers->getConfigs();
     for (const map<string, ProxyConfig>::value_type& value : configs)
     {
-	const ProxyConfig& proxy_config = value.second;
+	if (pred(value.second))
+	    tmp[filesystem_id(mounts, value.second.getSubvolume())].push_back(value.first);
+    }
 
-	if (!proxy_config.is_yes("TIMELINE_CREATE"))
-	    continue;
+    vector<vector<string>> groups;
+    groups.reserve(tmp.size());
+    for (map<string, vector<string>>::value_type& value : tmp)
+	groups.push_back(std::move(value.second));
 
-	cout << "running timeline for '" << value.first << "'." << endl;
+    return groups;
+}
 
-	ProxySnapper* snapper = nullptr;
 
-	if (!call_with_error_check([&snappers, &snapper, &value](){ snapper = snappers->getSnapper(value.first); }))
-	{
-	    cerr << "timeline for '" << value.first << "' failed." << endl;
+/**
+ * Load the snapshots of all configs needing work at once (with snapperd one
+ * DBus call for all configs). Errors are ignored here since they are
+ * reported for each config when the snapper is used.
+ */
+void
+prefetch_snappers(ProxySnappers* snappers, const vector<string>& config_names)
+{
+    try
+    {
+	snappers->getSnappers(config_names);
+    }
+    catch (const Exception& e)
+    {
+	SN_CAUGHT(e);
+    }
+}
+
+
+/**
+ * Runs func for all configs in groups using up to jobs threads, 0 for the
+ * number of CPUs. Each additional thread has its own connection to
+ * snapperd. The configs of a group are processed one after another by
+ * the same thread, so configs on the same filesystem do not compete, e.g.
+ * with btrfs quota rescans. The reports are printed in the order of the
+ * config names, each as soon as the reports of all previous configs are
+ * printed.
+ */
+bool
+run_configs(ProxySnappers* snappers, const vector<vector<string>>& groups, unsigned int jobs,
+	    std::function<void(ProxySnappers*, const string&, Report&)> func)
+{
+    if (jobs == 0)
+	jobs = std::max(boost::thread::hardware_concurrency(), 1U);
+
+    jobs = std::min<size_t>(jobs, groups.size());
+
+    list<ProxySnappers> more_snappers;
+    for (unsigned int i = 1; i < jobs; ++i)
+	more_snappers.push_back(ProxySnappers::createDbus());
+
+    vector<string> config_names;
+    for (const vector<string>& group : groups)
+	config_names.insert(config_names.end(), group.begin(), group.end());
+    sort(config_names.begin(), config_names.end());
+
+    vector<Report> reports(config_names.size());
+    vector<bool> done(config_names.size(), false);
+
+    boost::mutex mutex;
+    size_t next = 0;
+    size_t printed = 0;
+    bool ok = true;
+    std::exception_ptr exception;
+
+    std::function<void(size_t)> print = [&](size_t i) {
+	reports[i].print();
+
+	if (!reports[i].is_ok())
 	    ok = false;
-	    continue;
-	}
+    };
+
+    // Only the primary connection prefetches. A prefetch lists all configs
+    // in snapperd, doing that on every connection would serialize the
+    // workers. The other connections load their configs individually.
 
-	SCD scd;
-	scd.description = "timeline";
-	scd.cleanup = "timeline";
-	scd.userdata = userdata;
+    prefetch_snappers(snappers, config_names);
 
-	if (!call_with_error_check([snapper, scd](){ snapper->createSingleSnapshot(scd); }))
+    std::function<void(ProxySnappers*)> worker = [&](ProxySnappers* snappers) {
+	while (true)
 	{
-	    cerr << "timeline for '" << value.first << "' failed." << endl;
-	    ok = false;
+	    size_t i;
+
+	    {
+		boost::lock_guard<boost::mutex> lock(mutex);
+		if (next == groups.size() || exception)
+		    break;
+		i = next++;
+	    }
+
+	    try
+	    {
+		for (const string& config_name : groups[i])
+		{
+		    size_t j = lower_bound(config_names.begin(), config_names.end(), config_name) -
+			config_names.begin();
+
+		    func(snappers, config_name, reports[j]);
+
+		    boost::lock_guard<boost::mutex> lock(mutex);
+
+		    done[j] = true;
+
+		    for (; printed < done.size() && done[printed]; ++printed)
+			print(printed);
+		}
+	    }
+	    catch (...)
+	    {
+		boost::lock_guard<boost::mutex> lock(mutex);
+		if (!exception)
+		    exception = std::current_exception();
+	    }
 	}
+    };
+
+    if (more_snappers.empty())
+    {
+	worker(snappers);
+    }
+    else
+    {
+	boost::thread_group threads;
+
+	threads.create_thread(boost::bind(worker, snappers));
+	for (ProxySnappers& tmp : more_snappers)
+	    threads.create_thread(boost::bind(worker, &tmp));
+
+	threads.join_all();
+    }
+
+    // After an exception some configs are not done, print the remaining
+    // reports anyway.
+
+    for (; printed < done.size(); ++printed)
+    {
+	if (done[printed])
+	    print(printed);
     }
 
+    if (exception)
+	std::rethrow_exception(exception);
+
     return ok;
 }
 
 
-bool
-cleanup(ProxySnappers* snappers)
+void
+timeline(ProxySnappers* snappers, const string& config_name, const map<string, string>& userdata,
+	 Report& report)
 {
-    bool ok = true;
+    report.out("running timeline for '" + config_name + "'.");
 
-    map<string, ProxyConfig> configs = snappers->getConfigs();
-    for (const map<string, ProxyConfig>::value_type& value : configs)
+    ProxySnapper* snapper = nullptr;
+
+    if (!call_with_error_check([snappers, &snapper, &config_name](){ snapper = snappers->getSnapper(config_name); }, report))
     {
-	const ProxyConfig& proxy_config = value.second;
+	report.failed("timeline for '" + config_name + "' failed.");
+	return;
+    }
 
-	bool do_number = proxy_config.is_yes("NUMBER_CLEANUP");
-	bool do_timeline = proxy_config.is_yes("TIMELINE_CLEANUP");
-	bool do_empty_pre_post = proxy_config.is_yes("EMPTY_PRE_POST_CLEANUP");
+    SCD scd;
+    scd.description = "timeline";
+    scd.cleanup = "timeline";
+    scd.userdata = userdata;
 
-	if (!do_number && !do_timeline && !do_empty_pre_post)
-	    continue;
+    if (!call_with_error_check([snapper, scd](){ snapper->createSingleSnapshot(scd); }, report))
+    {
+	report.failed("timeline for '" + config_name + "' failed.");
+    }
+}
 
-	cout << "running cleanup for '" << value.first << "'." << endl;
 
-	ProxySnapper* snapper = nullptr;
+bool
+timeline(ProxySnappers* snappers, const map<string, string>& userdata, unsigned int jobs)
+{
+    map<string, ProxyConfig> configs = snappers->getConfigs();
 
-	if (!call_with_error_check([&snappers, &snapper, &value](){ snapper = snappers->getSnapper(value.first); }))
-	{
-	    cerr << "cleanup for '" << value.first << "' failed." << endl;
-	    ok = false;
-	    continue;
-	}
+    vector<vector<string>> groups = group_configs(configs, [](const ProxyConfig& proxy_config) {
+	return proxy_config.is_yes("TIMELINE_CREATE");
+    });
 
-	if (do_number)
-	{
-	    cout << "running number cleanup for '" << value.first << "'." << endl;
+    return run_configs(snappers, groups, jobs, [&userdata](ProxySnappers* snappers,
+							   const string& config_name, Report& report) {
+	timeline(snappers, config_name, userdata, report);
+    });
+}
 
-	    if (!call_with_error_check([snapper](){ do_cleanup_number(snapper, false); }))
-	    {
-		cerr << "number cleanup for '" << value.first << "' failed." << endl;
-		ok = false;
-	    }
-	}
 
-	if (do_timeline)
-	{
-	    cout << "running timeline cleanup for '" << value.first << "'." << endl;
+void
+cleanup(ProxySnappers* snappers, const string& config_name, const ProxyConfig& proxy_config,
+	Report& report)
+{
+    bool do_number = proxy_config.is_yes("NUMBER_CLEANUP");
+    bool do_timeline = proxy_config.is_yes("TIMELINE_CLEANUP");
+    bool do_empty_pre_post = proxy_config.is_yes("EMPTY_PRE_POST_CLEANUP");
 
-	    if (!call_with_error_check([snapper](){ do_cleanup_timeline(snapper, false); }))
-	    {
-		cerr << "timeline cleanup for '" << value.first << "' failed." << endl;
-		ok = false;
-	    }
+    report.out("running cleanup for '" + config_name + "'.");
+
+    ProxySnapper* snapper = nullptr;
+
+    if (!call_with_error_check([snappers, &snapper, &config_name](){ snapper = snappers->getSnapper(config_name); }, report))
+    {
+	report.failed("cleanup for '" + config_name + "' failed.");
+	return;
+    }
+
+    if (do_number)
+    {
+	report.out("running number cleanup for '" + config_name + "'.");
+
+	if (!call_with_error_check([snapper](){ snapper->cleanup("number"); }, report))
+	{
+	    report.failed("number cleanup for '" + config_name + "' failed.");
 	}
+    }
+
+    if (do_timeline)
+    {
+	report.out("running timeline cleanup for '" + config_name + "'.");
 
-	if (do_empty_pre_post)
+	if (!call_with_error_check([snapper](){ snapper->cleanup("timeline"); }, report))
 	{
-	    cout << "running empty-pre-post cleanup for '" << value.first << "'." << endl;
+	    report.failed("timeline cleanup for '" + config_name + "' failed.");
+	}
+    }
 
-	    if (!call_with_error_check([snapper](){ do_cleanup_empty_pre_post(snapper, false); }))
-	    {
-		cerr << "empty-pre-post cleanup for " << value.first << " failed." << endl;
-		ok = false;
-	    }
+    if (do_empty_pre_post)
+    {
+	report.out("running empty-pre-post cleanup for '" + config_name + "'.");
+
+	if (!call_with_error_check([snapper](){ snapper->cleanup("empty-pre-post"); }, report))
+	{
+	    report.failed("empty-pre-post cleanup for " + config_name + " failed.");
 	}
     }
+}
 
-    return ok;
+
+bool
+cleanup(ProxySnappers* snappers, unsigned int jobs)
+{
+    map<string, ProxyConfig> configs = snappers->getConfigs();
+
+    vector<vector<string>> groups = group_configs(configs, [](const ProxyConfig& proxy_config) {
+	return proxy_config.is_yes("NUMBER_CLEANUP") || proxy_config.is_yes("TIMELINE_CLEANUP") ||
+	    proxy_config.is_yes("EMPTY_PRE_POST_CLEANUP");
+    });
+
+    return run_configs(snappers, groups, jobs, [&configs](ProxySnappers* snappers,
+							  const string& config_name, Report& report) {
+	cleanup(snappers, config_name, configs.at(config_name), report);
+    });
 }
 
 
@@ -178,13 +393,15 @@ main(int argc, char** argv)
     bool do_timeline = false;
     bool do_cleanup = false;
     map<string, string> userdata;
+    unsigned int jobs = 0;
 
     try
     {
 	const vector<Option> options = {
 	    Option("timeline",		no_argument),
 	    Option("cleanup",		no_argument),
-	    Option("userdata",		required_argument,	'u')
+	    Option("userdata",		required_argument,	'u'),
+	    Option("jobs",		required_argument,	'j')
 	};
 
 	GetOpts get_opts(argc, argv);
@@ -201,6 +418,22 @@ main(int argc, char** argv)
 
 	if ((opt = opts.find("userdata")) != opts.end())
 	    userdata = read_userdata(opt->second);
+
+	if ((opt = opts.find("jobs")) != opts.end())
+	{
+	    // strtoul also accepts leading whitespace and signs
+
+	    const char* arg = opt->second.c_str();
+	    char* end;
+	    errno = 0;
+	    unsigned long tmp = strtoul(arg, &end, 10);
+	    if (!isdigit(*arg) || *end != '\0' || errno == ERANGE || tmp > UINT_MAX)
+	    {
+		string error = sformat(_("Invalid number of jobs '%s'."), opt->second.c_str());
+		SN_THROW(OptionsException(error));
+	    }
+	    jobs = tmp;
+	}
     }
     catch (const OptionsException& e)
     {
@@ -209,18 +442,21 @@ main(int argc, char** argv)
 	exit(EXIT_FAILURE);
     }
 
+    // with jobs several threads use their own connection to snapperd
+    dbus_threads_init_default();
+
     bool ok = true;
 
-    if (!call_with_error_check([do_timeline, do_cleanup, userdata, &ok]() {
+    if (!call_with_error_check([do_timeline, do_cleanup, userdata, jobs, &ok]() {
 
 	ProxySnappers snappers(ProxySnappers::createDbus());
 
 	if (do_timeline)
-	    if (!timeline(&snappers, userdata))
+	    if (!timeline(&snappers, userdata, jobs))
 		ok = false;
 
 	if (do_cleanup)
-	    if (!cleanup(&snappers))
+	    if (!cleanup(&snappers, jobs))
 		ok = false;
 
     }))
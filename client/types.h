@@ -28,6 +28,7 @@
 using std::string;
 using std::vector;
 using std::map;
+using std::pair;
 
 #include "dbus/DBusMessage.h"
 #include "dbus/DBusConnection.h"
@@ -88,6 +89,26 @@ struct XSnapshots
 };
 
 
+/**
+ * A config together with its snapshots as transferred by ListAllByPipe. If
+ * error is set the config could not be accessed or loaded by snapperd and
+ * only config_info is valid.
+ */
+struct XConfigSnapshots
+{
+    XConfigInfo config_info;
+
+    bool error;
+
+    pair<bool, unsigned int> default_snapshot;
+    pair<bool, unsigned int> active_snapshot;
+
+    XSnapshots snapshots;
+
+    map<unsigned int, uint64_t> used_spaces;
+};
+
+
 struct XFile
 {
     string name;
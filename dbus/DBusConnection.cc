@@ -49,8 +49,41 @@ namespace DBus
     }
 
 
+    Connection::Connection(const string& address)
+	: private_connection(true)
+    {
+	DBusError err;
+	dbus_error_init(&err);
+
+	conn = dbus_connection_open_private(address.c_str(), &err);
+	if (dbus_error_is_set(&err))
+	{
+	    dbus_error_free(&err);
+	    throw FatalException();
+	}
+
+	if (!conn)
+	{
+	    throw FatalException();
+	}
+
+	dbus_connection_set_exit_on_disconnect(conn, false);
+
+	if (!dbus_bus_register(conn, &err))
+	{
+	    dbus_error_free(&err);
+	    dbus_connection_close(conn);
+	    dbus_connection_unref(conn);
+	    throw FatalException();
+	}
+    }
+
+
     Connection::~Connection()
     {
+	if (private_connection)
+	    dbus_connection_close(conn);
+
 	dbus_connection_unref(conn);
     }
 
@@ -108,6 +141,82 @@ namespace DBus
     }
 
 
+    PendingCall
+    Connection::send_with_reply(Message& m)
+    {
+	boost::lock_guard<boost::mutex> lock(mutex);
+
+	DBusPendingCall* pending = nullptr;
+
+	if (!dbus_connection_send_with_reply(conn, m.get_message(), &pending, 0x7fffffff) ||
+	    !pending)
+	{
+	    throw FatalException();
+	}
+
+	return PendingCall(this, pending);
+    }
+
+
+    PendingCall::PendingCall(Connection* connection, DBusPendingCall* pending)
+	: connection(connection), pending(pending)
+    {
+    }
+
+
+    PendingCall::PendingCall(PendingCall&& pending_call)
+	: connection(pending_call.connection), pending(pending_call.pending)
+    {
+	pending_call.pending = nullptr;
+    }
+
+
+    PendingCall::~PendingCall()
+    {
+	if (pending)
+	{
+	    boost::lock_guard<boost::mutex> lock(connection->mutex);
+
+	    dbus_pending_call_cancel(pending);
+	    dbus_pending_call_unref(pending);
+	}
+    }
+
+
+    Message
+    PendingCall::get_reply()
+    {
+	if (!pending)
+	    throw FatalException();
+
+	boost::lock_guard<boost::mutex> lock(connection->mutex);
+
+	dbus_pending_call_block(pending);
+
+	DBusMessage* tmp = dbus_pending_call_steal_reply(pending);
+
+	dbus_pending_call_unref(pending);
+	pending = nullptr;
+
+	if (!tmp)
+	{
+	    throw FatalException();
+	}
+
+	Message reply(tmp, false);
+
+	DBusError err;
+	dbus_error_init(&err);
+
+	if (dbus_set_error_from_message(&err, tmp))
+	{
+	    throw ErrorException(err);
+	}
+
+	return reply;
+    }
+
+
     void
     Connection::add_match(const char* rule)
     {
@@ -35,11 +35,49 @@
 namespace DBus
 {
 
+    class Connection;
+
+
+    /**
+     * A method call sent with Connection::send_with_reply(). get_reply()
+     * blocks until the reply is available. The replies of several pending
+     * calls can be collected in any order.
+     */
+    class PendingCall : private boost::noncopyable
+    {
+    public:
+
+	PendingCall(Connection* connection, DBusPendingCall* pending);
+	PendingCall(PendingCall&& pending_call);
+	~PendingCall();
+
+	/**
+	 * Returns the reply. Throws ErrorException if the reply is an error.
+	 * Can only be called once.
+	 */
+	Message get_reply();
+
+    private:
+
+	Connection* connection;
+
+	DBusPendingCall* pending;
+
+    };
+
+
     class Connection : private boost::noncopyable
     {
     public:
 
 	Connection(DBusBusType type);
+
+	/**
+	 * Connects to the bus at address with a private connection, e.g.
+	 * for testing.
+	 */
+	Connection(const string& address);
+
 	~Connection();
 
 	void request_name(const char* name, unsigned int flags);
@@ -48,6 +86,13 @@ namespace DBus
 
 	Message send_with_reply_and_block(Message& m);
 
+	/**
+	 * Sends the message without waiting for the reply. This allows to
+	 * send several independent method calls before collecting the
+	 * replies.
+	 */
+	PendingCall send_with_reply(Message& m);
+
 	void add_match(const char* rule);
 	void remove_match(const char* rule);
 
@@ -56,6 +101,8 @@ namespace DBus
 
 	uid_t get_unix_userid(const Message& m);
 
+	friend class PendingCall;
+
     protected:
 
 	// Without locking the connection manually the server sometimes does
@@ -65,6 +112,8 @@ namespace DBus
 
 	DBusConnection* conn;
 
+	bool private_connection = false;
+
 	DBusMessage* pop_message();
 
     };
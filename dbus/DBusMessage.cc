@@ -23,6 +23,7 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "DBusMessage.h"
 
@@ -65,66 +66,74 @@ namespace DBus
     }
 
 
+    const char* TypeInfo<bool>::signature = "b";
     const char* TypeInfo<dbus_uint32_t>::signature = "u";
     const char* TypeInfo<dbus_uint64_t>::signature = "t";
     const char* TypeInfo<string>::signature = "s";
 
 
+    DBusMessageIter*
+    Marshalling::next()
+    {
+	if (depth == sizeof(iters) / sizeof(iters[0]))
+	    throw FatalException();
+
+	return &iters[depth];
+    }
+
+
     Hihi::Hihi(Message& msg)
     {
-	iters.push_back(new DBusMessageIter());
-	if (!dbus_message_iter_init(msg.get_message(), top()))
+	if (!dbus_message_iter_init(msg.get_message(), next()))
 	    throw FatalException();
+	++depth;
     }
 
 
     Hihi::~Hihi()
     {
-	delete iters.back();
-	iters.pop_back();
-	assert(iters.empty());
+	--depth;
+	assert(depth == 0);
     }
 
 
     void
     Hihi::open_recurse()
     {
-	DBusMessageIter* iter2 = new DBusMessageIter();
+	DBusMessageIter* iter2 = next();
 	dbus_message_iter_recurse(top(), iter2);
-	iters.push_back(iter2);
+	++depth;
     }
 
 
     void
     Hihi::close_recurse()
     {
-	delete iters.back();
-	iters.pop_back();
+	--depth;
 	dbus_message_iter_next(top());
     }
 
 
     Hoho::Hoho(Message& msg)
     {
-	iters.push_back(new DBusMessageIter());
-	dbus_message_iter_init_append(msg.get_message(), top());
+	dbus_message_iter_init_append(msg.get_message(), next());
+	++depth;
     }
 
 
     Hoho::~Hoho()
     {
-	delete iters.back();
-	iters.pop_back();
-	assert(iters.empty());
+	--depth;
+	assert(depth == 0);
     }
 
     void
     Hoho::open_struct()
     {
-	DBusMessageIter* iter2 = new DBusMessageIter();
+	DBusMessageIter* iter2 = next();
 	if (!dbus_message_iter_open_container(top(), DBUS_TYPE_STRUCT, NULL, iter2))
 	    throw FatalException();
-	iters.push_back(iter2);
+	++depth;
     }
 
 
@@ -132,20 +141,19 @@ namespace DBus
     Hoho::close_struct()
     {
 	DBusMessageIter* iter2 = top();
-	iters.pop_back();
+	--depth;
 	if (!dbus_message_iter_close_container(top(), iter2))
 	    throw FatalException();
-	delete iter2;
     }
 
 
     void
     Hoho::open_array(const char* signature)
     {
-	DBusMessageIter* iter2 = new DBusMessageIter();
+	DBusMessageIter* iter2 = next();
 	if (!dbus_message_iter_open_container(top(), DBUS_TYPE_ARRAY, signature, iter2))
 	    throw FatalException();
-	iters.push_back(iter2);
+	++depth;
     }
 
 
@@ -153,20 +161,19 @@ namespace DBus
     Hoho::close_array()
     {
 	DBusMessageIter* iter2 = top();
-	iters.pop_back();
+	--depth;
 	if (!dbus_message_iter_close_container(top(), iter2))
 	    throw FatalException();
-	delete iter2;
     }
 
 
     void
     Hoho::open_dict_entry()
     {
-	DBusMessageIter* iter2 = new DBusMessageIter();
+	DBusMessageIter* iter2 = next();
 	if (!dbus_message_iter_open_container(top(), DBUS_TYPE_DICT_ENTRY, 0, iter2))
 	    throw FatalException();
-	iters.push_back(iter2);
+	++depth;
     }
 
 
@@ -174,10 +181,9 @@ namespace DBus
     Hoho::close_dict_entry()
     {
 	DBusMessageIter* iter2 = top();
-	iters.pop_back();
+	--depth;
 	if (!dbus_message_iter_close_container(top(), iter2))
 	    throw FatalException();
-	delete iter2;
     }
 
 
@@ -312,10 +318,27 @@ namespace DBus
     }
 
 
+    static int
+    hex_value(char c)
+    {
+	if (c >= '0' && c <= '9')
+	    return c - '0';
+	if (c >= 'a' && c <= 'f')
+	    return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+	    return c - 'A' + 10;
+	return -1;
+    }
+
+
     string
     Hihi::unescape(const string& in)
     {
+	if (in.find('\\') == string::npos)
+	    return in;
+
 	string out;
+	out.reserve(in.size());
 
 	for (string::const_iterator it = in.begin(); it != in.end(); ++it)
 	{
@@ -330,17 +353,16 @@ namespace DBus
 		}
 		else if (*it == 'x')
 		{
-		    string t1;
+		    unsigned int t = 0;
 		    for (int i = 0; i < 2; ++i)
 		    {
-			if (++it == in.end() || !isxdigit(*it))
+			int v;
+			if (++it == in.end() || (v = hex_value(*it)) < 0)
 			    throw MarshallingException();
-			t1 += *it;
+			t = t * 16 + v;
 		    }
 
-		    unsigned int t2;
-		    sscanf(t1.c_str(), "%x", &t2);
-		    out.append(1, (unsigned char)(t2));
+		    out += (char)(t);
 		}
 		else
 		{
@@ -366,16 +388,39 @@ namespace DBus
 	const char* p = NULL;
 	dbus_message_iter_get_basic(hihi.top(), &p);
 	dbus_message_iter_next(hihi.top());
-	data = hihi.unescape(p);
+
+	// most strings contain no escapes, avoid the temporary copy
+
+	if (strchr(p, '\\'))
+	    data = hihi.unescape(p);
+	else
+	    data.assign(p);
 
 	return hihi;
     }
 
 
+    static bool
+    needs_escape(const string& in)
+    {
+	for (const char c : in)
+	    if (c == '\\' || (unsigned char)(c) > 127)
+		return true;
+
+	return false;
+    }
+
+
     string
     Hoho::escape(const string& in)
     {
+	if (!needs_escape(in))
+	    return in;
+
+	static const char hex[] = "0123456789abcdef";
+
 	string out;
+	out.reserve(in.size() + 16);
 
 	for (const char c : in)
 	{
@@ -385,9 +430,8 @@ namespace DBus
 	    }
 	    else if ((unsigned char)(c) > 127)
 	    {
-		char s[5];
-		snprintf(s, 5, "\\x%02x", (unsigned char)(c));
-		out += string(s);
+		const char s[4] = { '\\', 'x', hex[(unsigned char)(c) >> 4], hex[c & 0x0f] };
+		out.append(s, 4);
 	    }
 	    else
 	    {
@@ -402,8 +446,17 @@ namespace DBus
     Hoho&
     operator<<(Hoho& hoho, const string& data)
     {
-	string tmp = hoho.escape(data);
-	const char* p = tmp.c_str();
+	// most strings need no escaping, avoid the temporary copy
+
+	string tmp;
+	const char* p = data.c_str();
+
+	if (needs_escape(data))
+	{
+	    tmp = hoho.escape(data);
+	    p = tmp.c_str();
+	}
+
 	if (!dbus_message_iter_append_basic(hoho.top(), DBUS_TYPE_STRING, &p))
 	    throw FatalException();
 
@@ -164,6 +164,7 @@ namespace DBus
 
     template <typename Type> struct TypeInfo {};
 
+    template <> struct TypeInfo<bool> { static const char* signature; };
     template <> struct TypeInfo<dbus_uint32_t> { static const char* signature; };
     template <> struct TypeInfo<dbus_uint64_t> { static const char* signature; };
     template <> struct TypeInfo<string> { static const char* signature; };
@@ -174,14 +175,21 @@ namespace DBus
 
     public:
 
-	DBusMessageIter* top() { return iters.back(); }
+	DBusMessageIter* top() { return &iters[depth - 1]; }
 
 	int get_type() { return dbus_message_iter_get_arg_type(top()); }
 	string get_signature() { return dbus_message_iter_get_signature(top()); }
 
     protected:
 
-	vector<DBusMessageIter*> iters;
+	DBusMessageIter* next();
+
+	// libdbus limits the nesting of containers. The iterators are kept
+	// inline to avoid an allocation for every container and since open
+	// iterators must not move.
+
+	DBusMessageIter iters[DBUS_MAXIMUM_TYPE_RECURSION_DEPTH + 1];
+	unsigned int depth = 0;
 
     };
 
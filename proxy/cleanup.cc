@@ -23,15 +23,16 @@
 
 #include <iostream>
 #include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
 
-#include "dbus/DBusMessage.h"
-#include "dbus/DBusConnection.h"
 #include "snapper/SnapperTmpl.h"
 #include "snapper/Snapper.h"
 
 #include "utils/Range.h"
 #include "utils/Limit.h"
-#include "utils/equal-date.h"
+#include "utils/Timeline.h"
 #include "utils/HumanString.h"
 #include "cleanup.h"
 
@@ -118,6 +119,11 @@ protected:
     virtual list<ProxySnapshots::iterator> calculate_candidates(ProxySnapshots& snapshots,
 								const Range::Value& value) = 0;
 
+    // Does removing candidates leave the candidates of the remaining
+    // snapshots unchanged? If so the cleanup with a condition calculates
+    // the candidates only once instead of after every removal.
+    virtual bool are_candidates_stable(const ProxySnapshots& snapshots) const { return false; }
+
     struct younger_than
     {
 	younger_than(time_t t)
@@ -139,6 +145,18 @@ protected:
     // snapshot but which is not included in tmp.
     void filter_pre_post(ProxySnapshots& snapshots, list<ProxySnapshots::iterator>& tmp) const;
 
+    // Returns the post snapshot for every pre snapshot and the pre snapshot
+    // for every post snapshot, as findPost and findPre do.
+    map<unsigned int, ProxySnapshots::iterator> find_partners(ProxySnapshots& snapshots) const;
+
+    // Splits the candidates into the lists removed one after the other by
+    // the cleanup with a condition, each being the result of filtering the
+    // shortest prefix of the remaining candidates with a non-empty
+    // result. Returns false if pre and post snapshots are not paired
+    // uniquely.
+    bool calculate_removals(ProxySnapshots& snapshots, const list<ProxySnapshots::iterator>& candidates,
+			    vector<list<ProxySnapshots::iterator>>& removals) const;
+
     void remove(const list<ProxySnapshots::iterator>& tmp);
 
     // Should the cleanup with quota space be run?
@@ -208,34 +226,120 @@ Cleaner::filter_min_age(ProxySnapshots& snapshots, list<ProxySnapshots::iterator
 void
 Cleaner::filter_pre_post(ProxySnapshots& snapshots, list<ProxySnapshots::iterator>& tmp) const
 {
+    const map<unsigned int, ProxySnapshots::iterator> partners = find_partners(snapshots);
+
+    set<unsigned int> nums;
+    for (ProxySnapshots::iterator it : tmp)
+	nums.insert(it->getNum());
+
     list<ProxySnapshots::iterator> ret;
 
     for (list<ProxySnapshots::iterator>::iterator it1 = tmp.begin(); it1 != tmp.end(); ++it1)
     {
-	if ((*it1)->getType() == PRE)
+	map<unsigned int, ProxySnapshots::iterator>::const_iterator it2 = partners.find((*it1)->getNum());
+	if (it2 != partners.end())
 	{
-	    ProxySnapshots::const_iterator it2 = snapshots.findPost(*it1);
-	    if (it2 != snapshots.end())
-	    {
-		if (find(tmp.begin(), tmp.end(), it2) == tmp.end())
-		    continue;
-	    }
+	    if (nums.find(it2->second->getNum()) == nums.end())
+		continue;
 	}
 
-	if ((*it1)->getType() == POST)
+	ret.push_back(*it1);
+    }
+
+    swap(ret, tmp);
+}
+
+
+map<unsigned int, ProxySnapshots::iterator>
+Cleaner::find_partners(ProxySnapshots& snapshots) const
+{
+    map<unsigned int, ProxySnapshots::iterator> pres;
+    map<unsigned int, ProxySnapshots::iterator> posts;
+
+    for (ProxySnapshots::iterator it = snapshots.begin(); it != snapshots.end(); ++it)
+    {
+	if (it->getType() == PRE)
+	    pres.emplace(it->getNum(), it);
+	else if (it->getType() == POST)
+	    posts.emplace(it->getPreNum(), it);
+    }
+
+    map<unsigned int, ProxySnapshots::iterator> ret;
+
+    for (const map<unsigned int, ProxySnapshots::iterator>::value_type& value : pres)
+    {
+	map<unsigned int, ProxySnapshots::iterator>::const_iterator it = posts.find(value.first);
+	if (it != posts.end())
+	    ret.emplace(value.first, it->second);
+    }
+
+    for (ProxySnapshots::iterator it1 = snapshots.begin(); it1 != snapshots.end(); ++it1)
+    {
+	if (it1->getType() == POST)
 	{
-	    ProxySnapshots::const_iterator it2 = snapshots.findPre(*it1);
-	    if (it2 != snapshots.end())
-	    {
-		if (find(tmp.begin(), tmp.end(), it2) == tmp.end())
-		    continue;
-	    }
+	    map<unsigned int, ProxySnapshots::iterator>::const_iterator it2 = pres.find(it1->getPreNum());
+	    if (it2 != pres.end())
+		ret.emplace(it1->getNum(), it2->second);
 	}
+    }
 
-	ret.push_back(*it1);
+    return ret;
+}
+
+
+bool
+Cleaner::calculate_removals(ProxySnapshots& snapshots, const list<ProxySnapshots::iterator>& candidates,
+			    vector<list<ProxySnapshots::iterator>>& removals) const
+{
+    const map<unsigned int, ProxySnapshots::iterator> partners = find_partners(snapshots);
+
+    // the filters not depending on other candidates are applied only once
+
+    list<ProxySnapshots::iterator> tmp = candidates;
+    filter_undeletables(snapshots, tmp);
+    filter_min_age(snapshots, tmp);
+
+    map<unsigned int, size_t> positions;
+    for (ProxySnapshots::iterator it : tmp)
+	positions.emplace(it->getNum(), positions.size());
+
+    // a pre or post snapshot is removed together with its partner as soon
+    // as the prefix includes both, so it belongs to the removal at the
+    // position of the later one
+
+    vector<list<ProxySnapshots::iterator>> tmp2(tmp.size());
+
+    for (ProxySnapshots::iterator it1 : tmp)
+    {
+	size_t position = positions[it1->getNum()];
+
+	map<unsigned int, ProxySnapshots::iterator>::const_iterator it2 = partners.find(it1->getNum());
+	if (it2 != partners.end())
+	{
+	    map<unsigned int, ProxySnapshots::iterator>::const_iterator it3 =
+		partners.find(it2->second->getNum());
+	    if (it3 == partners.end() || it3->second != it1)
+		return false;
+
+	    map<unsigned int, size_t>::const_iterator it4 = positions.find(it2->second->getNum());
+	    if (it4 == positions.end())
+		continue;
+
+	    position = max(position, it4->second);
+	}
+
+	tmp2[position].push_back(it1);
     }
 
-    swap(ret, tmp);
+    removals.clear();
+
+    for (list<ProxySnapshots::iterator>& removal : tmp2)
+    {
+	if (!removal.empty())
+	    removals.push_back(std::move(removal));
+    }
+
+    return true;
 }
 
 
@@ -347,7 +451,50 @@ Cleaner::cleanup(ProxySnapshots& snapshots)
 void
 Cleaner::cleanup(ProxySnapshots& snapshots, std::function<bool()> condition)
 {
-    while (!condition())
+    if (condition())
+    {
+#ifdef VERBOSE_LOGGING
+	cout << "condition satisfied" << '\n';
+#endif
+
+	return;
+    }
+
+    if (are_candidates_stable(snapshots))
+    {
+	// the order of removal is known upfront, only the condition must be
+	// reevaluated after every removal
+
+	list<ProxySnapshots::iterator> candidates = calculate_candidates(snapshots, Range::MIN);
+
+	vector<list<ProxySnapshots::iterator>> removals;
+	if (calculate_removals(snapshots, candidates, removals))
+	{
+	    for (const list<ProxySnapshots::iterator>& removal : removals)
+	    {
+		remove(removal);
+
+		if (condition())
+		{
+#ifdef VERBOSE_LOGGING
+		    cout << "condition satisfied" << '\n';
+#endif
+
+		    return;
+		}
+	    }
+
+	    // not enough candidates to satisfy the condition
+
+#ifdef VERBOSE_LOGGING
+	    cout << "condition not satisfied" << '\n';
+#endif
+
+	    return;
+	}
+    }
+
+    do
     {
 	list<ProxySnapshots::iterator> candidates = calculate_candidates(snapshots, Range::MIN);
 	if (candidates.empty())
@@ -392,6 +539,7 @@ Cleaner::cleanup(ProxySnapshots& snapshots, std::function<bool()> condition)
 	    }
 	}
     }
+    while (!condition());
 
 #ifdef VERBOSE_LOGGING
     cout << "condition satisfied" << '\n';
@@ -558,6 +706,15 @@ private:
 
 	return ret;
     }
+
+
+    // Removing a candidate changes neither the number of snapshots kept
+    // due to the limit nor the important snapshots kept.
+    bool
+    are_candidates_stable(const ProxySnapshots& snapshots) const override
+    {
+	return true;
+    }
 };
 
 
@@ -643,136 +800,65 @@ public:
 
 private:
 
-    bool
-    is_first(list<ProxySnapshots::iterator>::const_iterator first,
-	     list<ProxySnapshots::iterator>::const_iterator last,
-	     ProxySnapshots::const_iterator it1,
-	     std::function<bool(const struct tm& tmp1, const struct tm& tmp2)> pred)
+    list<ProxySnapshots::iterator>
+    calculate_candidates(ProxySnapshots& snapshots, const Range::Value& value) override
     {
-	time_t t1 = it1->getDate();
-	struct tm tmp1;
-	localtime_r(&t1, &tmp1);
-
-	for (list<ProxySnapshots::iterator>::const_iterator it2 = first; it2 != last; ++it2)
-	{
-	    if (it1 == *it2)
-		continue;
-
-	    time_t t2 = (*it2)->getDate();
-	    struct tm tmp2;
-	    localtime_r(&t2, &tmp2);
+	const TimelineParameters& parameters = dynamic_cast<const TimelineParameters&>(Cleaner::parameters);
 
-	    if (!pred(tmp1, tmp2))
-		return true;
+	vector<ProxySnapshots::iterator> tmp;
+	vector<time_t> dates;
 
-	    if (t1 > t2)
-		return false;
+	for (ProxySnapshots::iterator it = snapshots.begin(); it != snapshots.end(); ++it)
+	{
+	    if (it->getCleanup() == "timeline")
+		tmp.push_back(it);
 	}
 
-	return true;
-    }
+	reverse(tmp.begin(), tmp.end());
 
+	for (ProxySnapshots::iterator it : tmp)
+	    dates.push_back(it->getDate());
 
-    bool
-    is_first_yearly(list<ProxySnapshots::iterator>::const_iterator first,
-		    list<ProxySnapshots::iterator>::const_iterator last,
-		    ProxySnapshots::const_iterator it1)
-    {
-	return is_first(first, last, it1, equal_year);
-    }
+	TimelineLimits limits = { parameters.limit_hourly.value(value), parameters.limit_daily.value(value),
+	    parameters.limit_weekly.value(value), parameters.limit_monthly.value(value),
+	    parameters.limit_yearly.value(value) };
 
-    bool
-    is_first_monthly(list<ProxySnapshots::iterator>::const_iterator first,
-		     list<ProxySnapshots::iterator>::const_iterator last,
-		     ProxySnapshots::const_iterator it1)
-    {
-	return is_first(first, last, it1, equal_month);
-    }
+	vector<bool> keep = timeline_keep(dates, limits);
 
-    bool
-    is_first_weekly(list<ProxySnapshots::iterator>::const_iterator first,
-		    list<ProxySnapshots::iterator>::const_iterator last,
-		    ProxySnapshots::const_iterator it1)
-    {
-	return is_first(first, last, it1, equal_week);
-    }
+	list<ProxySnapshots::iterator> ret;
 
-    bool
-    is_first_daily(list<ProxySnapshots::iterator>::const_iterator first,
-		   list<ProxySnapshots::iterator>::const_iterator last,
-		   ProxySnapshots::const_iterator it1)
-    {
-	return is_first(first, last, it1, equal_day);
-    }
+	for (size_t i = 0; i < tmp.size(); ++i)
+	{
+	    if (!keep[i])
+		ret.push_front(tmp[i]);
+	}
 
-    bool
-    is_first_hourly(list<ProxySnapshots::iterator>::const_iterator first,
-		    list<ProxySnapshots::iterator>::const_iterator last,
-		    ProxySnapshots::const_iterator it1)
-    {
-	return is_first(first, last, it1, equal_hour);
+	return ret;
     }
 
 
-    list<ProxySnapshots::iterator>
-    calculate_candidates(ProxySnapshots& snapshots, const Range::Value& value) override
+    // With dates increasing with the number, removing a candidate can only
+    // make a snapshot the first of a period in place of the candidate,
+    // thus without exceeding the limit.
+    bool
+    are_candidates_stable(const ProxySnapshots& snapshots) const override
     {
-	const TimelineParameters& parameters = dynamic_cast<const TimelineParameters&>(Cleaner::parameters);
+	bool first = true;
+	time_t last = 0;
 
-	list<ProxySnapshots::iterator> ret;
-
-	for (ProxySnapshots::iterator it = snapshots.begin(); it != snapshots.end(); ++it)
+	for (ProxySnapshots::const_iterator it = snapshots.begin(); it != snapshots.end(); ++it)
 	{
-	    if (it->getCleanup() == "timeline")
-		ret.push_front(it);
-	}
-
-	size_t num_hourly = 0;
-	size_t num_daily = 0;
-	size_t num_weekly = 0;
-	size_t num_monthly = 0;
-	size_t num_yearly = 0;
-
-	list<ProxySnapshots::iterator>::iterator it = ret.begin();
-	while (it != ret.end())
-	{
-	    bool keep = false;
+	    if (it->getCleanup() != "timeline")
+		continue;
 
-	    if (num_hourly < parameters.limit_hourly.value(value) && is_first_hourly(it, ret.end(), *it))
-	    {
-		++num_hourly;
-		keep = true;
-	    }
-	    if (num_daily < parameters.limit_daily.value(value) && is_first_daily(it, ret.end(), *it))
-	    {
-		++num_daily;
-		keep = true;
-	    }
-	    if (num_weekly < parameters.limit_weekly.value(value) && is_first_weekly(it, ret.end(), *it))
-	    {
-		++num_weekly;
-		keep = true;
-	    }
-	    if (num_monthly < parameters.limit_monthly.value(value) && is_first_monthly(it, ret.end(), *it))
-	    {
-		++num_monthly;
-		keep = true;
-	    }
-	    if (num_yearly < parameters.limit_yearly.value(value) && is_first_yearly(it, ret.end(), *it))
-	    {
-		++num_yearly;
-		keep = true;
-	    }
+	    if (!first && last >= it->getDate())
+		return false;
 
-	    if (keep)
-		it = ret.erase(it);
-	    else
-		++it;
+	    first = false;
+	    last = it->getDate();
 	}
 
-	ret.reverse();
-
-	return ret;
+	return true;
     }
 };
 
@@ -829,6 +915,9 @@ private:
     {
 	list<ProxySnapshots::iterator> ret;
 
+	vector<pair<ProxySnapshots::iterator, ProxySnapshots::iterator>> candidates;
+	vector<ProxySnapper::snapshot_pair_t> pairs;
+
 	for (ProxySnapshots::iterator it1 = snapshots.begin(); it1 != snapshots.end(); ++it1)
 	{
 	    if (it1->getType() == PRE)
@@ -836,18 +925,36 @@ private:
 		ProxySnapshots::iterator it2 = snapshots.findPost(it1);
 		if (it2 != snapshots.end())
 		{
-		    ProxyComparison comparison = snapper->createComparison(*it1, *it2, false);
-		    if (comparison.getFiles().empty())
-		    {
-			ret.push_back(it1);
-			ret.push_back(it2);
-		    }
+		    candidates.emplace_back(it1, it2);
+		    pairs.emplace_back(it1, it2);
 		}
 	    }
 	}
 
+	if (pairs.empty())
+	    return ret;
+
+	vector<bool> empty = snapper->areComparisonsEmpty(pairs);
+
+	for (size_t i = 0; i < candidates.size(); ++i)
+	{
+	    if (empty[i])
+	    {
+		ret.push_back(candidates[i].first);
+		ret.push_back(candidates[i].second);
+	    }
+	}
+
 	return ret;
     }
+
+
+    // Whether a comparison is empty does not depend on other snapshots.
+    bool
+    are_candidates_stable(const ProxySnapshots& snapshots) const override
+    {
+	return true;
+    }
 };
 
 
@@ -867,3 +974,32 @@ do_cleanup_empty_pre_post(ProxySnapper* snapper, bool verbose, std::function<boo
     EmptyPrePostCleaner cleaner(snapper, verbose, parameters);
     cleaner.cleanup(condition);
 }
+
+
+void
+do_cleanup(ProxySnapper* snapper, const string& algorithm, bool verbose)
+{
+    if (algorithm == "number")
+	do_cleanup_number(snapper, verbose);
+    else if (algorithm == "timeline")
+	do_cleanup_timeline(snapper, verbose);
+    else if (algorithm == "empty-pre-post")
+	do_cleanup_empty_pre_post(snapper, verbose);
+    else
+	SN_THROW(UnknownCleanupAlgorithmException());
+}
+
+
+void
+do_cleanup(ProxySnapper* snapper, const string& algorithm, bool verbose,
+	   std::function<bool()> condition)
+{
+    if (algorithm == "number")
+	do_cleanup_number(snapper, verbose, condition);
+    else if (algorithm == "timeline")
+	do_cleanup_timeline(snapper, verbose, condition);
+    else if (algorithm == "empty-pre-post")
+	do_cleanup_empty_pre_post(snapper, verbose, condition);
+    else
+	SN_THROW(UnknownCleanupAlgorithmException());
+}
@@ -21,11 +21,29 @@
  */
 
 
+#ifndef SNAPPER_CLEANUP_H
+#define SNAPPER_CLEANUP_H
+
+
 #include <functional>
 
+#include <snapper/Exception.h>
+
 #include "proxy.h"
 
 
+struct UnknownCleanupAlgorithmException : public Exception
+{
+    explicit UnknownCleanupAlgorithmException() : Exception("unknown cleanup algorithm") {}
+};
+
+
+struct CleanupCancelledException : public Exception
+{
+    explicit CleanupCancelledException() : Exception("cleanup cancelled") {}
+};
+
+
 /*
  * The following three functions do the cleanup based on the conditionals defined in the
  * config, that are hard limit, quota and free space.
@@ -54,3 +72,18 @@ do_cleanup_timeline(ProxySnapper* snapper, bool verbose, std::function<bool()> c
 
 void
 do_cleanup_empty_pre_post(ProxySnapper* snapper, bool verbose, std::function<bool()> condition);
+
+
+/*
+ * The following two functions select the algorithm by its name, that is
+ * "number", "timeline" or "empty-pre-post".
+ */
+
+void
+do_cleanup(ProxySnapper* snapper, const string& algorithm, bool verbose);
+
+void
+do_cleanup(ProxySnapper* snapper, const string& algorithm, bool verbose,
+	   std::function<bool()> condition);
+
+#endif
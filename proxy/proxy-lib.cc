@@ -20,7 +20,12 @@
  */
 
 
+#include <algorithm>
+#include <exception>
+#include <boost/thread.hpp>
+
 #include "proxy-lib.h"
+#include "cleanup.h"
 
 
 using namespace std;
@@ -155,6 +160,25 @@ ProxySnapperLib::createComparison(const ProxySnapshot& lhs, const ProxySnapshot&
 }
 
 
+vector<bool>
+ProxySnapperLib::areComparisonsEmpty(const vector<snapshot_pair_t>& pairs) const
+{
+    vector<Comparison::snapshot_pair_t> tmp;
+
+    for (const snapshot_pair_t& pair : pairs)
+	tmp.emplace_back(to_lib(*pair.first).it, to_lib(*pair.second).it);
+
+    return Comparison::areEmpty(snapper, tmp, 0);
+}
+
+
+void
+ProxySnapperLib::cleanup(const string& algorithm)
+{
+    do_cleanup(this, algorithm, false);
+}
+
+
 ProxySnapshotsLib::ProxySnapshotsLib(ProxySnapperLib* backref)
     : backref(backref)
 {
@@ -194,6 +218,80 @@ ProxySnappersLib::getSnapper(const string& config_name)
 }
 
 
+vector<ProxySnapper*>
+ProxySnappersLib::getSnappers(const vector<string>& config_names)
+{
+    // Loading a config reads all snapshots from disk. Do that in parallel for
+    // all configs not loaded so far.
+
+    vector<unique_ptr<ProxySnapperLib>> loaded(config_names.size());
+    vector<exception_ptr> errors(config_names.size());
+
+    boost::thread_group threads;
+
+    for (size_t i = 0; i < config_names.size(); ++i)
+    {
+	if (find_if(proxy_snappers.begin(), proxy_snappers.end(),
+		    [&config_names, i](const unique_ptr<ProxySnapperLib>& proxy_snapper) {
+			return proxy_snapper->configName() == config_names[i];
+		    }) != proxy_snappers.end())
+	    continue;
+
+	threads.create_thread([this, &config_names, &loaded, &errors, i]() {
+	    try
+	    {
+		loaded[i].reset(new ProxySnapperLib(config_names[i], target_root));
+	    }
+	    catch (...)
+	    {
+		errors[i] = current_exception();
+	    }
+	});
+    }
+
+    threads.join_all();
+
+    vector<ProxySnapper*> ret;
+
+    for (size_t i = 0; i < config_names.size(); ++i)
+    {
+	if (errors[i])
+	    rethrow_exception(errors[i]);
+
+	if (loaded[i])
+	    proxy_snappers.push_back(std::move(loaded[i]));
+
+	ret.push_back(getSnapper(config_names[i]));
+    }
+
+    return ret;
+}
+
+
+vector<ProxySnapshots::const_iterator>
+ProxySnappersLib::createSingleSnapshots(const vector<string>& config_names, const SCD& scd)
+{
+    vector<ProxySnapper*> tmp = getSnappers(config_names);
+
+    vector<Snapper*> snappers;
+    for (ProxySnapper* proxy_snapper : tmp)
+	snappers.push_back(dynamic_cast<ProxySnapperLib*>(proxy_snapper)->snapper);
+
+    vector<Snapshots::iterator> snapshots = Snapper::createSingleSnapshots(snappers, scd);
+
+    vector<ProxySnapshots::const_iterator> ret;
+
+    for (size_t i = 0; i < tmp.size(); ++i)
+    {
+	ProxySnapshots& proxy_snapshots = tmp[i]->getSnapshots();
+	proxy_snapshots.emplace_back(new ProxySnapshotLib(snapshots[i]));
+	ret.push_back(--proxy_snapshots.end());
+    }
+
+    return ret;
+}
+
+
 map<string, ProxyConfig>
 ProxySnappersLib::getConfigs() const
 {
@@ -211,7 +309,7 @@ ProxyComparisonLib::ProxyComparisonLib(ProxySnapperLib* proxy_snapper, const Pro
 				       const ProxySnapshot& rhs, bool mount)
     : proxy_snapper(proxy_snapper)
 {
-    comparison.reset(new Comparison(proxy_snapper->snapper.get(), to_lib(lhs).it, to_lib(rhs).it,
+    comparison.reset(new Comparison(proxy_snapper->snapper, to_lib(lhs).it, to_lib(rhs).it,
 				    mount));
 }
 
@@ -98,7 +98,15 @@ class ProxySnapperLib : public ProxySnapper
 public:
 
     ProxySnapperLib(const string& config_name, const string& target_root)
-	: snapper(new Snapper(config_name, target_root)), proxy_snapshots(this)
+	: owned_snapper(new Snapper(config_name, target_root)), snapper(owned_snapper.get()),
+	  proxy_snapshots(this)
+    {}
+
+    /**
+     * Uses a snapper object owned by the caller, e.g. snapperd.
+     */
+    ProxySnapperLib(Snapper* snapper)
+	: snapper(snapper), proxy_snapshots(this)
     {}
 
     virtual const string& configName() const override { return snapper->configName(); }
@@ -121,6 +129,8 @@ public:
     virtual ProxyComparison createComparison(const ProxySnapshot& lhs, const ProxySnapshot& rhs,
 					     bool mount) override;
 
+    virtual vector<bool> areComparisonsEmpty(const vector<snapshot_pair_t>& pairs) const override;
+
     virtual void syncFilesystem() const override { snapper->syncFilesystem(); }
 
     virtual ProxySnapshots& getSnapshots() override { return proxy_snapshots; }
@@ -128,6 +138,10 @@ public:
 
     virtual void setupQuota() override { snapper->setupQuota(); }
 
+#ifdef ENABLE_SELINUX
+    virtual void resyncSelinuxContexts() const override { snapper->resyncSelinuxContexts(); }
+#endif
+
     virtual void prepareQuota() const override { snapper->prepareQuota(); }
 
     virtual QuotaData queryQuotaData() const override { return snapper->queryQuotaData(); }
@@ -136,7 +150,16 @@ public:
 
     virtual void calculateUsedSpace() const override { snapper->calculateUsedSpace(); }
 
-    std::unique_ptr<Snapper> snapper;
+    virtual void cleanup(const string& algorithm) override;
+
+private:
+
+    // only set if the snapper object is owned, must be initialized before snapper
+    std::unique_ptr<Snapper> owned_snapper;
+
+public:
+
+    Snapper* snapper;
 
 private:
 
@@ -161,6 +184,11 @@ public:
 
     virtual ProxySnapper* getSnapper(const string& config_name) override;
 
+    virtual vector<ProxySnapper*> getSnappers(const vector<string>& config_names) override;
+
+    virtual vector<ProxySnapshots::const_iterator> createSingleSnapshots(const vector<string>& config_names,
+									 const SCD& scd) override;
+
     virtual map<string, ProxyConfig> getConfigs() const override;
 
     virtual vector<string> debug() const override { return Snapper::debug(); }
@@ -24,6 +24,8 @@
 #define SNAPPER_PROXY_H
 
 
+#include "config.h"
+
 #include <memory>
 #include <vector>
 #include <list>
@@ -234,6 +236,14 @@ public:
     virtual ProxyComparison createComparison(const ProxySnapshot& lhs, const ProxySnapshot& rhs,
 					     bool mount) = 0;
 
+    typedef std::pair<ProxySnapshots::const_iterator, ProxySnapshots::const_iterator> snapshot_pair_t;
+
+    /**
+     * Check for each pair of snapshots whether the comparison contains
+     * no files. Much cheaper than creating the comparisons.
+     */
+    virtual vector<bool> areComparisonsEmpty(const vector<snapshot_pair_t>& pairs) const = 0;
+
     virtual void syncFilesystem() const = 0;
 
     virtual ProxySnapshots& getSnapshots() = 0;
@@ -241,6 +251,10 @@ public:
 
     virtual void setupQuota() = 0;
 
+#ifdef ENABLE_SELINUX
+    virtual void resyncSelinuxContexts() const = 0;
+#endif
+
     virtual void prepareQuota() const = 0;
 
     virtual QuotaData queryQuotaData() const = 0;
@@ -249,6 +263,14 @@ public:
 
     virtual void calculateUsedSpace() const = 0;
 
+    /**
+     * Runs the cleanup algorithm ("number", "timeline" or
+     * "empty-pre-post") including the quota and free space conditions.
+     * With DBus the algorithm runs inside snapperd. Throws
+     * CleanupCancelledException if the cleanup was cancelled.
+     */
+    virtual void cleanup(const string& algorithm) = 0;
+
 };
 
 
@@ -270,6 +292,22 @@ public:
     ProxySnapper* getSnapper(const string& config_name)
 	{ return impl->getSnapper(config_name); }
 
+    /**
+     * Like getSnapper() for several configs. The snapshots of the configs
+     * are loaded at once if possible.
+     */
+    vector<ProxySnapper*> getSnappers(const vector<string>& config_names)
+	{ return impl->getSnappers(config_names); }
+
+    /**
+     * Creates single snapshots of the current subvolumes of several
+     * configs together. Either all snapshots are created or none. The
+     * new snapshots are returned in the order of the configs.
+     */
+    vector<ProxySnapshots::const_iterator> createSingleSnapshots(const vector<string>& config_names,
+								 const SCD& scd)
+	{ return impl->createSingleSnapshots(config_names, scd); }
+
     map<string, ProxyConfig> getConfigs() const
 	{ return impl->getConfigs(); }
 
@@ -292,6 +330,11 @@ public:
 
 	virtual ProxySnapper* getSnapper(const string& config_name) = 0;
 
+	virtual vector<ProxySnapper*> getSnappers(const vector<string>& config_names) = 0;
+
+	virtual vector<ProxySnapshots::const_iterator> createSingleSnapshots(const vector<string>& config_names,
+									     const SCD& scd) = 0;
+
 	virtual map<string, ProxyConfig> getConfigs() const = 0;
 
 	virtual vector<string> debug() const = 0;
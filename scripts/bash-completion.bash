@@ -33,7 +33,7 @@ _snapper()
         "mount" "umount"
         "status" "diff" "xadiff"
         "undochange" "rollback"
-        "setup-quota"
+        "setup-quota" "resync-selinux"
         "cleanup")
 
     local command i
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include <sstream>
+#include <tuple>
+
+#include <snapper/Log.h>
+#include <snapper/FileUtils.h>
+#include <snapper/AppUtil.h>
+
+#include "Cleanup.h"
+#include "Client.h"
+
+
+ProxySnapperCleanup::ProxySnapperCleanup(DBus::Connection& conn, DBus::Message& msg,
+					 Client& client, MetaSnapper& meta_snapper,
+					 const string& algorithm, unsigned int serial,
+					 boost::unique_lock<boost::shared_mutex>& lock)
+    : ProxySnapperLib(meta_snapper.getSnapper()), conn(conn), msg(msg), client(client),
+      meta_snapper(meta_snapper), config_name(meta_snapper.configName()), algorithm(algorithm),
+      serial(serial), unlock([&lock]() { lock.unlock(); }), lock([&lock]() { lock.lock(); })
+{
+}
+
+
+void
+ProxySnapperCleanup::run(const map<string, string>& options)
+{
+    unsigned long long free_space = 0;
+
+    for (const map<string, string>::value_type& option : options)
+    {
+	if (option.first != "free-space")
+	    SN_THROW(InvalidCleanupOption());
+
+	if (option.second.empty() || option.second.find_first_not_of("0123456789") != string::npos)
+	    SN_THROW(InvalidCleanupOption());
+
+	istringstream s(option.second);
+	s >> free_space;
+	if (s.fail() || free_space == 0)
+	    SN_THROW(InvalidCleanupOption());
+    }
+
+    if (free_space == 0)
+    {
+	do_cleanup(this, algorithm, false);
+	return;
+    }
+
+    SDir subvolume_dir = snapper->openSubvolumeDir();
+
+    do_cleanup(this, algorithm, false, [this, &subvolume_dir, free_space]() {
+	Unlocker unlocker(unlock, lock);
+
+	snapper->syncFilesystem();
+
+	unsigned long long size, free;
+	std::tie(size, free) = subvolume_dir.statvfs();
+
+	return free >= free_space;
+    });
+}
+
+
+void
+ProxySnapperCleanup::deleteSnapshots(vector<ProxySnapshots::iterator> snapshots, bool verbose)
+{
+    if (meta_snapper.is_cleanup_cancelled(serial))
+	SN_THROW(CleanupCancelledException());
+
+    ProxySnapshots& proxy_snapshots = getSnapshots();
+
+    for (ProxySnapshots::iterator& snapshot : snapshots)
+    {
+	unsigned int num = snapshot->getNum();
+
+	// The situation might have changed while big_mutex was released.
+
+	client.check_lock(conn, msg, config_name);
+	client.check_config_in_use(meta_snapper, 1);
+	client.check_snapshot_in_use(meta_snapper, num);
+
+	// big_mutex is only held while updating the metadata, not while
+	// deleting the filesystem snapshot. Meanwhile the snapshot must
+	// not be used by other clients.
+
+	meta_snapper.deleting.insert(num);
+
+	try
+	{
+	    snapper->deleteSnapshot(to_lib(*snapshot).it, unlock, lock);
+	}
+	catch (...)
+	{
+	    meta_snapper.deleting.erase(num);
+	    throw;
+	}
+
+	meta_snapper.deleting.erase(num);
+
+	proxy_snapshots.erase(snapshot);
+
+	deleted.push_back(num);
+
+	// Releasing big_mutex also allows other clients to proceed and to
+	// cancel the cleanup.
+
+	Unlocker unlocker(unlock, lock);
+
+	client.signal_snapshots_deleted(conn, config_name, { num });
+	client.signal_cleanup_progress(conn, config_name, algorithm, deleted.size());
+    }
+}
+
+
+vector<bool>
+ProxySnapperCleanup::areComparisonsEmpty(const vector<snapshot_pair_t>& pairs) const
+{
+    vector<Comparison::snapshot_pair_t> tmp;
+
+    for (const snapshot_pair_t& pair : pairs)
+	tmp.emplace_back(to_lib(*pair.first).it, to_lib(*pair.second).it);
+
+    // big_mutex is only released while comparing since mounting and
+    // unmounting modify the snapshots.
+
+    return Comparison::areEmpty(snapper, tmp, 0, unlock, lock);
+}
+
+
+void
+ProxySnapperCleanup::syncFilesystem() const
+{
+    Unlocker unlocker(unlock, lock);
+
+    ProxySnapperLib::syncFilesystem();
+}
+
+
+QuotaData
+ProxySnapperCleanup::queryQuotaData() const
+{
+    Unlocker unlocker(unlock, lock);
+
+    return ProxySnapperLib::queryQuotaData();
+}
+
+
+FreeSpaceData
+ProxySnapperCleanup::queryFreeSpaceData() const
+{
+    Unlocker unlocker(unlock, lock);
+
+    return ProxySnapperLib::queryFreeSpaceData();
+}
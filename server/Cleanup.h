@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef SNAPPER_SERVER_CLEANUP_H
+#define SNAPPER_SERVER_CLEANUP_H
+
+
+#include <string>
+#include <list>
+#include <map>
+#include <functional>
+#include <boost/thread.hpp>
+
+#include <dbus/DBusConnection.h>
+#include <dbus/DBusMessage.h>
+
+#include "proxy/proxy-lib.h"
+#include "proxy/cleanup.h"
+
+#include "MetaSnapper.h"
+
+
+using namespace std;
+using namespace snapper;
+
+
+class Client;
+
+
+struct InvalidCleanupOption : public Exception
+{
+    explicit InvalidCleanupOption() : Exception("invalid cleanup option") {}
+};
+
+
+/**
+ * ProxySnapper used to run the cleanup algorithms inside snapperd on the
+ * snapper object of the config. big_mutex must be locked by the caller
+ * but is released during the quota and free space queries, the
+ * comparisons, the deletion of the filesystem snapshots and while
+ * sending the signals after each deletion.
+ */
+class ProxySnapperCleanup : public ProxySnapperLib
+{
+
+public:
+
+    ProxySnapperCleanup(DBus::Connection& conn, DBus::Message& msg, Client& client,
+			MetaSnapper& meta_snapper, const string& algorithm, unsigned int serial,
+			boost::unique_lock<boost::shared_mutex>& lock);
+
+    /**
+     * Runs the cleanup algorithm. The only supported option is
+     * "free-space" in bytes. If provided snapshots are only deleted until
+     * that much space is free. Throws CleanupCancelledException if the cleanup was
+     * cancelled, get_deleted() is still valid.
+     */
+    void run(const map<string, string>& options);
+
+    const list<dbus_uint32_t>& get_deleted() const { return deleted; }
+
+    virtual void deleteSnapshots(vector<ProxySnapshots::iterator> snapshots, bool verbose) override;
+
+    virtual vector<bool> areComparisonsEmpty(const vector<snapshot_pair_t>& pairs) const override;
+
+    virtual void syncFilesystem() const override;
+
+    virtual QuotaData queryQuotaData() const override;
+
+    virtual FreeSpaceData queryFreeSpaceData() const override;
+
+private:
+
+    DBus::Connection& conn;
+    DBus::Message& msg;
+    Client& client;
+    MetaSnapper& meta_snapper;
+
+    const string config_name;
+    const string algorithm;
+
+    // serial of the method call, see MetaSnapper::cancel_cleanup()
+    const unsigned int serial;
+
+    // release and reacquire big_mutex
+    const std::function<void()> unlock;
+    const std::function<void()> lock;
+
+    list<dbus_uint32_t> deleted;
+
+};
+
+
+#endif
@@ -33,10 +33,14 @@
 #include "Client.h"
 #include "MetaSnapper.h"
 #include "Background.h"
+#include "Cleanup.h"
 
 
 boost::shared_mutex big_mutex;
 
+// serial of the last queued method call, protected by big_mutex
+static unsigned int last_method_call_serial = 0;
+
 
 Client::Client(const string& name, uid_t uid, const Clients& clients)
     : name(name), uid(uid), clients(clients)
@@ -205,6 +209,12 @@ Client::introspect(DBus::Connection& conn, DBus::Message& msg)
 	"      <arg name='number' type='u'/>\n"
 	"    </signal>\n"
 
+	"    <signal name='CleanupProgress'>\n"
+	"      <arg name='config-name' type='s'/>\n"
+	"      <arg name='algorithm' type='s'/>\n"
+	"      <arg name='deleted' type='u'/>\n"
+	"    </signal>\n"
+
 	"    <method name='ListConfigs'>\n"
 	"      <arg name='configs' type='a(ssa{ss})' direction='out'/>\n"
 	"    </method>\n"
@@ -243,6 +253,11 @@ Client::introspect(DBus::Connection& conn, DBus::Message& msg)
 	"      <arg name='snapshots' type='a(uquxussa{ss})' direction='out'/>\n"
 	"    </method>\n"
 
+	"    <method name='ListSnapshotsByPipe'>\n"
+	"      <arg name='config-name' type='s' direction='in'/>\n"
+	"      <arg name='fd' type='h' direction='out'/>\n"
+	"    </method>\n"
+
 	"    <method name='ListSnapshotsAtTime'>\n"
 	"      <arg name='config-name' type='s' direction='in'/>\n"
 	"      <arg name='begin' type='x' direction='in'/>\n"
@@ -291,6 +306,14 @@ Client::introspect(DBus::Connection& conn, DBus::Message& msg)
 	"      <arg name='number' type='u' direction='out'/>\n"
 	"    </method>\n"
 
+	"    <method name='CreateSingleSnapshots'>\n"
+	"      <arg name='config-names' type='as' direction='in'/>\n"
+	"      <arg name='description' type='s' direction='in'/>\n"
+	"      <arg name='cleanup' type='s' direction='in'/>\n"
+	"      <arg name='userdata' type='a{ss}' direction='in'/>\n"
+	"      <arg name='numbers' type='au' direction='out'/>\n"
+	"    </method>\n"
+
 	"    <method name='CreatePreSnapshot'>\n"
 	"      <arg name='config-name' type='s' direction='in'/>\n"
 	"      <arg name='description' type='s' direction='in'/>\n"
@@ -313,6 +336,18 @@ Client::introspect(DBus::Connection& conn, DBus::Message& msg)
 	"      <arg name='numbers' type='au' direction='in'/>\n"
 	"    </method>\n"
 
+	"    <method name='Cleanup'>\n"
+	"      <arg name='config-name' type='s' direction='in'/>\n"
+	"      <arg name='algorithm' type='s' direction='in'/>\n"
+	"      <arg name='options' type='a{ss}' direction='in'/>\n"
+	"      <arg name='numbers' type='au' direction='out'/>\n"
+	"      <arg name='cancelled' type='b' direction='out'/>\n"
+	"    </method>\n"
+
+	"    <method name='CancelCleanup'>\n"
+	"      <arg name='config-name' type='s' direction='in'/>\n"
+	"    </method>\n"
+
 	"    <method name='GetDefaultSnapshot'>\n"
 	"      <arg name='config-name' type='s' direction='in'/>\n"
 	"      <arg name='valid' type='b' direction='out'/>\n"
@@ -361,6 +396,13 @@ Client::introspect(DBus::Connection& conn, DBus::Message& msg)
 	"      <arg name='num-files' type='u' direction='out'/>\n"
 	"    </method>\n"
 
+	"    <method name='AreComparisonsEmpty'>\n"
+	"      <arg name='config-name' type='s' direction='in'/>\n"
+	"      <arg name='numbers1' type='au' direction='in'/>\n"
+	"      <arg name='numbers2' type='au' direction='in'/>\n"
+	"      <arg name='empty' type='ab' direction='out'/>\n"
+	"    </method>\n"
+
 	"    <method name='DeleteComparison'>\n"
 	"      <arg name='config-name' type='s' direction='in'/>\n"
 	"      <arg name='number1' type='u' direction='in'/>\n"
@@ -381,10 +423,21 @@ Client::introspect(DBus::Connection& conn, DBus::Message& msg)
 	"      <arg name='fd' type='h' direction='out'/>\n"
 	"    </method>\n"
 
+	"    <method name='ListAllByPipe'>\n"
+	"      <arg name='used-space' type='b' direction='in'/>\n"
+	"      <arg name='fd' type='h' direction='out'/>\n"
+	"    </method>\n"
+
 	"    <method name='Sync'>\n"
 	"      <arg name='config-name' type='s' direction='in'/>\n"
 	"    </method>\n"
 
+#ifdef ENABLE_SELINUX
+	"    <method name='ResyncSelinuxContexts'>\n"
+	"      <arg name='config-name' type='s' direction='in'/>\n"
+	"    </method>\n"
+#endif
+
 	"  </interface>\n"
 	"</node>\n";
 
@@ -481,9 +534,9 @@ struct SnapshotInUse : public Exception
 
 
 void
-Client::check_config_in_use(const MetaSnapper& meta_snapper) const
+Client::check_config_in_use(const MetaSnapper& meta_snapper, int own_use_count) const
 {
-    if (meta_snapper.use_count() != 0)
+    if (meta_snapper.use_count() != own_use_count)
 	throw ConfigInUse();
 }
 
@@ -502,6 +555,14 @@ Client::check_snapshot_in_use(const MetaSnapper& meta_snapper, unsigned int numb
 }
 
 
+void
+Client::check_snapshot_deleting(const MetaSnapper& meta_snapper, unsigned int number) const
+{
+    if (meta_snapper.deleting.find(number) != meta_snapper.deleting.end())
+	throw SnapshotInUse();
+}
+
+
 void
 Client::signal_config_created(DBus::Connection& conn, const string& config_name)
 {
@@ -577,6 +638,19 @@ Client::signal_snapshots_deleted(DBus::Connection& conn, const string& config_na
 }
 
 
+void
+Client::signal_cleanup_progress(DBus::Connection& conn, const string& config_name,
+				const string& algorithm, unsigned int deleted)
+{
+    DBus::MessageSignal msg(PATH, INTERFACE, "CleanupProgress");
+
+    DBus::Hoho hoho(msg);
+    hoho << config_name << algorithm << deleted;
+
+    conn.send(msg);
+}
+
+
 void
 Client::list_configs(DBus::Connection& conn, DBus::Message& msg)
 {
@@ -780,6 +854,43 @@ Client::list_snapshots(DBus::Connection& conn, DBus::Message& msg)
 }
 
 
+void
+Client::list_snapshots_by_pipe(DBus::Connection& conn, DBus::Message& msg)
+{
+    string config_name;
+
+    DBus::Hihi hihi(msg);
+    hihi >> config_name;
+
+    y2deb("ListSnapshotsByPipe config_name:" << config_name);
+
+    boost::unique_lock<boost::shared_mutex> lock(big_mutex);
+
+    MetaSnappers::iterator it = meta_snappers.find(config_name);
+
+    check_permission(conn, msg, *it);
+
+    Snapper* snapper = it->getSnapper();
+    Snapshots& snapshots = snapper->getSnapshots();
+
+    shared_ptr<ListAllTransferTask> list_all_transfer_task = make_shared<ListAllTransferTask>();
+
+    list_all_transfer_task->add_config(it->getConfigInfo());
+    list_all_transfer_task->add_snapshots(snapshots);
+
+    DBus::MessageMethodReturn reply(msg);
+
+    DBus::Hoho hoho(reply);
+
+    hoho << list_all_transfer_task->get_read_end();
+    conn.send(reply);
+
+    list_all_transfer_task->get_read_end().close();
+
+    add_files_transfer_task(list_all_transfer_task);
+}
+
+
 void
 Client::list_snapshots_at_time(DBus::Connection& conn, DBus::Message& msg)
 {
@@ -867,6 +978,7 @@ Client::set_snapshot(DBus::Connection& conn, DBus::Message& msg)
     MetaSnappers::iterator it = meta_snappers.find(config_name);
 
     check_permission(conn, msg, *it);
+    check_snapshot_deleting(*it, num);
 
     Snapper* snapper = it->getSnapper();
     Snapshots& snapshots = snapper->getSnapshots();
@@ -937,6 +1049,7 @@ Client::create_single_snapshot_v2(DBus::Connection& conn, DBus::Message& msg)
     MetaSnappers::iterator it = meta_snappers.find(config_name);
 
     check_permission(conn, msg, *it);
+    check_snapshot_deleting(*it, parent_num);
     scd.uid = uid;
 
     Snapper* snapper = it->getSnapper();
@@ -992,6 +1105,51 @@ Client::create_single_snapshot_of_default(DBus::Connection& conn, DBus::Message&
 }
 
 
+void
+Client::create_single_snapshots(DBus::Connection& conn, DBus::Message& msg)
+{
+    vector<string> config_names;
+    SCD scd;
+
+    DBus::Hihi hihi(msg);
+    hihi >> config_names >> scd.description >> scd.cleanup >> scd.userdata;
+
+    y2deb("CreateSingleSnapshots config_names:" << config_names << " description:" <<
+	  scd.description << " cleanup:" << scd.cleanup);
+
+    boost::unique_lock<boost::shared_mutex> lock(big_mutex);
+
+    vector<Snapper*> snappers;
+
+    for (const string& config_name : config_names)
+    {
+	MetaSnappers::iterator it = meta_snappers.find(config_name);
+
+	check_permission(conn, msg, *it);
+
+	snappers.push_back(it->getSnapper());
+    }
+
+    scd.uid = uid;
+
+    vector<Snapshots::iterator> snaps = Snapper::createSingleSnapshots(snappers, scd);
+
+    vector<dbus_uint32_t> nums;
+    for (Snapshots::iterator& snap : snaps)
+	nums.push_back(snap->getNum());
+
+    DBus::MessageMethodReturn reply(msg);
+
+    DBus::Hoho hoho(reply);
+    hoho << nums;
+
+    conn.send(reply);
+
+    for (size_t i = 0; i < config_names.size(); ++i)
+	signal_snapshot_created(conn, config_names[i], nums[i]);
+}
+
+
 void
 Client::create_pre_snapshot(DBus::Connection& conn, DBus::Message& msg)
 {
@@ -1044,6 +1202,7 @@ Client::create_post_snapshot(DBus::Connection& conn, DBus::Message& msg)
     MetaSnappers::iterator it = meta_snappers.find(config_name);
 
     check_permission(conn, msg, *it);
+    check_snapshot_deleting(*it, pre_num);
     scd.uid = uid;
 
     Snapper* snapper = it->getSnapper();
@@ -1108,6 +1267,79 @@ Client::delete_snapshots(DBus::Connection& conn, DBus::Message& msg)
 }
 
 
+void
+Client::cleanup(DBus::Connection& conn, DBus::Message& msg, unsigned int serial)
+{
+    string config_name;
+    string algorithm;
+    map<string, string> options;
+
+    DBus::Hihi hihi(msg);
+    hihi >> config_name >> algorithm >> options;
+
+    y2deb("Cleanup config_name:" << config_name << " algorithm:" << algorithm);
+
+    boost::unique_lock<boost::shared_mutex> lock(big_mutex);
+
+    MetaSnappers::iterator it = meta_snappers.find(config_name);
+
+    check_permission(conn, msg, *it);
+    check_lock(conn, msg, config_name);
+    check_config_in_use(*it);
+
+    // The proxy releases big_mutex during lengthy operations, the
+    // reference keeps the config and the snapper object alive.
+
+    RefHolder ref_holder(*it);
+
+    ProxySnapperCleanup proxy_snapper(conn, msg, *this, *it, algorithm, serial, lock);
+
+    bool cancelled = false;
+
+    try
+    {
+	proxy_snapper.run(options);
+    }
+    catch (const CleanupCancelledException& e)
+    {
+	SN_CAUGHT(e);
+
+	cancelled = true;
+    }
+
+    DBus::MessageMethodReturn reply(msg);
+
+    DBus::Hoho hoho(reply);
+    hoho << proxy_snapper.get_deleted() << cancelled;
+
+    conn.send(reply);
+}
+
+
+void
+Client::cancel_cleanup(DBus::Connection& conn, DBus::Message& msg)
+{
+    string config_name;
+
+    DBus::Hihi hihi(msg);
+    hihi >> config_name;
+
+    y2deb("CancelCleanup config_name:" << config_name);
+
+    boost::unique_lock<boost::shared_mutex> lock(big_mutex);
+
+    MetaSnappers::iterator it = meta_snappers.find(config_name);
+
+    check_permission(conn, msg, *it);
+
+    it->cancel_cleanup(last_method_call_serial);
+
+    DBus::MessageMethodReturn reply(msg);
+
+    conn.send(reply);
+}
+
+
 void
 Client::get_default_snapshot(DBus::Connection& conn, DBus::Message& msg)
 {
@@ -1256,6 +1488,7 @@ Client::mount_snapshot(DBus::Connection& conn, DBus::Message& msg)
     MetaSnappers::iterator it = meta_snappers.find(config_name);
 
     check_permission(conn, msg, *it);
+    check_snapshot_deleting(*it, num);
 
     Snapper* snapper = it->getSnapper();
     Snapshots& snapshots = snapper->getSnapshots();
@@ -1367,6 +1600,8 @@ Client::create_comparison(DBus::Connection& conn, DBus::Message& msg)
     MetaSnappers::iterator it = meta_snappers.find(config_name);
 
     check_permission(conn, msg, *it);
+    check_snapshot_deleting(*it, num1);
+    check_snapshot_deleting(*it, num2);
 
     Snapper* snapper = it->getSnapper();
     Snapshots& snapshots = snapper->getSnapshots();
@@ -1395,6 +1630,54 @@ Client::create_comparison(DBus::Connection& conn, DBus::Message& msg)
 }
 
 
+void
+Client::are_comparisons_empty(DBus::Connection& conn, DBus::Message& msg)
+{
+    string config_name;
+    vector<dbus_uint32_t> nums1, nums2;
+
+    DBus::Hihi hihi(msg);
+    hihi >> config_name >> nums1 >> nums2;
+
+    y2deb("AreComparisonsEmpty config_name:" << config_name << " pairs:" << nums1.size());
+
+    if (nums1.size() != nums2.size())
+	throw DBus::MarshallingException();
+
+    boost::unique_lock<boost::shared_mutex> lock(big_mutex);
+
+    MetaSnappers::iterator it = meta_snappers.find(config_name);
+
+    check_permission(conn, msg, *it);
+
+    Snapper* snapper = it->getSnapper();
+    Snapshots& snapshots = snapper->getSnapshots();
+
+    vector<Comparison::snapshot_pair_t> pairs;
+    for (size_t i = 0; i < nums1.size(); ++i)
+    {
+	check_snapshot_deleting(*it, nums1[i]);
+	check_snapshot_deleting(*it, nums2[i]);
+	pairs.emplace_back(snapshots.find(nums1[i]), snapshots.find(nums2[i]));
+    }
+
+    RefHolder ref_holder(*it);
+
+    // big_mutex is only released while comparing since mounting and
+    // unmounting modify the snapshots.
+
+    vector<bool> empty = Comparison::areEmpty(snapper, pairs, 0, [&lock]() { lock.unlock(); },
+					      [&lock]() { lock.lock(); });
+
+    DBus::MessageMethodReturn reply(msg);
+
+    DBus::Hoho hoho(reply);
+    hoho << empty;
+
+    conn.send(reply);
+}
+
+
 void
 Client::delete_comparison(DBus::Connection& conn, DBus::Message& msg)
 {
@@ -1489,6 +1772,75 @@ Client::get_files_by_pipe(DBus::Connection& conn, DBus::Message& msg)
 }
 
 
+void
+Client::list_all_by_pipe(DBus::Connection& conn, DBus::Message& msg)
+{
+    bool used_space;
+
+    DBus::Hihi hihi(msg);
+    hihi >> used_space;
+
+    y2deb("ListAllByPipe used_space:" << used_space);
+
+    boost::unique_lock<boost::shared_mutex> lock(big_mutex);
+
+    shared_ptr<ListAllTransferTask> list_all_transfer_task = make_shared<ListAllTransferTask>();
+
+    for (MetaSnappers::iterator it = meta_snappers.begin(); it != meta_snappers.end(); ++it)
+    {
+	list_all_transfer_task->add_config(it->getConfigInfo());
+
+	// Configs that cannot be accessed or loaded are only marked. The
+	// client can query them individually to get the specific error.
+
+	try
+	{
+	    check_permission(conn, msg, *it);
+
+	    Snapper* snapper = it->getSnapper();
+	    Snapshots& snapshots = snapper->getSnapshots();
+
+	    list_all_transfer_task->add_snapshots(snapshots);
+
+	    if (used_space)
+	    {
+		try
+		{
+		    snapper->calculateUsedSpace();
+
+		    for (const Snapshot& snapshot : snapshots)
+		    {
+			if (!snapshot.isCurrent())
+			    list_all_transfer_task->add_used_space(snapshot.getNum(),
+								   snapshot.getUsedSpace());
+		    }
+		}
+		catch (const QuotaException& e)
+		{
+		    SN_CAUGHT(e);
+		}
+	    }
+	}
+	catch (const Exception& e)
+	{
+	    SN_CAUGHT(e);
+	    list_all_transfer_task->add_error();
+	}
+    }
+
+    DBus::MessageMethodReturn reply(msg);
+
+    DBus::Hoho hoho(reply);
+
+    hoho << list_all_transfer_task->get_read_end();
+    conn.send(reply);
+
+    list_all_transfer_task->get_read_end().close();
+
+    add_files_transfer_task(list_all_transfer_task);
+}
+
+
 void
 Client::setup_quota(DBus::Connection& conn, DBus::Message& msg)
 {
@@ -1623,6 +1975,36 @@ Client::sync(DBus::Connection& conn, DBus::Message& msg)
 }
 
 
+#ifdef ENABLE_SELINUX
+
+void
+Client::resync_selinux_contexts(DBus::Connection& conn, DBus::Message& msg)
+{
+    string config_name;
+
+    DBus::Hihi hihi(msg);
+    hihi >> config_name;
+
+    y2deb("ResyncSelinuxContexts config_name:" << config_name);
+
+    boost::unique_lock<boost::shared_mutex> lock(big_mutex);
+
+    MetaSnappers::iterator it = meta_snappers.find(config_name);
+
+    check_permission(conn, msg, *it);
+
+    Snapper* snapper = it->getSnapper();
+
+    snapper->resyncSelinuxContexts();
+
+    DBus::MessageMethodReturn reply(msg);
+
+    conn.send(reply);
+}
+
+#endif
+
+
 void
 Client::debug(DBus::Connection& conn, DBus::Message& msg) const
 {
@@ -1696,7 +2078,7 @@ Client::debug(DBus::Connection& conn, DBus::Message& msg) const
 
 
 void
-Client::dispatch(DBus::Connection& conn, DBus::Message& msg)
+Client::dispatch(DBus::Connection& conn, DBus::Message& msg, unsigned int serial)
 {
     try
     {
@@ -1716,6 +2098,8 @@ Client::dispatch(DBus::Connection& conn, DBus::Message& msg)
 	    unlock_config(conn, msg);
 	else if (msg.is_method_call(INTERFACE, "ListSnapshots"))
 	    list_snapshots(conn, msg);
+	else if (msg.is_method_call(INTERFACE, "ListSnapshotsByPipe"))
+	    list_snapshots_by_pipe(conn, msg);
 	else if (msg.is_method_call(INTERFACE, "ListSnapshotsAtTime"))
 	    list_snapshots_at_time(conn, msg);
 	else if (msg.is_method_call(INTERFACE, "GetSnapshot"))
@@ -1728,12 +2112,18 @@ Client::dispatch(DBus::Connection& conn, DBus::Message& msg)
 	    create_single_snapshot_v2(conn, msg);
 	else if (msg.is_method_call(INTERFACE, "CreateSingleSnapshotOfDefault"))
 	    create_single_snapshot_of_default(conn, msg);
+	else if (msg.is_method_call(INTERFACE, "CreateSingleSnapshots"))
+	    create_single_snapshots(conn, msg);
 	else if (msg.is_method_call(INTERFACE, "CreatePreSnapshot"))
 	    create_pre_snapshot(conn, msg);
 	else if (msg.is_method_call(INTERFACE, "CreatePostSnapshot"))
 	    create_post_snapshot(conn, msg);
 	else if (msg.is_method_call(INTERFACE, "DeleteSnapshots"))
 	    delete_snapshots(conn, msg);
+	else if (msg.is_method_call(INTERFACE, "Cleanup"))
+	    cleanup(conn, msg, serial);
+	else if (msg.is_method_call(INTERFACE, "CancelCleanup"))
+	    cancel_cleanup(conn, msg);
 	else if (msg.is_method_call(INTERFACE, "GetDefaultSnapshot"))
 	    get_default_snapshot(conn, msg);
 	else if (msg.is_method_call(INTERFACE, "GetActiveSnapshot"))
@@ -1750,12 +2140,16 @@ Client::dispatch(DBus::Connection& conn, DBus::Message& msg)
 	    get_mount_point(conn, msg);
 	else if (msg.is_method_call(INTERFACE, "CreateComparison"))
 	    create_comparison(conn, msg);
+	else if (msg.is_method_call(INTERFACE, "AreComparisonsEmpty"))
+	    are_comparisons_empty(conn, msg);
 	else if (msg.is_method_call(INTERFACE, "DeleteComparison"))
 	    delete_comparison(conn, msg);
 	else if (msg.is_method_call(INTERFACE, "GetFiles"))
 	    get_files(conn, msg);
 	else if (msg.is_method_call(INTERFACE, "GetFilesByPipe"))
 	    get_files_by_pipe(conn, msg);
+	else if (msg.is_method_call(INTERFACE, "ListAllByPipe"))
+	    list_all_by_pipe(conn, msg);
 	else if (msg.is_method_call(INTERFACE, "SetupQuota"))
 	    setup_quota(conn, msg);
 	else if (msg.is_method_call(INTERFACE, "PrepareQuota"))
@@ -1766,6 +2160,10 @@ Client::dispatch(DBus::Connection& conn, DBus::Message& msg)
 	    query_free_space(conn, msg);
 	else if (msg.is_method_call(INTERFACE, "Sync"))
 	    sync(conn, msg);
+#ifdef ENABLE_SELINUX
+	else if (msg.is_method_call(INTERFACE, "ResyncSelinuxContexts"))
+	    resync_selinux_contexts(conn, msg);
+#endif
 	else if (msg.is_method_call(INTERFACE, "Debug"))
 	    debug(conn, msg);
 	else
@@ -1940,6 +2338,18 @@ Client::dispatch(DBus::Connection& conn, DBus::Message& msg)
 	DBus::MessageError reply(msg, "error.stream", DBUS_ERROR_FAILED);
 	conn.send(reply);
     }
+    catch (const UnknownCleanupAlgorithmException& e)
+    {
+	SN_CAUGHT(e);
+	DBus::MessageError reply(msg, "error.unknown_cleanup_algorithm", DBUS_ERROR_FAILED);
+	conn.send(reply);
+    }
+    catch (const InvalidCleanupOption& e)
+    {
+	SN_CAUGHT(e);
+	DBus::MessageError reply(msg, "error.invalid_cleanup_option", DBUS_ERROR_FAILED);
+	conn.send(reply);
+    }
     catch (const Exception& e)
     {
 	SN_CAUGHT(e);
@@ -1962,7 +2372,7 @@ Client::add_method_call_task(DBus::Connection& conn, DBus::Message& msg)
 	method_call_thread = boost::thread(boost::bind(&Client::method_call_worker, this));
 
     boost::unique_lock<boost::mutex> lock(method_call_mutex);
-    method_call_tasks.push(MethodCallTask(conn, msg));
+    method_call_tasks.push(MethodCallTask(conn, msg, ++last_method_call_serial));
     lock.unlock();
 
     method_call_condition.notify_one();
@@ -1970,7 +2380,7 @@ Client::add_method_call_task(DBus::Connection& conn, DBus::Message& msg)
 
 
 void
-Client::add_files_transfer_task(shared_ptr<FilesTransferTask> files_transfer_task)
+Client::add_files_transfer_task(shared_ptr<TransferTask> files_transfer_task)
 {
     if (files_transfer_thread.get_id() == boost::thread::id())
 	files_transfer_thread = boost::thread(boost::bind(&Client::files_transfer_worker, this));
@@ -1997,7 +2407,7 @@ Client::method_call_worker()
 	    method_call_tasks.pop();
 	    lock.unlock();
 
-	    dispatch(method_call_task.conn, method_call_task.msg);
+	    dispatch(method_call_task.conn, method_call_task.msg, method_call_task.serial);
 	}
     }
     catch (const boost::thread_interrupted&)
@@ -2077,7 +2487,7 @@ Client::files_transfer_worker()
 	    while (files_transfer_tasks.empty())
 		files_transfer_condition.wait(lock);
 
-	    shared_ptr<FilesTransferTask> ptr(files_transfer_tasks.front());
+	    shared_ptr<TransferTask> ptr(files_transfer_tasks.front());
 	    files_transfer_tasks.pop();
 	    lock.unlock();
 
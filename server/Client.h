@@ -25,6 +25,8 @@
 #define SNAPPER_CLIENT_H
 
 
+#include "config.h"
+
 #include <string>
 #include <list>
 #include <queue>
@@ -39,6 +41,7 @@
 
 #include "MetaSnapper.h"
 #include "FilesTransferTask.h"
+#include "ListAllTransferTask.h"
 
 
 using namespace std;
@@ -72,8 +75,9 @@ public:
     void check_permission(DBus::Connection& conn, DBus::Message& msg,
 			  const MetaSnapper& meta_snapper) const;
     void check_lock(DBus::Connection& conn, DBus::Message& msg, const string& config_name) const;
-    void check_config_in_use(const MetaSnapper& meta_snapper) const;
+    void check_config_in_use(const MetaSnapper& meta_snapper, int own_use_count = 0) const;
     void check_snapshot_in_use(const MetaSnapper& meta_snapper, unsigned int number) const;
+    void check_snapshot_deleting(const MetaSnapper& meta_snapper, unsigned int number) const;
 
     void signal_config_created(DBus::Connection& conn, const string& config_name);
     void signal_config_modified(DBus::Connection& conn, const string& config_name);
@@ -84,6 +88,8 @@ public:
 				  unsigned int num);
     void signal_snapshots_deleted(DBus::Connection& conn, const string& config_name,
 				  const list<dbus_uint32_t>& nums);
+    void signal_cleanup_progress(DBus::Connection& conn, const string& config_name,
+				 const string& algorithm, unsigned int deleted);
 
     void list_configs(DBus::Connection& conn, DBus::Message& msg);
     void get_config(DBus::Connection& conn, DBus::Message& msg);
@@ -93,15 +99,19 @@ public:
     void lock_config(DBus::Connection& conn, DBus::Message& msg);
     void unlock_config(DBus::Connection& conn, DBus::Message& msg);
     void list_snapshots(DBus::Connection& conn, DBus::Message& msg);
+    void list_snapshots_by_pipe(DBus::Connection& conn, DBus::Message& msg);
     void list_snapshots_at_time(DBus::Connection& conn, DBus::Message& msg);
     void get_snapshot(DBus::Connection& conn, DBus::Message& msg);
     void set_snapshot(DBus::Connection& conn, DBus::Message& msg);
     void create_single_snapshot(DBus::Connection& conn, DBus::Message& msg);
     void create_single_snapshot_v2(DBus::Connection& conn, DBus::Message& msg);
     void create_single_snapshot_of_default(DBus::Connection& conn, DBus::Message& msg);
+    void create_single_snapshots(DBus::Connection& conn, DBus::Message& msg);
     void create_pre_snapshot(DBus::Connection& conn, DBus::Message& msg);
     void create_post_snapshot(DBus::Connection& conn, DBus::Message& msg);
     void delete_snapshots(DBus::Connection& conn, DBus::Message& msg);
+    void cleanup(DBus::Connection& conn, DBus::Message& msg, unsigned int serial);
+    void cancel_cleanup(DBus::Connection& conn, DBus::Message& msg);
     void get_default_snapshot(DBus::Connection& conn, DBus::Message& msg);
     void get_active_snapshot(DBus::Connection& conn, DBus::Message& msg);
     void calculate_used_space(DBus::Connection& conn, DBus::Message& msg);
@@ -110,17 +120,22 @@ public:
     void umount_snapshot(DBus::Connection& conn, DBus::Message& msg);
     void get_mount_point(DBus::Connection& conn, DBus::Message& msg);
     void create_comparison(DBus::Connection& conn, DBus::Message& msg);
+    void are_comparisons_empty(DBus::Connection& conn, DBus::Message& msg);
     void delete_comparison(DBus::Connection& conn, DBus::Message& msg);
     void get_files(DBus::Connection& conn, DBus::Message& msg);
     void get_files_by_pipe(DBus::Connection& conn, DBus::Message& msg);
+    void list_all_by_pipe(DBus::Connection& conn, DBus::Message& msg);
     void setup_quota(DBus::Connection& conn, DBus::Message& msg);
     void prepare_quota(DBus::Connection& conn, DBus::Message& msg);
     void query_quota(DBus::Connection& conn, DBus::Message& msg);
     void query_free_space(DBus::Connection& conn, DBus::Message& msg);
     void sync(DBus::Connection& conn, DBus::Message& msg);
+#ifdef ENABLE_SELINUX
+    void resync_selinux_contexts(DBus::Connection& conn, DBus::Message& msg);
+#endif
     void debug(DBus::Connection& conn, DBus::Message& msg) const;
 
-    void dispatch(DBus::Connection& conn, DBus::Message& msg);
+    void dispatch(DBus::Connection& conn, DBus::Message& msg, unsigned int serial = 0);
 
     Client(const string& name, uid_t uid, const Clients& clients);
     ~Client();
@@ -152,10 +167,14 @@ public:
 
     struct MethodCallTask
     {
-	MethodCallTask(DBus::Connection& conn, DBus::Message& msg) : conn(conn), msg(msg) {}
+	MethodCallTask(DBus::Connection& conn, DBus::Message& msg, unsigned int serial)
+	    : conn(conn), msg(msg), serial(serial) {}
 
 	DBus::Connection& conn;
 	DBus::Message msg;
+
+	// order of arrival among the method calls of all clients
+	unsigned int serial;
     };
 
     boost::condition_variable method_call_condition;
@@ -167,8 +186,8 @@ public:
     boost::condition_variable files_transfer_condition;
     boost::mutex files_transfer_mutex;
     boost::thread files_transfer_thread;
-    queue<shared_ptr<FilesTransferTask>> files_transfer_tasks;
-    void add_files_transfer_task(shared_ptr<FilesTransferTask> files_transfer_task);
+    queue<shared_ptr<TransferTask>> files_transfer_tasks;
+    void add_files_transfer_task(shared_ptr<TransferTask> files_transfer_task);
 
     bool zombie = false;
 
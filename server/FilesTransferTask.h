@@ -23,30 +23,18 @@
 #define SNAPPER_FILES_TRANSFER_TASK_H
 
 
-#include <dbus/DBusPipe.h>
-
 #include <snapper/File.h>
 
-
-using namespace snapper;
-
-
-struct StreamException : Exception
-{
-    explicit StreamException() : Exception("stream exception") {}
-};
+#include "TransferTask.h"
 
 
-class FilesTransferTask
+class FilesTransferTask : public TransferTask
 {
 public:
 
     FilesTransferTask(const Files& files);
 
-    DBus::FileDescriptor& get_read_end() { return pipe.get_read_end(); }
-    DBus::FileDescriptor& get_write_end() { return pipe.get_write_end(); }
-
-    void run();
+    virtual void run() override;
 
 private:
 
@@ -55,8 +43,6 @@ private:
     // shared object.
     const Files files;
 
-    DBus::Pipe pipe;
-
 };
 
 
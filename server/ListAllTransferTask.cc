@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include <stdio.h>
+
+#include <snapper/Exception.h>
+
+#include "ListAllTransferTask.h"
+
+
+void
+ListAllTransferTask::add_line(const vector<string>& fields)
+{
+    for (vector<string>::const_iterator it = fields.begin(); it != fields.end(); ++it)
+    {
+	if (it != fields.begin())
+	    text += ' ';
+	text += *it;
+    }
+
+    text += '\n';
+}
+
+
+void
+ListAllTransferTask::add_config(const ConfigInfo& config_info)
+{
+    add_line({ "config", DBus::Pipe::escape(config_info.get_config_name()),
+	       DBus::Pipe::escape(config_info.get_subvolume()) });
+
+    for (const map<string, string>::value_type& value : config_info.get_all_values())
+	add_line({ "value", DBus::Pipe::escape(value.first), DBus::Pipe::escape(value.second) });
+}
+
+
+void
+ListAllTransferTask::add_error()
+{
+    add_line({ "error" });
+}
+
+
+void
+ListAllTransferTask::add_default(unsigned int num)
+{
+    add_line({ "default", std::to_string(num) });
+}
+
+
+void
+ListAllTransferTask::add_active(unsigned int num)
+{
+    add_line({ "active", std::to_string(num) });
+}
+
+
+void
+ListAllTransferTask::add_snapshot(const Snapshot& snapshot)
+{
+    add_line({ "snapshot", std::to_string(snapshot.getNum()), std::to_string(snapshot.getType()),
+	       std::to_string(snapshot.getDate()), std::to_string(snapshot.getUid()),
+	       std::to_string(snapshot.getPreNum()), DBus::Pipe::escape(snapshot.getDescription()),
+	       DBus::Pipe::escape(snapshot.getCleanup()) });
+
+    for (const map<string, string>::value_type& value : snapshot.getUserdata())
+	add_line({ "userdata", DBus::Pipe::escape(value.first), DBus::Pipe::escape(value.second) });
+}
+
+
+void
+ListAllTransferTask::add_snapshots(const Snapshots& snapshots)
+{
+    // Querying the default and active snapshot can fail, e.g. if the
+    // btrfs ioctl fails. That is reported as no default or active
+    // snapshot instead of failing the whole list.
+
+    try
+    {
+	Snapshots::const_iterator tmp1 = snapshots.getDefault();
+	if (tmp1 != snapshots.end())
+	    add_default(tmp1->getNum());
+    }
+    catch (const Exception& e)
+    {
+	SN_CAUGHT(e);
+    }
+
+    try
+    {
+	Snapshots::const_iterator tmp2 = snapshots.getActive();
+	if (tmp2 != snapshots.end())
+	    add_active(tmp2->getNum());
+    }
+    catch (const Exception& e)
+    {
+	SN_CAUGHT(e);
+    }
+
+    for (const Snapshot& snapshot : snapshots)
+	add_snapshot(snapshot);
+}
+
+
+void
+ListAllTransferTask::add_used_space(unsigned int num, uint64_t used_space)
+{
+    add_line({ "used-space", std::to_string(num), std::to_string(used_space) });
+}
+
+
+void
+ListAllTransferTask::run()
+{
+    FILE* fout = fdopen(get_write_end().get_fd(), "w");
+    if (!fout)
+	SN_THROW(StreamException());
+
+    if (fwrite(text.data(), 1, text.size(), fout) != text.size())
+	SN_THROW(StreamException());
+
+    if (fflush(fout) != 0)
+	SN_THROW(StreamException());
+
+    if (fclose(fout) != 0)
+	SN_THROW(StreamException());
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef SNAPPER_LIST_ALL_TRANSFER_TASK_H
+#define SNAPPER_LIST_ALL_TRANSFER_TASK_H
+
+
+#include <snapper/Snapper.h>
+#include <snapper/Snapshot.h>
+
+#include "TransferTask.h"
+
+
+/**
+ * Transfers the configs with their snapshots, default and active snapshot
+ * and optionally used space of all snapshots. The text is generated while
+ * holding the big mutex and only written to the pipe in run(). See
+ * doc/dbus-protocol.txt for the format.
+ */
+class ListAllTransferTask : public TransferTask
+{
+public:
+
+    void add_config(const ConfigInfo& config_info);
+    void add_error();
+    void add_default(unsigned int num);
+    void add_active(unsigned int num);
+    void add_snapshot(const Snapshot& snapshot);
+
+    // adds the default and active snapshot and all snapshots
+    void add_snapshots(const Snapshots& snapshots);
+    void add_used_space(unsigned int num, uint64_t used_space);
+
+    virtual void run() override;
+
+private:
+
+    void add_line(const vector<string>& fields);
+
+    string text;
+
+};
+
+
+#endif
@@ -23,6 +23,7 @@
 
 #include <string.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <boost/algorithm/string.hpp>
 
 #include <snapper/Log.h>
@@ -57,6 +58,9 @@ MetaSnapper::setConfigInfo(const map<string, string>& raw)
 
     getSnapper()->setConfigInfo(raw);
 
+    // the config file was changed by us, not by others
+    config_stamp = stat_config();
+
     if (raw.find(KEY_ALLOW_USERS) != raw.end() || raw.find(KEY_ALLOW_GROUPS) != raw.end())
 	set_permissions();
 }
@@ -102,8 +106,16 @@ MetaSnapper::set_permissions()
 Snapper*
 MetaSnapper::getSnapper()
 {
+    if (snapper && stale)
+	refresh();
+
     if (!snapper)
+    {
+	config_stamp = stat_config();
 	snapper = new Snapper(config_info.get_config_name(), "/");
+    }
+
+    stale = false;
 
     update_use_time();
 
@@ -116,6 +128,75 @@ MetaSnapper::unload()
 {
     delete snapper;
     snapper = nullptr;
+
+    stale = false;
+}
+
+
+size_t
+MetaSnapper::loaded_snapshots() const
+{
+    return snapper ? snapper->getSnapshots().size() : 0;
+}
+
+
+MetaSnapper::ConfigStamp
+MetaSnapper::stat_config() const
+{
+    vector<string> names = { CONFIGS_DIR "/" + config_info.get_config_name() };
+
+    for (const char* pattern : { ETC_FILTERS_DIR "/*.txt", USR_FILTERS_DIR "/*.txt" })
+    {
+	vector<string> tmp = glob(pattern, 0);
+	names.insert(names.end(), tmp.begin(), tmp.end());
+    }
+
+    ConfigStamp ret;
+
+    for (const string& name : names)
+    {
+	FileStamp file_stamp;
+	file_stamp.name = name;
+
+	struct stat buf;
+	if (stat(name.c_str(), &buf) == 0)
+	{
+	    file_stamp.ino = buf.st_ino;
+	    file_stamp.mtime = buf.st_mtim;
+	}
+
+	ret.push_back(file_stamp);
+    }
+
+    return ret;
+}
+
+
+void
+MetaSnapper::refresh()
+{
+    // A changed config file can change almost everything, e.g. the
+    // filesystem, so the snapper object is recreated. The same is done for
+    // changed, added or removed filter files.
+
+    if (stat_config() != config_stamp)
+    {
+	y2mil("config " << configName() << " changed, reloading");
+	unload();
+	return;
+    }
+
+    try
+    {
+	snapper->refreshSnapshots();
+    }
+    catch (const Exception& e)
+    {
+	SN_CAUGHT(e);
+
+	y2err("refreshing config " << configName() << " failed, reloading");
+	unload();
+    }
 }
 
 
@@ -25,6 +25,7 @@
 #define SNAPPER_META_SNAPPER_H
 
 
+#include <set>
 #include <boost/thread.hpp>
 
 #include <snapper/Snapper.h>
@@ -63,14 +64,61 @@ public:
     bool is_loaded() const { return snapper; }
     void unload();
 
+    /**
+     * Marks the loaded snapper object as possibly outdated. Instead of
+     * being loaded from scratch it is refreshed on next use.
+     */
+    void mark_stale() { stale = true; }
+    bool is_stale() const { return stale; }
+
+    /**
+     * Requests the cleanups of the config whose method calls arrived up
+     * to serial to stop before the next deletion. Cleanups requested
+     * later are not affected.
+     */
+    void cancel_cleanup(unsigned int serial) { cleanup_cancelled_serial = serial; }
+    bool is_cleanup_cancelled(unsigned int serial) const { return serial <= cleanup_cancelled_serial; }
+
+    /**
+     * Snapshots whose filesystem snapshot is deleted by a cleanup while
+     * big_mutex is released. They must not be used meanwhile.
+     */
+    set<unsigned int> deleting;
+
+    size_t loaded_snapshots() const;
+
 private:
 
+    struct FileStamp
+    {
+	string name;
+	ino_t ino = 0;
+	struct timespec mtime = { 0, 0 };
+
+	bool operator==(const FileStamp& rhs) const
+	    { return name == rhs.name && ino == rhs.ino && mtime.tv_sec == rhs.mtime.tv_sec &&
+		  mtime.tv_nsec == rhs.mtime.tv_nsec; }
+    };
+
+    // the config file and the filter files, see Snapper::loadIgnorePatterns()
+    typedef vector<FileStamp> ConfigStamp;
+
     void set_permissions();
 
+    ConfigStamp stat_config() const;
+
+    void refresh();
+
     ConfigInfo config_info;
 
     Snapper* snapper = nullptr;
 
+    bool stale = false;
+
+    unsigned int cleanup_cancelled_serial = 0;
+
+    ConfigStamp config_stamp;
+
     vector<uid_t> allowed_uids;
     vector<gid_t> allowed_gids;
 
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef SNAPPER_TRANSFER_TASK_H
+#define SNAPPER_TRANSFER_TASK_H
+
+
+#include <dbus/DBusPipe.h>
+
+#include <snapper/Exception.h>
+
+
+using namespace snapper;
+
+
+struct StreamException : Exception
+{
+    explicit StreamException() : Exception("stream exception") {}
+};
+
+
+/**
+ * Base class for data sent to the client through a pipe. The read end is
+ * passed to the client in the method reply, run() writes the data to the
+ * write end and is called by the files transfer thread of the client.
+ */
+class TransferTask
+{
+public:
+
+    virtual ~TransferTask() {}
+
+    DBus::FileDescriptor& get_read_end() { return pipe.get_read_end(); }
+    DBus::FileDescriptor& get_write_end() { return pipe.get_write_end(); }
+
+    virtual void run() = 0;
+
+private:
+
+    DBus::Pipe pipe;
+
+};
+
+
+#endif
@@ -26,6 +26,8 @@
 #include <signal.h>
 #include <iostream>
 #include <string>
+#include <vector>
+#include <algorithm>
 
 #include <snapper/Log.h>
 #include <dbus/DBusMainLoop.h>
@@ -45,6 +47,10 @@ const seconds snapper_cleanup_time(30);
 bool log_stdout = false;
 bool log_debug = false;
 
+// Maximal number of snapshots kept loaded for idle configs. With 0 idle
+// configs are unloaded.
+size_t keep_loaded = 0;
+
 
 class MyMainLoop : public DBus::MainLoop
 {
@@ -61,6 +67,9 @@ public:
 
 private:
 
+    void expire_snappers();
+    bool expire_pending() const;
+
     Backgrounds backgrounds;
     Clients clients;
 
@@ -105,7 +114,17 @@ MyMainLoop::method_call(DBus::Message& msg)
 	    set_idle_timeout(seconds(-1));
 	}
 
-	client->add_method_call_task(*this, msg);
+	if (msg.is_method_call(INTERFACE, "CancelCleanup"))
+	{
+	    // Handled right away since the method call worker of the client
+	    // might be busy with the cleanup to cancel.
+	    lock.unlock();
+	    client->dispatch(*this, msg);
+	}
+	else
+	{
+	    client->add_method_call_task(*this, msg);
+	}
     }
 }
 
@@ -149,14 +168,72 @@ MyMainLoop::periodic()
     if (clients.empty() && backgrounds.empty())
 	set_idle_timeout(idle_time);
 
+    expire_snappers();
+}
+
+
+void
+MyMainLoop::expire_snappers()
+{
+    if (keep_loaded == 0)
+    {
+	for (MetaSnappers::iterator it = meta_snappers.begin(); it != meta_snappers.end(); ++it)
+	{
+	    if (it->is_loaded() && it->unused_for() > snapper_cleanup_time)
+		it->unload();
+	}
+
+	return;
+    }
+
+    // Idle snappers are kept loaded but are refreshed on next use. If
+    // more snapshots than allowed are loaded the least recently used
+    // idle snappers are unloaded.
+
+    size_t loaded_snapshots = 0;
+
+    vector<MetaSnapper*> idle;
+
     for (MetaSnappers::iterator it = meta_snappers.begin(); it != meta_snappers.end(); ++it)
     {
-	if (it->is_loaded() && it->unused_for() > snapper_cleanup_time)
-	    it->unload();
+	if (!it->is_loaded())
+	    continue;
+
+	loaded_snapshots += it->loaded_snapshots();
+
+	if (it->use_count() == 0 && it->unused_for() > snapper_cleanup_time)
+	{
+	    it->mark_stale();
+	    idle.push_back(&*it);
+	}
+    }
+
+    sort(idle.begin(), idle.end(), [](const MetaSnapper* a, const MetaSnapper* b) {
+	return a->unused_for() > b->unused_for();
+    });
+
+    for (MetaSnapper* meta_snapper : idle)
+    {
+	if (loaded_snapshots <= keep_loaded)
+	    break;
+
+	loaded_snapshots -= meta_snapper->loaded_snapshots();
+	meta_snapper->unload();
     }
 }
 
 
+bool
+MyMainLoop::expire_pending() const
+{
+    for (MetaSnappers::const_iterator it = meta_snappers.begin(); it != meta_snappers.end(); ++it)
+	if (it->is_loaded() && it->use_count() == 0 && !it->is_stale())
+	    return true;
+
+    return false;
+}
+
+
 milliseconds
 MyMainLoop::periodic_timeout()
 {
@@ -168,9 +245,8 @@ MyMainLoop::periodic_timeout()
     if (!backgrounds.empty())
 	return seconds(1);
 
-    for (MetaSnappers::const_iterator it = meta_snappers.begin(); it != meta_snappers.end(); ++it)
-	if (it->is_loaded() && it->use_count() == 0)
-	    return seconds(1);
+    if (expire_pending())
+	return seconds(1);
 
     return seconds(-1);
 }
@@ -191,6 +267,13 @@ log_query(LogLevel level, const string& component)
 }
 
 
+void
+sighup_handler(int signum)
+{
+    reopenLogFile();
+}
+
+
 void usage() __attribute__ ((__noreturn__));
 
 void
@@ -212,6 +295,7 @@ help()
     cout << "    Options:" << endl
 	 << "\t--stdout, -s\t\t\tLog to stdout." << endl
 	 << "\t--debug, -d\t\t\tTurn on debugging." << endl
+	 << "\t--keep-loaded <number>\t\tKeep up to number snapshots of idle configs loaded." << endl
 	 << endl;
 
     exit(EXIT_SUCCESS);
@@ -224,6 +308,7 @@ main(int argc, char** argv)
     const struct option options[] = {
 	{ "stdout",		no_argument,		0,	's' },
 	{ "debug",		no_argument,		0,	'd' },
+	{ "keep-loaded",	required_argument,	0,	'k' },
 	{ "help",		no_argument,		0,	'h' },
 	{ 0, 0, 0, 0 }
     };
@@ -245,6 +330,19 @@ main(int argc, char** argv)
 		log_debug = true;
 		break;
 
+	    case 'k':
+	    {
+		char* end;
+		unsigned long tmp = strtoul(optarg, &end, 10);
+		if (*optarg == '\0' || *end != '\0')
+		{
+		    cerr << "snapperd: invalid number '" << optarg << "'" << endl;
+		    usage();
+		}
+		keep_loaded = tmp;
+	    }
+	    break;
+
 	    case 'h':
 		help();
 
@@ -265,6 +363,8 @@ main(int argc, char** argv)
     {
 	initDefaultLogger();
 	setLogQuery(&log_query);
+
+	signal(SIGHUP, sighup_handler);
     }
     else
     {
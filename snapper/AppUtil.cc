@@ -21,6 +21,8 @@
  */
 
 
+#include "config.h"
+
 #include <errno.h>
 #include <stdarg.h>
 #include <unistd.h>
@@ -33,6 +35,7 @@
 #include <sys/ioctl.h>
 #include <sys/types.h>
 #include <sys/sendfile.h>
+#include <linux/fs.h>
 #include <dirent.h>
 #include <mntent.h>
 #include <boost/algorithm/string.hpp>
@@ -76,10 +79,14 @@ namespace snapper
     bool
     clonefile(int src_fd, int dest_fd)
     {
-#define BTRFS_IOCTL_MAGIC 0x94
-#define BTRFS_IOC_CLONE _IOW(BTRFS_IOCTL_MAGIC, 9, int)
+	// FICLONE is the generic name of BTRFS_IOC_CLONE and also works on
+	// e.g. XFS with reflink support.
+
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+#endif
 
-	int r1 = ioctl(dest_fd, BTRFS_IOC_CLONE, src_fd);
+	int r1 = ioctl(dest_fd, FICLONE, src_fd);
 	if (r1 != 0)
 	{
 	    // TODO: too much logging with LVM
@@ -90,6 +97,83 @@ namespace snapper
     }
 
 
+    namespace
+    {
+
+	// Large enough to be efficient but small enough to keep the copy
+	// interruptible.
+	const size_t copy_chunk_size = 0x1000000;
+
+
+	/**
+	 * Copy length bytes at offset from src_fd to dest_fd. Uses
+	 * copy_file_range, which allows the kernel or the filesystem to
+	 * avoid copying to userspace or even share the data, and falls
+	 * back to sendfile.
+	 */
+	bool
+	copyrange(int src_fd, int dest_fd, off_t offset, off_t length, bool& use_copy_file_range)
+	{
+	    off_t end = offset + length;
+
+#ifdef HAVE_COPY_FILE_RANGE
+	    while (use_copy_file_range && offset < end)
+	    {
+		loff_t off_in = offset;
+		loff_t off_out = offset;
+
+		ssize_t r1 = copy_file_range(src_fd, &off_in, dest_fd, &off_out,
+					     min<off_t>(end - offset, copy_chunk_size), 0);
+		if (r1 > 0)
+		{
+		    offset += r1;
+		    continue;
+		}
+
+		if (r1 == 0)
+		    return true;	// file was truncated meanwhile
+
+		if (errno == EINTR)
+		    continue;
+
+		if (errno != EXDEV && errno != EINVAL && errno != ENOSYS && errno != EOPNOTSUPP)
+		{
+		    y2err("copy_file_range failed errno:" << errno << " (" << stringerror(errno) << ")");
+		    return false;
+		}
+
+		use_copy_file_range = false;
+	    }
+#endif
+
+	    if (offset < end && lseek(dest_fd, offset, SEEK_SET) != offset)
+	    {
+		y2err("lseek failed errno:" << errno << " (" << stringerror(errno) << ")");
+		return false;
+	    }
+
+	    while (offset < end)
+	    {
+		ssize_t r1 = sendfile(dest_fd, src_fd, &offset, min<off_t>(end - offset, copy_chunk_size));
+		if (r1 == 0)
+		    return true;
+
+		if (r1 < 0)
+		{
+		    if (errno == EINTR)
+			continue;
+
+		    y2err("sendfile failed errno:" << errno << " (" << stringerror(errno) << ")");
+		    return false;
+		}
+	    }
+
+	    return true;
+	}
+
+    }
+
+
     bool
     copyfile(int src_fd, int dest_fd)
     {
@@ -98,19 +182,62 @@ namespace snapper
 	// TODO: maybe use POSIX_FADV_DONTNEED on dest_fd, but this could
 	// trigger a kernel bug (see bsc #888259)
 
-	while (true)
+	struct stat st;
+	if (fstat(src_fd, &st) != 0)
 	{
-	    // use small value for count to make function better interruptible
-	    ssize_t r1 = sendfile(dest_fd, src_fd, NULL, 0x10000);
-	    if (r1 == 0)
-		return true;
+	    y2err("fstat failed errno:" << errno << " (" << stringerror(errno) << ")");
+	    return false;
+	}
+
+	bool use_copy_file_range = true;
+
+	// Only copy the data segments so that holes are preserved. dest_fd
+	// is empty and the final ftruncate also creates a trailing hole.
+
+	off_t data = 0;
+
+	while (data < st.st_size)
+	{
+	    data = lseek(src_fd, data, SEEK_DATA);
+	    if (data < 0)
+	    {
+		if (errno == ENXIO)
+		    break;		// only a hole left
+
+		if (errno != EINVAL)
+		{
+		    y2err("lseek failed errno:" << errno << " (" << stringerror(errno) << ")");
+		    return false;
+		}
+
+		// SEEK_DATA not supported, copy everything
+		if (!copyrange(src_fd, dest_fd, 0, st.st_size, use_copy_file_range))
+		    return false;
+		break;
+	    }
 
-	    if (r1 < 0)
+	    off_t hole = lseek(src_fd, data, SEEK_HOLE);
+	    if (hole < 0)
 	    {
-		y2err("sendfile failed errno:" << errno << " (" << stringerror(errno) << ")");
+		y2err("lseek failed errno:" << errno << " (" << stringerror(errno) << ")");
 		return false;
 	    }
+
+	    hole = min(hole, st.st_size);
+
+	    if (!copyrange(src_fd, dest_fd, data, hole - data, use_copy_file_range))
+		return false;
+
+	    data = hole;
+	}
+
+	if (ftruncate(dest_fd, st.st_size) != 0)
+	{
+	    y2err("ftruncate failed errno:" << errno << " (" << stringerror(errno) << ")");
+	    return false;
 	}
+
+	return true;
     }
 
 
@@ -37,6 +37,7 @@
 #include <vector>
 #include <stdexcept>
 #include <chrono>
+#include <functional>
 
 
 namespace snapper
@@ -170,6 +171,35 @@ namespace snapper
     };
 
 
+    /**
+     * Calls unlock on construction and lock on destruction. Both functions
+     * are optional. Used to release the lock of a caller during lengthy
+     * operations.
+     */
+    class Unlocker
+    {
+    public:
+
+	Unlocker(const std::function<void()>& unlock, const std::function<void()>& lock)
+	    : lock(lock)
+	{
+	    if (unlock)
+		unlock();
+	}
+
+	~Unlocker()
+	{
+	    if (lock)
+		lock();
+	}
+
+    private:
+
+	const std::function<void()>& lock;
+
+    };
+
+
     string sformat(const char* format, ...) __attribute__ ((format(printf, 1, 2)));
 
 
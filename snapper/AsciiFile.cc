@@ -21,9 +21,15 @@
  */
 
 
+#include "config.h"
+
 #include <unistd.h>
 #include <fcntl.h>
 #include <zlib.h>
+#ifdef ENABLE_ZSTD
+#include <zstd.h>
+#include <boost/thread.hpp>
+#endif
 #include <regex>
 #include <boost/algorithm/string.hpp>
 
@@ -50,7 +56,11 @@ namespace snapper
 		return true;
 
 	    case Compression::ZSTD:
+#ifdef ENABLE_ZSTD
+		return true;
+#else
 		return false;
+#endif
 	}
 
 	return false;
@@ -82,6 +92,7 @@ namespace snapper
     public:
 
 	class None;
+	class Buffered;
 	class Gzip;
 	class Zstd;
 
@@ -90,13 +101,30 @@ namespace snapper
 
 	virtual ~Impl() = default;
 
-	virtual bool read_line(string& line) = 0;
+	virtual bool read_line(const char*& line, size_t& size) = 0;
+
+	bool read_line(string& line);
 
 	virtual void close() = 0;
 
     };
 
 
+    bool
+    AsciiFileReader::Impl::read_line(string& line)
+    {
+	const char* data;
+	size_t size;
+
+	if (!read_line(data, size))
+	    return false;
+
+	line.assign(data, size);
+
+	return true;
+    }
+
+
     class AsciiFileReader::Impl::None : public AsciiFileReader::Impl
     {
     public:
@@ -107,7 +135,7 @@ namespace snapper
 
 	virtual ~None();
 
-	virtual bool read_line(string& line) override;
+	virtual bool read_line(const char*& line, size_t& size) override;
 
 	virtual void close() override;
 
@@ -163,7 +191,7 @@ namespace snapper
 
 
     bool
-    AsciiFileReader::Impl::None::read_line(string& line)
+    AsciiFileReader::Impl::None::read_line(const char*& line, size_t& size)
     {
 	ssize_t n = getline(&buffer, &len, fin);
 	if (n == -1)
@@ -172,7 +200,8 @@ namespace snapper
 	if (n > 0 && buffer[n - 1] == '\n')
 	    n--;
 
-	line = string(buffer, 0, n);
+	line = buffer;
+	size = n;
 
 	return true;
     }
@@ -193,7 +222,79 @@ namespace snapper
     }
 
 
-    class AsciiFileReader::Impl::Gzip : public AsciiFileReader::Impl
+    /**
+     * Base for readers decompressing into a buffer. Lines are returned
+     * directly from the buffer unless they span a refill.
+     */
+    class AsciiFileReader::Impl::Buffered : public AsciiFileReader::Impl
+    {
+    public:
+
+	virtual bool read_line(const char*& line, size_t& size) override;
+
+    protected:
+
+	vector<char> buffer;
+	size_t buffer_read = 0;		// position to which the buffer has been read
+	size_t buffer_fill = 0;		// position to which the buffer is filled
+
+	virtual bool read_buffer() = 0;
+
+    private:
+
+	string spill;			// line spanning a refill of the buffer
+
+    };
+
+
+    bool
+    AsciiFileReader::Impl::Buffered::read_line(const char*& line, size_t& size)
+    {
+	spill.clear();
+
+	while (true)
+	{
+	    // check if all of the output buffer has been used
+	    if (buffer_read == buffer_fill)
+	    {
+		if (!read_buffer())
+		{
+		    line = spill.data();
+		    size = spill.size();
+		    return !spill.empty();
+		}
+	    }
+
+	    const char* p1 = buffer.data() + buffer_read;
+	    size_t remaining = buffer_fill - buffer_read;
+
+	    const char* p2 = (const char*) memchr(p1, '\n', remaining);
+
+	    if (p2)
+	    {
+		buffer_read = p2 - buffer.data() + 1;
+
+		if (spill.empty())
+		{
+		    line = p1;
+		    size = p2 - p1;
+		    return true;
+		}
+
+		spill.append(p1, p2 - p1);
+
+		line = spill.data();
+		size = spill.size();
+		return true;
+	    }
+
+	    spill.append(p1, remaining);
+	    buffer_read += remaining;
+	}
+    }
+
+
+    class AsciiFileReader::Impl::Gzip : public AsciiFileReader::Impl::Buffered
     {
     public:
 
@@ -203,8 +304,6 @@ namespace snapper
 
 	virtual ~Gzip();
 
-	virtual bool read_line(string& line) override;
-
 	virtual void close() override;
 
     private:
@@ -213,11 +312,7 @@ namespace snapper
 
 	gzFile gz_file = nullptr;
 
-	vector<char> buffer;
-	size_t buffer_read = 0;		// position to which the buffer has been read
-	size_t buffer_fill = 0;		// position to which the buffer is filled
-
-	bool read_buffer();
+	virtual bool read_buffer() override;
 
     };
 
@@ -326,37 +421,165 @@ namespace snapper
     }
 
 
-    bool
-    AsciiFileReader::Impl::Gzip::read_line(string& line)
+#ifdef ENABLE_ZSTD
+
+    class AsciiFileReader::Impl::Zstd : public AsciiFileReader::Impl::Buffered
+    {
+    public:
+
+	Zstd(int fd);
+	Zstd(FILE* fin);
+	Zstd(const string& name);
+
+	virtual ~Zstd();
+
+	virtual void close() override;
+
+    private:
+
+	Zstd();
+
+	FILE* fin = nullptr;
+
+	ZSTD_DCtx* dctx = nullptr;
+
+	vector<char> in_buffer;
+	ZSTD_inBuffer input = { nullptr, 0, 0 };
+	bool eof = false;
+
+	size_t frame_remaining = 0;	// non-zero if the current frame is incomplete
+	bool flush_pending = false;	// decompressor may hold more output
+
+	virtual bool read_buffer() override;
+
+    };
+
+
+    AsciiFileReader::Impl::Zstd::Zstd()
+    {
+	dctx = ZSTD_createDCtx();
+	if (!dctx)
+	    SN_THROW(Exception("ZSTD_createDCtx failed"));
+
+	in_buffer.resize(ZSTD_DStreamInSize());
+	buffer.resize(ZSTD_DStreamOutSize());
+
+	input.src = in_buffer.data();
+    }
+
+
+    AsciiFileReader::Impl::Zstd::Zstd(int fd)
+	: Zstd()
+    {
+	fin = fdopen(fd, "r");
+	if (!fin)
+	    SN_THROW(IOErrorException(sformat("fdopen failed, errno:%d (%s)", errno,
+					      stringerror(errno).c_str())));
+    }
+
+
+    AsciiFileReader::Impl::Zstd::Zstd(FILE* fin)
+	: Zstd()
+    {
+	Zstd::fin = fin;
+    }
+
+
+    AsciiFileReader::Impl::Zstd::Zstd(const string& name)
+	: Zstd()
+    {
+	fin = fopen(name.c_str(), "re");
+	if (!fin)
+	    SN_THROW(IOErrorException(sformat("fopen '%s' for reading failed, errno:%d (%s)",
+					      name.c_str(), errno, stringerror(errno).c_str())));
+    }
+
+
+    AsciiFileReader::Impl::Zstd::~Zstd()
+    {
+	try
+	{
+	    close();
+	}
+	catch (const Exception& e)
+	{
+	    SN_CAUGHT(e);
+
+	    y2err("exception ignored");
+	}
+
+	ZSTD_freeDCtx(dctx);
+    }
+
+
+    void
+    AsciiFileReader::Impl::Zstd::close()
     {
-	line.clear();
+	if (!fin)
+	    return;
+
+	FILE* tmp = fin;
+	fin = nullptr;
+
+	if (fclose(tmp) != 0)
+	    SN_THROW(IOErrorException(sformat("fclose failed, errno:%d (%s)", errno,
+					      stringerror(errno).c_str())));
+    }
 
+
+    bool
+    AsciiFileReader::Impl::Zstd::read_buffer()
+    {
 	while (true)
 	{
-	    // check if all of the output buffer has been used
-	    if (buffer_read == buffer_fill)
+	    // refill the input buffer unless the decompressor still has
+	    // output from the previous input
+	    if (input.pos == input.size && !flush_pending)
 	    {
-		if (!read_buffer())
-		    return !line.empty();
+		if (eof)
+		{
+		    if (frame_remaining != 0)
+			SN_THROW(IOErrorException("zstd stream truncated"));
+
+		    return false;
+		}
+
+		size_t n = fread(in_buffer.data(), 1, in_buffer.size(), fin);
+		if (n == 0)
+		{
+		    if (ferror(fin))
+			SN_THROW(IOErrorException(sformat("fread failed, errno:%d (%s)", errno,
+							  stringerror(errno).c_str())));
+
+		    eof = true;
+		    continue;
+		}
+
+		input.size = n;
+		input.pos = 0;
 	    }
 
-	    const char* p1 = buffer.data() + buffer_read;
-	    size_t remaining = buffer_fill - buffer_read;
+	    ZSTD_outBuffer output = { buffer.data(), buffer.size(), 0 };
 
-	    const char* p2 = (const char*) memchr(p1, '\n', remaining);
+	    size_t r = ZSTD_decompressStream(dctx, &output, &input);
+	    if (ZSTD_isError(r))
+		SN_THROW(IOErrorException(sformat("ZSTD_decompressStream failed (%s)",
+						  ZSTD_getErrorName(r))));
 
-	    if (p2)
+	    frame_remaining = r;
+	    flush_pending = output.pos == output.size;
+
+	    if (output.pos > 0)
 	    {
-		line += string(p1, p2 - p1);
-		buffer_read = p2 - buffer.data() + 1;
+		buffer_read = 0;
+		buffer_fill = output.pos;
 		return true;
 	    }
-
-	    line += string(p1, remaining);
-	    buffer_read += remaining;
 	}
     }
 
+#endif
+
 
     template <typename T>
     std::unique_ptr<AsciiFileReader::Impl>
@@ -371,7 +594,11 @@ namespace snapper
 		return unique_ptr<Impl::Gzip>(new Impl::Gzip(t));
 
 	    case Compression::ZSTD:
+#ifdef ENABLE_ZSTD
+		return unique_ptr<Impl::Zstd>(new Impl::Zstd(t));
+#else
 		break;
+#endif
 	}
 
 	SN_THROW(LogicErrorException("unknown or unsupported compression"));
@@ -409,6 +636,13 @@ namespace snapper
     }
 
 
+    bool
+    AsciiFileReader::read_line(const char*& line, size_t& size)
+    {
+	return impl->read_line(line, size);
+    }
+
+
     void
     AsciiFileReader::close()
     {
@@ -676,9 +910,7 @@ namespace snapper
     }
 
 
-#if 0
-
-    // Needs libzstd >= 1.4. So unfortunately currently not suitable.
+#ifdef ENABLE_ZSTD
 
     class AsciiFileWriter::Impl::Zstd : public AsciiFileWriter::Impl
     {
@@ -718,7 +950,7 @@ namespace snapper
 	if (!cctx)
 	    SN_THROW(Exception("ZSTD_createCCtx failed"));
 
-	size_t r1 = ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, 8);
+	size_t r1 = ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, 3);
 	if (ZSTD_isError(r1))
 	    SN_THROW(Exception("ZSTD_CCtx_setParameter with ZSTD_c_compressionLevel failed"));
 
@@ -726,6 +958,18 @@ namespace snapper
 	if (ZSTD_isError(r2))
 	    SN_THROW(Exception("ZSTD_CCtx_setParameter with ZSTD_c_checksumFlag failed"));
 
+	// Compressing in worker threads only helps for big file lists
+	// since zstd splits the input in jobs of several MiB. Fails if
+	// libzstd is built without multithreading support.
+
+	int workers = min(boost::thread::hardware_concurrency(), 4U);
+	if (workers > 1)
+	{
+	    size_t r3 = ZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers, workers);
+	    if (ZSTD_isError(r3))
+		y2deb("ZSTD_CCtx_setParameter with ZSTD_c_nbWorkers failed");
+	}
+
 	in_buffer.resize(ZSTD_CStreamInSize());
 	out_buffer.resize(ZSTD_CStreamOutSize());
     }
@@ -800,19 +1044,21 @@ namespace snapper
 	ZSTD_inBuffer input = { in_buffer.data(), in_buffer_fill, 0 };
 
 	while (true)
-        {
+	{
 	    ZSTD_outBuffer output = { out_buffer.data(), out_buffer.size(), 0 };
 
 	    size_t remaining = ZSTD_compressStream2(cctx, &output, &input, mode);
 	    if (ZSTD_isError(remaining))
-		SN_THROW(Exception("ZSTD_compressStream2 failed"));
+		SN_THROW(IOErrorException(sformat("ZSTD_compressStream2 failed (%s)",
+						  ZSTD_getErrorName(remaining))));
 
 	    size_t written = fwrite(output.dst, 1, output.pos, fout);
 	    if (written != output.pos)
-		SN_THROW(IOErrorException(""));
+		SN_THROW(IOErrorException(sformat("fwrite failed, errno:%d (%s)", errno,
+						  stringerror(errno).c_str())));
 
 	    if (last ? (remaining == 0) : (input.pos == input.size))
-                break;
+		break;
 	}
 
 	in_buffer_fill = 0;
@@ -859,7 +1105,11 @@ namespace snapper
 		return unique_ptr<Impl::Gzip>(new Impl::Gzip(t));
 
 	    case Compression::ZSTD:
+#ifdef ENABLE_ZSTD
+		return unique_ptr<Impl::Zstd>(new Impl::Zstd(t));
+#else
 		break;
+#endif
 	}
 
 	SN_THROW(LogicErrorException("unknown or unsupported compression"));
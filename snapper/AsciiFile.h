@@ -66,6 +66,13 @@ namespace snapper
 
 	bool read_line(string& line);
 
+	/**
+	 * Like read_line(string&) but without copying the line. The
+	 * returned data is not null-terminated and only valid until the
+	 * next call.
+	 */
+	bool read_line(const char*& line, size_t& size);
+
 	void close();
 
     private:
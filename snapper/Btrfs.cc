@@ -56,6 +56,7 @@
 #include "snapper/SnapperDefines.h"
 #include "snapper/Acls.h"
 #include "snapper/Exception.h"
+#include "snapper/IgnorePatterns.h"
 #ifdef ENABLE_ROLLBACK
 #include "snapper/MntTable.h"
 #endif
@@ -517,6 +518,8 @@ namespace snapper
 
 	void dump(const string& prefix = "") const;
 
+	unsigned int count() const;
+
 	unsigned int check(StreamProcessor* processor, const string& name, unsigned int status) const;
 	void check(StreamProcessor* processor, const string& prefix = "");
 
@@ -659,12 +662,17 @@ namespace snapper
     {
     public:
 
-	StreamProcessor(const SDir& base, const SDir& dir1, const SDir& dir2);
+	StreamProcessor(const SDir& base, const SDir& dir1, const SDir& dir2,
+			const IgnorePatterns* ignore_patterns);
 
 	const SDir& base;
 	const SDir& dir1;
 	const SDir& dir2;
 
+	const IgnorePatterns* ignore_patterns;
+
+	unsigned int skipped = 0;
+
 	void process(cmpdirs_cb_t cb);
 
 	tree_node files;
@@ -713,21 +721,40 @@ namespace snapper
     }
 
 
+    unsigned int
+    tree_node::count() const
+    {
+	unsigned int ret = childs.size();
+
+	for (const_iterator it = childs.begin(); it != childs.end(); ++it)
+	    ret += it->second.count();
+
+	return ret;
+    }
+
+
     void
     tree_node::check(StreamProcessor* processor, const string& prefix)
     {
-	for (iterator it = childs.begin(); it != childs.end(); ++it)
+	for (iterator it = childs.begin(); it != childs.end();)
 	{
-	    if (prefix.empty())
-	    {
-		it->second.status = check(processor, it->first, it->second.status);
-		it->second.check(processor, it->first);
-	    }
-	    else
+	    string name = prefix.empty() ? it->first : prefix + "/" + it->first;
+
+	    // Ignored subtrees are dropped before comparing any file in
+	    // them, they would be filtered out afterwards anyway.
+
+	    if (processor->ignore_patterns && processor->ignore_patterns->match("/" + name))
 	    {
-		it->second.status = check(processor, prefix + "/" + it->first, it->second.status);
-		it->second.check(processor, prefix + "/" + it->first);
+		processor->skipped += 1 + it->second.count();
+
+		it = childs.erase(it);
+		continue;
 	    }
+
+	    it->second.status = check(processor, name, it->second.status);
+	    it->second.check(processor, name);
+
+	    ++it;
 	}
     }
 
@@ -753,8 +780,10 @@ namespace snapper
     }
 
 
-    StreamProcessor::StreamProcessor(const SDir& base, const SDir& dir1, const SDir& dir2)
-	: base(base), dir1(dir1), dir2(dir2)
+    StreamProcessor::StreamProcessor(const SDir& base, const SDir& dir1, const SDir& dir2,
+				     const IgnorePatterns* ignore_patterns)
+	: base(base), dir1(dir1), dir2(dir2),
+	  ignore_patterns(ignore_patterns && !ignore_patterns->empty() ? ignore_patterns : nullptr)
     {
 	memset(&sus, 0, sizeof(sus));
 	int r = subvol_uuid_search_init(base.fd(), &sus);
@@ -1397,12 +1426,17 @@ namespace snapper
 	do_send(parent_root_id, clone_sources);
 
 	files.check(&*this);
+
+	if (ignore_patterns)
+	    y2mil("skipped " << skipped << " ignored entries");
+
 	files.result(cb);
     }
 
 
     void
-    Btrfs::cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb) const
+    Btrfs::cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb,
+		   const IgnorePatterns* ignore_patterns) const
     {
 	y2mil("special btrfs cmpDirs");
 
@@ -1412,7 +1446,7 @@ namespace snapper
 
 	    const SDir subvolume(openSubvolumeDir());
 
-	    StreamProcessor processor(subvolume, dir1, dir2);
+	    StreamProcessor processor(subvolume, dir1, dir2, ignore_patterns);
 
 	    processor.process(cb);
 
@@ -1423,7 +1457,7 @@ namespace snapper
 	    y2err("special btrfs cmpDirs failed, " << e.what());
 	    y2mil("cmpDirs fallback");
 
-	    snapper::cmpDirs(dir1, dir2, cb);
+	    snapper::cmpDirs(dir1, dir2, cb, ignore_patterns);
 	}
     }
 
@@ -1432,9 +1466,10 @@ namespace snapper
 
 
     void
-    Btrfs::cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb) const
+    Btrfs::cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb,
+		   const IgnorePatterns* ignore_patterns) const
     {
-	snapper::cmpDirs(dir1, dir2, cb);
+	snapper::cmpDirs(dir1, dir2, cb, ignore_patterns);
     }
 
 
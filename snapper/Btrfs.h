@@ -80,7 +80,8 @@ namespace snapper
 
 	virtual bool checkSnapshot(unsigned int num) const override;
 
-	virtual void cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb) const override;
+	virtual void cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb,
+			     const IgnorePatterns* ignore_patterns = nullptr) const override;
 
 	virtual bool isDefault(unsigned int num) const override;
 
@@ -39,6 +39,7 @@
 #include "snapper/Exception.h"
 #include "snapper/XAttributes.h"
 #include "snapper/Acls.h"
+#include "snapper/IgnorePatterns.h"
 
 
 namespace snapper
@@ -180,20 +181,6 @@ namespace snapper
     {
 	unsigned int status = 0;
 
-        /*
-         * NOTE: just for a consideration
-         *
-         * if both ctimes are in match, files should be same
-         * ctime can be altered only by some debugfs tool and
-         * on umounted fs (ext2,3,4, xfs). So this should be safe
-         * unless root or CAP_SYS_ADMIN played with low-level fs
-         * utilities, right?
-         *
-         * if ((stat1.st_ctime == stat2.st_ctime))
-         *      return status;
-         *
-         */
-
 	if ((stat1.st_mode & S_IFMT) != (stat2.st_mode & S_IFMT))
 	{
 	    status |= TYPE;
@@ -223,7 +210,18 @@ namespace snapper
 #ifdef ENABLE_XATTRS
 	if (file1.xaSupported() && file2.xaSupported())
 	{
-	    status |= cmpFilesXattrs(file1, file2);
+	    // Setting or removing extended attributes changes the ctime. So if
+	    // the inode number and the ctime match the extended attributes
+	    // cannot have changed. Only st_ino is compared since on btrfs
+	    // every subvolume, and thus every snapshot, has its own st_dev.
+	    //
+	    // Two changes within one tick of the ctime clock cannot be told
+	    // apart. If the ctime has no nanoseconds the filesystem likely
+	    // only stores seconds, so the check is not used.
+
+	    if (stat1.st_ino != stat2.st_ino || stat1.st_ctim.tv_sec != stat2.st_ctim.tv_sec ||
+		stat1.st_ctim.tv_nsec != stat2.st_ctim.tv_nsec || stat1.st_ctim.tv_nsec == 0)
+		status |= cmpFilesXattrs(file1, file2);
 	}
 #endif
 
@@ -256,18 +254,37 @@ namespace snapper
     }
 
 
+    struct CmpData
+    {
+	dev_t dev1;
+	dev_t dev2;
+
+	cmpdirs_cb_t cb;
+
+	const IgnorePatterns* ignore_patterns;
+
+	mutable unsigned int skipped;
+    };
+
+
     bool
-    filter(const string& name)
+    filter(const CmpData& cmp_data, const string& name)
     {
 	if (name == "/.snapshots")
 	    return true;
 
+	if (cmp_data.ignore_patterns && cmp_data.ignore_patterns->match(name))
+	{
+	    ++cmp_data.skipped;
+	    return true;
+	}
+
 	return false;
     }
 
 
     void
-    listSubdirs(const SDir& dir, const string& path, unsigned int status, cmpdirs_cb_t cb)
+    listSubdirs(const CmpData& cmp_data, const SDir& dir, const string& path, unsigned int status)
     {
 	boost::this_thread::interruption_point();
 
@@ -275,37 +292,31 @@ namespace snapper
 
 	for (vector<string>::const_iterator it = entries.begin(); it != entries.end(); ++it)
 	{
-	    cb(path + "/" + *it, status);
+	    if (cmp_data.ignore_patterns && filter(cmp_data, path + "/" + *it))
+		continue;
+
+	    cmp_data.cb(path + "/" + *it, status);
 
 	    struct stat stat;
 	    dir.stat(*it, &stat, AT_SYMLINK_NOFOLLOW);
 	    if (S_ISDIR(stat.st_mode))
-		listSubdirs(SDir(dir, *it), path + "/" + *it, status, cb);
+		listSubdirs(cmp_data, SDir(dir, *it), path + "/" + *it, status);
 	}
     }
 
 
-    struct CmpData
-    {
-	dev_t dev1;
-	dev_t dev2;
-
-	cmpdirs_cb_t cb;
-    };
-
-
     void
     cmpDirsWorker(const CmpData& cmp_data, const SDir& dir1, const SDir& dir2, const string& path);
 
 
     void
-    lonesome(const SDir& dir, const string& path, const string& name, const struct stat& stat,
-	     unsigned int status, cmpdirs_cb_t cb)
+    lonesome(const CmpData& cmp_data, const SDir& dir, const string& path, const string& name,
+	     const struct stat& stat, unsigned int status)
     {
-	cb(path + "/" + name, status);
+	cmp_data.cb(path + "/" + name, status);
 
 	if (S_ISDIR(stat.st_mode))
-	    listSubdirs(SDir(dir, name), path + "/" + name, status, cb);
+	    listSubdirs(cmp_data, SDir(dir, name), path + "/" + name, status);
     }
 
 
@@ -332,11 +343,11 @@ namespace snapper
 	{
 	    if (S_ISDIR(stat1.st_mode))
 		if (stat1.st_dev == cmp_data.dev1)
-		    listSubdirs(SDir(dir1, name), path + "/" + name, DELETED, cmp_data.cb);
+		    listSubdirs(cmp_data, SDir(dir1, name), path + "/" + name, DELETED);
 
 	    if (S_ISDIR(stat2.st_mode))
 		if (stat2.st_dev == cmp_data.dev2)
-		    listSubdirs(SDir(dir2, name), path + "/" + name, CREATED, cmp_data.cb);
+		    listSubdirs(cmp_data, SDir(dir2, name), path + "/" + name, CREATED);
 	}
     }
 
@@ -358,11 +369,11 @@ namespace snapper
 
 	while (first1 != last1 || first2 != last2)
 	{
-	    if (first1 != last1 && filter(path + "/" + *first1))
+	    if (first1 != last1 && filter(cmp_data, path + "/" + *first1))
 	    {
 		++first1;
 	    }
-	    else if (first2 != last2 && filter(path + "/" + *first2))
+	    else if (first2 != last2 && filter(cmp_data, path + "/" + *first2))
 	    {
 		++first2;
 	    }
@@ -372,7 +383,7 @@ namespace snapper
 		dir2.stat(*first2, &stat2, AT_SYMLINK_NOFOLLOW); // TODO error check
 
 		if (stat2.st_dev == cmp_data.dev2)
-		    lonesome(dir2, path, *first2, stat2, CREATED, cmp_data.cb);
+		    lonesome(cmp_data, dir2, path, *first2, stat2, CREATED);
 
 		++first2;
 	    }
@@ -382,7 +393,7 @@ namespace snapper
 		dir1.stat(*first1, &stat1, AT_SYMLINK_NOFOLLOW); // TODO error check
 
 		if (stat1.st_dev == cmp_data.dev1)
-		    lonesome(dir1, path, *first1, stat1, DELETED, cmp_data.cb);
+		    lonesome(cmp_data, dir1, path, *first1, stat1, DELETED);
 
 		++first1;
 	    }
@@ -392,7 +403,7 @@ namespace snapper
 		dir2.stat(*first2, &stat2, AT_SYMLINK_NOFOLLOW); // TODO error check
 
 		if (stat2.st_dev == cmp_data.dev2)
-		    lonesome(dir2, path, *first2, stat2, CREATED, cmp_data.cb);
+		    lonesome(cmp_data, dir2, path, *first2, stat2, CREATED);
 
 		++first2;
 	    }
@@ -402,7 +413,7 @@ namespace snapper
 		dir1.stat(*first1, &stat1, AT_SYMLINK_NOFOLLOW); // TODO error check
 
 		if (stat1.st_dev == cmp_data.dev1)
-		    lonesome(dir1, path, *first1, stat1, DELETED, cmp_data.cb);
+		    lonesome(cmp_data, dir1, path, *first1, stat1, DELETED);
 
 		++first1;
 	    }
@@ -426,7 +437,8 @@ namespace snapper
 
 
     void
-    cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb)
+    cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb,
+	    const IgnorePatterns* ignore_patterns)
     {
 	y2mil("path1:" << dir1.fullname() << " path2:" << dir2.fullname());
 
@@ -446,18 +458,94 @@ namespace snapper
 	cmp_data.cb = cb;
 	cmp_data.dev1 = stat1.st_dev;
 	cmp_data.dev2 = stat2.st_dev;
+	cmp_data.ignore_patterns = ignore_patterns && !ignore_patterns->empty() ? ignore_patterns : nullptr;
+	cmp_data.skipped = 0;
 
 	y2mil("dev1:" << cmp_data.dev1 << " dev2:" << cmp_data.dev2);
 
 	StopWatch stopwatch;
 	cmpDirsWorker(cmp_data, dir1, dir2, "");
 	y2mil("stopwatch " << stopwatch << " for comparing directories");
+
+	if (cmp_data.ignore_patterns)
+	    y2mil("skipped " << cmp_data.skipped << " ignored entries");
     }
 
 
+    /*
+     * The extended attributes of a file in one buffer, each entry consisting
+     * of the name, a '\0' and the value. Much cheaper to build and compare
+     * than XAttributes.
+     */
+    class FlatXattrs
+    {
+    public:
+
+	bool read(const SFile& file)
+	{
+	    if (!file.readxattrs([this](const char* name, const uint8_t* value, size_t size) {
+		size_t offset = data.size();
+		data.append(name, strlen(name) + 1);
+		data.append((const char*) value, size);
+		entries.emplace_back(offset, data.size() - offset);
+	    }))
+		return false;
+
+	    // The order of the names is not defined so sort by name.
+
+	    sort_entries();
+
+	    return true;
+	}
+
+	bool operator==(const FlatXattrs& rhs) const
+	{
+	    if (entries.size() != rhs.entries.size())
+		return false;
+
+	    for (size_t i = 0; i < entries.size(); ++i)
+	    {
+		if (entries[i].second != rhs.entries[i].second ||
+		    memcmp(data.data() + entries[i].first, rhs.data.data() + rhs.entries[i].first,
+			   entries[i].second) != 0)
+		    return false;
+	    }
+
+	    return true;
+	}
+
+    private:
+
+	void sort_entries()
+	{
+	    const char* p = data.data();
+
+	    sort(entries.begin(), entries.end(), [p](const pair<size_t, size_t>& a,
+						     const pair<size_t, size_t>& b) {
+		return strcmp(p + a.first, p + b.first) < 0;
+	    });
+	}
+
+	string data;
+
+	// offset and length of the entries in data
+	vector<pair<size_t, size_t>> entries;
+
+    };
+
+
     unsigned int
     cmpFilesXattrs(const SFile& file1, const SFile& file2)
     {
+	// Only build the XAttributes and CompareAcls objects if the extended
+	// attributes differ. If reading fails here let XAttributes report it.
+
+	FlatXattrs flat1;
+	FlatXattrs flat2;
+
+	if (flat1.read(file1) && flat2.read(file2) && flat1 == flat2)
+	    return 0;
+
         try
         {
 	    XAttributes xa(file1);
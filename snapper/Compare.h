@@ -36,6 +36,9 @@ namespace snapper
     using std::string;
 
 
+    class IgnorePatterns;
+
+
     typedef std::function<void(const string& name, unsigned int status)> cmpdirs_cb_t;
 
 
@@ -44,9 +47,11 @@ namespace snapper
     cmpFiles(const SFile& file1, const SFile& file2);
 
     /* Compares the two directories. All file-operations use the openat
-       et.al. functions. */
+       et.al. functions. Entries matching the ignore patterns are skipped
+       including their subtrees. */
     void
-    cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb);
+    cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb,
+	    const IgnorePatterns* ignore_patterns = nullptr);
 
     /* Compares the two files extended attributes and ACLs.
        Returns 0 or XATTRS or (XATTRS | ACL) */
@@ -29,6 +29,7 @@
 #include <string.h>
 #include <errno.h>
 #include <regex>
+#include <boost/thread.hpp>
 
 #include "snapper/Comparison.h"
 #include "snapper/Snapper.h"
@@ -40,6 +41,7 @@
 #include "snapper/AsciiFile.h"
 #include "snapper/Filesystem.h"
 #include "snapper/ComparisonImpl.h"
+#include "snapper/IgnorePatterns.h"
 
 
 namespace snapper
@@ -51,6 +53,27 @@ namespace snapper
 			   Snapshots::const_iterator snapshot2, bool mount)
 	: snapper(snapper), snapshot1(snapshot1), snapshot2(snapshot2), mount(mount),
 	  files(&file_paths)
+    {
+	setup();
+
+	initialize();
+
+	if (mount)
+	    do_mount();
+    }
+
+
+    Comparison::Comparison(const Snapper* snapper, Snapshots::const_iterator snapshot1,
+			   Snapshots::const_iterator snapshot2)
+	: snapper(snapper), snapshot1(snapshot1), snapshot2(snapshot2), mount(false),
+	  files(&file_paths)
+    {
+	setup();
+    }
+
+
+    void
+    Comparison::setup()
     {
 	if (snapshot1 == snapper->getSnapshots().end() ||
 	    snapshot2 == snapper->getSnapshots().end() ||
@@ -62,11 +85,6 @@ namespace snapper
 	file_paths.system_path = snapper->subvolumeDir();
 	file_paths.pre_path = snapshot1->snapshotDir();
 	file_paths.post_path = snapshot2->snapshotDir();
-
-	initialize();
-
-	if (mount)
-	    do_mount();
     }
 
 
@@ -77,36 +95,41 @@ namespace snapper
     }
 
 
-    void
-    Comparison::initialize()
+    bool
+    Comparison::is_fixed() const
     {
 	// When booting a snapshot the current snapshot could be read-only.
 	// But which snapshot is booted as current snapshot might not be constant.
 
-	bool fixed = !getSnapshot1()->isCurrent() && !getSnapshot2()->isCurrent();
+	if (getSnapshot1()->isCurrent() || getSnapshot2()->isCurrent())
+	    return false;
 
-	if (fixed)
+	try
 	{
-	    try
-	    {
-		fixed = getSnapshot1()->isReadOnly() && getSnapshot2()->isReadOnly();
-	    }
-	    catch (const runtime_error& e)
-	    {
-		y2err("failed to query read-only status, " << e.what());
-		fixed = false;
-	    }
+	    return getSnapshot1()->isReadOnly() && getSnapshot2()->isReadOnly();
 	}
+	catch (const runtime_error& e)
+	{
+	    y2err("failed to query read-only status, " << e.what());
+	    return false;
+	}
+    }
 
-	if (!fixed)
+
+    void
+    Comparison::initialize()
+    {
+	if (!is_fixed())
 	{
-	    create();
+	    // Not saved, so ignored subtrees can be skipped right away.
+	    create(true);
 	}
 	else
 	{
 	    if (!load())
 	    {
-		create();
+		// The saved filelist must not depend on the ignore patterns.
+		create(false);
 		save();
 	    }
 	}
@@ -136,12 +159,15 @@ namespace snapper
 
 
     void
-    Comparison::create()
+    Comparison::create(bool prune)
     {
-	y2mil("num1:" << getSnapshot1()->getNum() << " num2:" << getSnapshot2()->getNum());
+	y2mil("num1:" << getSnapshot1()->getNum() << " num2:" << getSnapshot2()->getNum() <<
+	      " prune:" << prune);
 
 	files.clear();
 
+	const IgnorePatterns ignore_patterns(prune ? getSnapper()->getIgnorePatterns() : vector<string>());
+
 	cmpdirs_cb_t cb = [this](const string& name, unsigned int status) {
 	    files.push_back(File(&file_paths, name, status));
 	};
@@ -151,7 +177,7 @@ namespace snapper
 	{
 	    SDir dir1 = getSnapshot1()->openSnapshotDir();
 	    SDir dir2 = getSnapshot2()->openSnapshotDir();
-	    snapper->getFilesystem()->cmpDirs(dir1, dir2, cb);
+	    snapper->getFilesystem()->cmpDirs(dir1, dir2, cb, &ignore_patterns);
 	}
 
 	do_umount();
@@ -162,6 +188,143 @@ namespace snapper
     }
 
 
+    bool
+    Comparison::is_empty()
+    {
+	if (is_fixed() && load())
+	{
+	    filter();
+	    return files.empty();
+	}
+
+	// The callback throws on the first relevant difference to stop
+	// comparing. Not derived from Exception so that the fallback in
+	// Btrfs::cmpDirs does not catch it.
+
+	struct DifferenceFound {};
+
+	const IgnorePatterns ignore_patterns(getSnapper()->getIgnorePatterns());
+
+	cmpdirs_cb_t cb = [&ignore_patterns](const string& name, unsigned int status) {
+	    if (!ignore_patterns.match(name))
+		throw DifferenceFound();
+	};
+
+	try
+	{
+	    SDir dir1 = getSnapshot1()->openSnapshotDir();
+	    SDir dir2 = getSnapshot2()->openSnapshotDir();
+	    snapper->getFilesystem()->cmpDirs(dir1, dir2, cb, &ignore_patterns);
+	}
+	catch (const DifferenceFound&)
+	{
+	    return false;
+	}
+
+	return true;
+    }
+
+
+    vector<bool>
+    Comparison::areEmpty(const Snapper* snapper, const vector<snapshot_pair_t>& pairs,
+			 unsigned int jobs, const std::function<void()>& unlock,
+			 const std::function<void()>& lock)
+    {
+	if (jobs == 0)
+	    jobs = max(boost::thread::hardware_concurrency(), 1U);
+
+	// Mounting is not thread-safe, so all snapshots are mounted
+	// upfront and unmounted afterwards, both with the lock of the
+	// caller held.
+
+	vector<Snapshots::const_iterator> mounted;
+
+	std::function<void()> umount_all = [&mounted]() {
+	    for (Snapshots::const_iterator snapshot : mounted)
+		snapshot->umountFilesystemSnapshot(false);
+	};
+
+	vector<char> result(pairs.size(), false);
+
+	boost::mutex mutex;
+	size_t next = 0;
+	std::exception_ptr exception;
+
+	std::function<void()> worker = [&]() {
+	    while (true)
+	    {
+		size_t i;
+
+		{
+		    boost::lock_guard<boost::mutex> lock(mutex);
+		    if (next == pairs.size() || exception)
+			break;
+		    i = next++;
+		}
+
+		try
+		{
+		    Comparison comparison(snapper, pairs[i].first, pairs[i].second);
+		    result[i] = comparison.is_empty();
+		}
+		catch (...)
+		{
+		    boost::lock_guard<boost::mutex> lock(mutex);
+		    if (!exception)
+			exception = std::current_exception();
+		}
+	    }
+	};
+
+	try
+	{
+	    for (const snapshot_pair_t& pair : pairs)
+	    {
+		if (pair.first == snapper->getSnapshots().end() ||
+		    pair.second == snapper->getSnapshots().end() || pair.first == pair.second)
+		    SN_THROW(IllegalSnapshotException());
+
+		for (Snapshots::const_iterator snapshot : { pair.first, pair.second })
+		{
+		    if (!snapshot->isCurrent())
+		    {
+			snapshot->mountFilesystemSnapshot(false);
+			mounted.push_back(snapshot);
+		    }
+		}
+	    }
+
+	    Unlocker unlocker(unlock, lock);
+
+	    if (jobs == 1 || pairs.size() < 2)
+	    {
+		worker();
+	    }
+	    else
+	    {
+		boost::thread_group threads;
+
+		for (unsigned int i = 0; i < min<size_t>(jobs, pairs.size()); ++i)
+		    threads.create_thread(worker);
+
+		threads.join_all();
+	    }
+	}
+	catch (...)
+	{
+	    umount_all();
+	    throw;
+	}
+
+	umount_all();
+
+	if (exception)
+	    std::rethrow_exception(exception);
+
+	return vector<bool>(result.begin(), result.end());
+    }
+
+
     bool
     Comparison::check_header(const string& line) const
     {
@@ -211,13 +374,18 @@ namespace snapper
 
 	    bool first = true;
 
-	    string line;
-	    while (ascii_file_reader.read_line(line))
+	    const char* line;
+	    size_t size;
+	    while (ascii_file_reader.read_line(line, size))
 	    {
+		// header and footer start with "snapper-", file lines with
+		// the status
+		bool maybe_marker = size > 8 && memcmp(line, "snapper-", 8) == 0;
+
 		if (first)
 		{
 		    first = false;
-		    if (check_header(line))
+		    if (maybe_marker && check_header(string(line, size)))
 		    {
 			has_header = true;
 			continue;
@@ -225,25 +393,23 @@ namespace snapper
 		}
 		else
 		{
-		    if (has_header && check_footer(line))
+		    if (has_header && maybe_marker && check_footer(string(line, size)))
 		    {
 			has_footer = true;
 			break;
 		    }
 		}
 
-		string::size_type pos = line.find(" ");
-		if (pos == string::npos)
+		const char* pos = (const char*) memchr(line, ' ', size);
+		if (!pos)
 		    SN_THROW(Exception("separator space not found"));
 
-		unsigned int status = stringToStatus(string(line, 0, pos));
-		string name = string(line, pos + 1);
+		unsigned int status = stringToStatus(string(line, pos));
 
 		if (invert)
 		    status = invertStatus(status);
 
-		File file(&file_paths, name, status);
-		files.push_back(file);
+		files.push_back(File(&file_paths, string(pos + 1, line + size), status));
 	    }
 
 	    ascii_file_reader.close();
@@ -289,7 +455,7 @@ namespace snapper
 
 	    string name = filelist_name(num1);
 
-	    for (Compression compression : { Compression::GZIP, Compression::NONE })
+	    for (Compression compression : { Compression::ZSTD, Compression::GZIP, Compression::NONE })
 	    {
 		if (!is_available(compression))
 		    continue;
@@ -25,6 +25,8 @@
 #define SNAPPER_COMPARISON_H
 
 
+#include <functional>
+
 #include "snapper/Snapshot.h"
 #include "snapper/Snapper.h"
 #include "snapper/File.h"
@@ -63,10 +65,52 @@ namespace snapper
 
 	bool doUndoStep(const UndoStep& undo_step);
 
+	typedef std::pair<Snapshots::const_iterator, Snapshots::const_iterator> snapshot_pair_t;
+
+	/**
+	 * Check for each pair of snapshots whether a comparison would
+	 * contain no files. Saved filelists are used if available,
+	 * otherwise comparing stops at the first difference not matching
+	 * the ignore patterns. Nothing is saved. Up to jobs threads are
+	 * used, 0 for the number of CPUs.
+	 *
+	 * Mounting and unmounting the snapshots is not thread-safe and is
+	 * done by the calling thread. If provided, unlock and lock are
+	 * called before and after comparing, e.g. to release a mutex
+	 * protecting the snapshots only while comparing.
+	 */
+	static vector<bool> areEmpty(const Snapper* snapper, const vector<snapshot_pair_t>& pairs,
+				     unsigned int jobs, const std::function<void()>& unlock = nullptr,
+				     const std::function<void()>& lock = nullptr);
+
     private:
 
+	/**
+	 * Create a comparison without comparing the snapshots.
+	 */
+	Comparison(const Snapper* snapper, Snapshots::const_iterator snapshot1,
+		   Snapshots::const_iterator snapshot2);
+
+	void setup();
+
 	void initialize();
-	void create();
+
+	/**
+	 * Return true iff the comparison can be saved, so both snapshots
+	 * are read-only.
+	 */
+	bool is_fixed() const;
+
+	/**
+	 * Return true iff the comparison would contain no files.
+	 */
+	bool is_empty();
+
+	/**
+	 * Compare the snapshots. If prune is true, subtrees matching the
+	 * ignore patterns are skipped while walking the directories.
+	 */
+	void create(bool prune);
 
 	/**
 	 * Check the header. Throws if the header is unsupported. Return true iff a header
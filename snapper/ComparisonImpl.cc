@@ -43,7 +43,7 @@ namespace snapper
     bool
     is_filelist_file(unsigned char type, const char* name)
     {
-	static const regex rx("filelist-([0-9]+).txt(\\.gz)?", regex::extended);
+	static const regex rx("filelist-([0-9]+).txt(\\.gz|\\.zst)?", regex::extended);
 
 	if (type != DT_UNKNOWN && type != DT_REG)
 	    return false;
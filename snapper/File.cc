@@ -27,11 +27,17 @@
 #include <sys/types.h>
 #include <string.h>
 #include <unistd.h>
-#include <fnmatch.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <locale>
+#include <queue>
+#include <functional>
+#include <unordered_map>
+#include <map>
+#include <memory>
+#include <exception>
 #include <boost/algorithm/string.hpp>
+#include <boost/thread.hpp>
 
 #include "snapper/File.h"
 #include "snapper/Snapper.h"
@@ -43,6 +49,7 @@
 #include "snapper/Exception.h"
 #include "snapper/XAttributes.h"
 #include "snapper/Acls.h"
+#include "snapper/IgnorePatterns.h"
 
 
 namespace snapper
@@ -95,11 +102,12 @@ namespace snapper
     void
     Files::filter(const vector<string>& ignore_patterns)
     {
-	std::function<bool(const File&)> pred = [&ignore_patterns](const File& file) {
-	    for (const string& ignore_pattern : ignore_patterns)
-		if (fnmatch(ignore_pattern.c_str(), file.getName().c_str(), FNM_LEADING_DIR) == 0)
-		    return true;
-	    return false;
+	const IgnorePatterns matcher(ignore_patterns);
+	if (matcher.empty())
+	    return;
+
+	std::function<bool(const File&)> pred = [&matcher](const File& file) {
+	    return matcher.match(file.getName());
 	};
 
 	entries.erase(remove_if(entries.begin(), entries.end(), pred), entries.end());
@@ -109,7 +117,13 @@ namespace snapper
     bool
     cmp_lt(const string& lhs, const string& rhs)
     {
-	const std::collate<char>& c = std::use_facet<std::collate<char>>(std::locale());
+	const std::locale locale;
+
+	// In the C locale collation is the byte order.
+	if (locale == std::locale::classic())
+	    return lhs < rhs;
+
+	const std::collate<char>& c = std::use_facet<std::collate<char>>(locale);
 
 	return c.compare(lhs.c_str(), lhs.c_str() + lhs.length(),
 			 rhs.c_str(), rhs.c_str() + rhs.length()) < 0;
@@ -133,7 +147,41 @@ namespace snapper
     void
     Files::sort()
     {
-	std::sort(entries.begin(), entries.end());
+	const std::locale locale;
+
+	if (locale == std::locale::classic())
+	{
+	    std::sort(entries.begin(), entries.end(), [](const File& lhs, const File& rhs) {
+		return lhs.getName() < rhs.getName();
+	    });
+
+	    return;
+	}
+
+	// Transforming every name once into its collation key and sorting
+	// the keys bytewise is much cheaper than a locale-aware comparison
+	// for every pair of names. The result is the same as with cmp_lt.
+
+	const std::collate<char>& c = std::use_facet<std::collate<char>>(locale);
+
+	vector<std::pair<string, size_t>> keys;
+	keys.reserve(entries.size());
+
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+	    const string& name = entries[i].getName();
+	    keys.emplace_back(c.transform(name.data(), name.data() + name.size()), i);
+	}
+
+	std::sort(keys.begin(), keys.end());
+
+	vector<File> tmp;
+	tmp.reserve(entries.size());
+
+	for (const std::pair<string, size_t>& key : keys)
+	    tmp.push_back(std::move(entries[key.second]));
+
+	entries.swap(tmp);
     }
 
 
@@ -190,21 +238,133 @@ namespace snapper
     }
 
 
-    unsigned int
-    File::getPreToSystemStatus()
+    namespace
     {
-	if (pre_to_system_status == (unsigned int)(-1))
+
+	/*
+	 * Opens directories below a base path, every path component relative
+	 * to its parent. Only the last directory is kept open, so comparing
+	 * the files of one directory opens it only once while the number of
+	 * open file descriptors stays bounded. A directory is missing, cached
+	 * as nullptr, only if a path component does not exist or is no
+	 * directory. Other errors, e.g. EMFILE or EACCES, throw.
+	 */
+	class DirCache
+	{
+	public:
+
+	    DirCache(const string& base_path) : base(base_path) {}
+
+	    const SDir* open(const string& path);
+
+	private:
+
+	    SDir base;
+
+	    bool valid = false;
+	    string last_path;
+	    std::unique_ptr<SDir> last_dir;
+
+	};
+
+
+	const SDir*
+	DirCache::open(const string& path)
 	{
-	    SDir dir1(file_paths->pre_path);
-	    SDir dir2(file_paths->system_path);
+	    if (path == "/")
+		return &base;
+
+	    if (valid && path == last_path)
+		return last_dir.get();
+
+	    valid = false;
+	    last_dir.reset();
 
+	    std::unique_ptr<SDir> dir;
+	    const SDir* current = &base;
+
+	    string::size_type pos1 = 1;
+	    while (pos1 <= path.size())
+	    {
+		string::size_type pos2 = path.find('/', pos1);
+		if (pos2 == string::npos)
+		    pos2 = path.size();
+
+		const string name = path.substr(pos1, pos2 - pos1);
+		pos1 = pos2 + 1;
+
+		struct stat buf;
+		if (current->stat(name, &buf, AT_SYMLINK_NOFOLLOW) != 0)
+		{
+		    if (errno != ENOENT && errno != ENOTDIR)
+			SN_THROW(IOErrorException(sformat("stat failed path:%s errno:%d (%s)",
+							  current->fullname(name).c_str(), errno,
+							  stringerror(errno).c_str())));
+
+		    current = nullptr;
+		    break;
+		}
+
+		if (!S_ISDIR(buf.st_mode))
+		{
+		    current = nullptr;
+		    break;
+		}
+
+		std::unique_ptr<SDir> tmp(new SDir(*current, name));
+		dir = std::move(tmp);
+		current = dir.get();
+	    }
+
+	    valid = true;
+	    last_path = path;
+	    if (current)
+		last_dir = std::move(dir);
+
+	    return last_dir.get();
+	}
+
+
+	/*
+	 * Compares a file in two trees. If the parent directory is missing
+	 * in one tree the file is created or deleted.
+	 */
+	unsigned int
+	cmpFiles(DirCache& dirs1, DirCache& dirs2, const string& name)
+	{
 	    string dirname = snapper::dirname(name);
 	    string basename = snapper::basename(name);
 
-	    SDir subdir1 = SDir::deepopen(dir1, dirname);
-	    SDir subdir2 = SDir::deepopen(dir2, dirname);
+	    const SDir* dir1 = dirs1.open(dirname);
+	    const SDir* dir2 = dirs2.open(dirname);
+
+	    if (dir1 && dir2)
+		return cmpFiles(SFile(*dir1, basename), SFile(*dir2, basename));
+
+	    struct stat buf;
 
-	    pre_to_system_status = cmpFiles(SFile(subdir1, basename), SFile(subdir2, basename));
+	    if (dir1 && SFile(*dir1, basename).stat(&buf, AT_SYMLINK_NOFOLLOW) == 0)
+		return DELETED;
+
+	    if (dir2 && SFile(*dir2, basename).stat(&buf, AT_SYMLINK_NOFOLLOW) == 0)
+		return CREATED;
+
+	    SN_THROW(IOErrorException("stat failed path:" + name));
+	    __builtin_unreachable();
+	}
+
+    }
+
+
+    unsigned int
+    File::getPreToSystemStatus()
+    {
+	if (pre_to_system_status == (unsigned int)(-1))
+	{
+	    DirCache dirs1(file_paths->pre_path);
+	    DirCache dirs2(file_paths->system_path);
+
+	    pre_to_system_status = cmpFiles(dirs1, dirs2, name);
 	}
 
 	return pre_to_system_status;
@@ -216,16 +376,10 @@ namespace snapper
     {
 	if (post_to_system_status == (unsigned int)(-1))
 	{
-	    SDir dir1(file_paths->post_path);
-	    SDir dir2(file_paths->system_path);
+	    DirCache dirs1(file_paths->post_path);
+	    DirCache dirs2(file_paths->system_path);
 
-	    string dirname = snapper::dirname(name);
-	    string basename = snapper::basename(name);
-
-	    SDir subdir1 = SDir::deepopen(dir1, dirname);
-	    SDir subdir2 = SDir::deepopen(dir2, dirname);
-
-	    post_to_system_status = cmpFiles(SFile(subdir1, basename), SFile(subdir2, basename));
+	    post_to_system_status = cmpFiles(dirs1, dirs2, name);
 	}
 
 	return post_to_system_status;
@@ -299,7 +453,10 @@ namespace snapper
 	if (!createParentDirectories(leading_path))
 	    return false;
 
-	if (mkdir(leading_path.c_str(), 0777) != 0)
+	// The directory can exist if it was created in the meantime by a
+	// concurrent undo step.
+
+	if (mkdir(leading_path.c_str(), 0777) != 0 && !(errno == EEXIST && checkDir(leading_path)))
 	{
 	    y2err("mkdir failed path:" << leading_path << " errno:" << errno << " (" <<
 		  stringerror(errno) << ")");
@@ -770,6 +927,336 @@ namespace snapper
     }
 
 
+    namespace
+    {
+
+	/*
+	 * Runs a function for files in parallel while respecting the
+	 * directory hierarchy. Each file depends on the nearest ancestor
+	 * directory also included in the files. Top-down the ancestor must
+	 * be processed first, bottom-up all descendants must be processed
+	 * first. If the function fails for a file, the files depending on it
+	 * are skipped. Ready files are taken in the given order, so with one
+	 * job the files are processed exactly in that order.
+	 */
+	class UndoScheduler
+	{
+	public:
+
+	    typedef std::function<bool(File& file, bool skip)> func_t;
+
+	    UndoScheduler(const vector<File*>& files, bool top_down);
+
+	    void run(unsigned int jobs, func_t func);
+
+	private:
+
+	    void worker(func_t func);
+
+	    struct Node
+	    {
+		File* file;
+		unsigned int pending = 0;
+		bool skip = false;
+		vector<size_t> successors;
+	    };
+
+	    vector<Node> nodes;
+
+	    boost::mutex mutex;
+	    boost::condition_variable condition;
+
+	    std::priority_queue<size_t, vector<size_t>, std::greater<size_t>> ready;
+	    size_t remaining = 0;
+
+	    std::exception_ptr exception;
+
+	};
+
+
+	UndoScheduler::UndoScheduler(const vector<File*>& files, bool top_down)
+	{
+	    std::unordered_map<string, size_t> indices;
+
+	    nodes.reserve(files.size());
+	    for (File* file : files)
+	    {
+		indices.emplace(file->getName(), nodes.size());
+		nodes.emplace_back();
+		nodes.back().file = file;
+	    }
+
+	    for (size_t i = 0; i < nodes.size(); ++i)
+	    {
+		string name = nodes[i].file->getName();
+
+		while (true)
+		{
+		    string::size_type pos = name.rfind('/');
+		    if (pos == 0 || pos == string::npos)
+			break;
+
+		    name.erase(pos);
+
+		    std::unordered_map<string, size_t>::const_iterator it = indices.find(name);
+		    if (it != indices.end())
+		    {
+			size_t parent = it->second;
+
+			if (top_down)
+			{
+			    nodes[parent].successors.push_back(i);
+			    nodes[i].pending++;
+			}
+			else
+			{
+			    nodes[i].successors.push_back(parent);
+			    nodes[parent].pending++;
+			}
+
+			break;
+		    }
+		}
+	    }
+
+	    for (size_t i = 0; i < nodes.size(); ++i)
+	    {
+		if (nodes[i].pending == 0)
+		    ready.push(i);
+	    }
+
+	    remaining = nodes.size();
+	}
+
+
+	void
+	UndoScheduler::run(unsigned int jobs, func_t func)
+	{
+	    if (jobs == 1)
+	    {
+		worker(func);
+	    }
+	    else
+	    {
+		boost::thread_group threads;
+
+		for (unsigned int i = 0; i < std::min<size_t>(jobs, nodes.size()); ++i)
+		    threads.create_thread(boost::bind(&UndoScheduler::worker, this, func));
+
+		threads.join_all();
+	    }
+
+	    if (exception)
+		std::rethrow_exception(exception);
+	}
+
+
+	void
+	UndoScheduler::worker(func_t func)
+	{
+	    boost::unique_lock<boost::mutex> lock(mutex);
+
+	    while (true)
+	    {
+		while (ready.empty() && remaining > 0)
+		    condition.wait(lock);
+
+		if (remaining == 0)
+		    break;
+
+		size_t i = ready.top();
+		ready.pop();
+
+		bool skip = nodes[i].skip;
+
+		lock.unlock();
+
+		bool ok = false;
+
+		try
+		{
+		    ok = func(*nodes[i].file, skip);
+		}
+		catch (...)
+		{
+		    boost::lock_guard<boost::mutex> tmp(mutex);
+		    if (!exception)
+			exception = std::current_exception();
+		}
+
+		lock.lock();
+
+		for (size_t successor : nodes[i].successors)
+		{
+		    if (!ok)
+			nodes[successor].skip = true;
+
+		    if (--nodes[successor].pending == 0)
+			ready.push(successor);
+		}
+
+		--remaining;
+
+		condition.notify_all();
+	    }
+	}
+
+    }
+
+
+    bool
+    Files::doUndo(unsigned int jobs, undo_start_callback_t start_callback, undo_callback_t callback)
+    {
+	if (jobs == 0)
+	    jobs = std::max(boost::thread::hardware_concurrency(), 1U);
+
+	// Same split and order as in getUndoSteps().
+
+	vector<File*> deletions;
+	vector<File*> others;
+
+	for (File& file : entries)
+	{
+	    if (file.getUndo())
+	    {
+		if (file.getPreToPostStatus() == CREATED)
+		    deletions.push_back(&file);
+		else
+		    others.push_back(&file);
+	    }
+	}
+
+	std::reverse(deletions.begin(), deletions.end());
+
+	bool ok = true;
+	boost::mutex callback_mutex;
+
+	// A step whose parent step failed (top-down) or whose child step
+	// failed (bottom-up) is not tried since it would fail anyway. It is
+	// still reported as failed. All other steps are done in any case.
+
+	UndoScheduler::func_t func = [&ok, &callback_mutex, &start_callback, &callback](File& file,
+										     bool skip) {
+	    {
+		boost::lock_guard<boost::mutex> lock(callback_mutex);
+
+		if (start_callback)
+		    start_callback(file);
+	    }
+
+	    bool tmp = !skip && file.doUndo();
+
+	    boost::lock_guard<boost::mutex> lock(callback_mutex);
+
+	    if (!tmp)
+		ok = false;
+
+	    if (callback)
+		callback(file, tmp);
+
+	    return tmp;
+	};
+
+	UndoScheduler(deletions, false).run(jobs, func);
+	UndoScheduler(others, true).run(jobs, func);
+
+	return ok;
+    }
+
+
+    void
+    Files::calculateStatus(Cmp cmp, unsigned int jobs, file_pred_t pred)
+    {
+	if (cmp == CMP_PRE_TO_POST)
+	    return;
+
+	if (jobs == 0)
+	    jobs = std::max(boost::thread::hardware_concurrency(), 1U);
+
+	// Group the files by directory so that a worker compares all files
+	// of a directory with the same opened directories. The DirCache of
+	// a worker only keeps the directories of the current group open.
+
+	std::map<string, vector<File*>> tmp;
+
+	for (File& file : entries)
+	{
+	    unsigned int status = cmp == CMP_PRE_TO_SYSTEM ? file.pre_to_system_status :
+		file.post_to_system_status;
+	    if (status != (unsigned int)(-1))
+		continue;
+
+	    if (!pred || pred(file))
+		tmp[snapper::dirname(file.getName())].push_back(&file);
+	}
+
+	vector<vector<File*>> groups;
+	groups.reserve(tmp.size());
+	for (std::map<string, vector<File*>>::value_type& value : tmp)
+	    groups.push_back(std::move(value.second));
+
+	const string& path1 = cmp == CMP_PRE_TO_SYSTEM ? file_paths->pre_path : file_paths->post_path;
+	const string& path2 = file_paths->system_path;
+
+	boost::mutex mutex;
+	size_t next = 0;
+	std::exception_ptr exception;
+
+	std::function<void()> worker = [&]() {
+	    DirCache dirs1(path1);
+	    DirCache dirs2(path2);
+
+	    while (true)
+	    {
+		size_t i;
+
+		{
+		    boost::lock_guard<boost::mutex> lock(mutex);
+		    if (next == groups.size() || exception)
+			break;
+		    i = next++;
+		}
+
+		try
+		{
+		    for (File* file : groups[i])
+		    {
+			unsigned int status = cmpFiles(dirs1, dirs2, file->getName());
+
+			if (cmp == CMP_PRE_TO_SYSTEM)
+			    file->pre_to_system_status = status;
+			else
+			    file->post_to_system_status = status;
+		    }
+		}
+		catch (...)
+		{
+		    boost::lock_guard<boost::mutex> lock(mutex);
+		    if (!exception)
+			exception = std::current_exception();
+		}
+	    }
+	};
+
+	if (jobs == 1 || groups.size() < 2)
+	{
+	    worker();
+	}
+	else
+	{
+	    boost::thread_group threads;
+
+	    for (unsigned int i = 0; i < std::min<size_t>(jobs, groups.size()); ++i)
+		threads.create_thread(worker);
+
+	    threads.join_all();
+	}
+
+	if (exception)
+	    std::rethrow_exception(exception);
+    }
+
+
     string
     statusToString(unsigned int status)
     {
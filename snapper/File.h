@@ -29,6 +29,7 @@
 
 #include <string>
 #include <vector>
+#include <functional>
 
 
 namespace snapper
@@ -112,6 +113,8 @@ namespace snapper
     {
     public:
 
+	friend class Files;
+
 	File(const FilePaths* file_paths, const string& name, unsigned int pre_to_post_status)
 	    : file_paths(file_paths), name(name), pre_to_post_status(pre_to_post_status)
 	{}
@@ -211,6 +214,33 @@ namespace snapper
 
 	bool doUndoStep(const UndoStep& undo_step);
 
+	typedef std::function<void(const File& file)> undo_start_callback_t;
+	typedef std::function<void(const File& file, bool ok)> undo_callback_t;
+
+	/**
+	 * Undo all files with the undo flag set. Deletions are done first
+	 * bottom-up, afterwards creations and modifications top-down (same
+	 * order as getUndoSteps()). Files not depending on each other, e.g.
+	 * in different subtrees, are processed by up to jobs threads, 0 for
+	 * the number of CPUs. A failed step does not stop the undo, only
+	 * the steps depending on it are skipped and reported as failed.
+	 *
+	 * The start callback is called before and the callback after every
+	 * step, never concurrently. Returns false if any step failed.
+	 */
+	bool doUndo(unsigned int jobs, undo_start_callback_t start_callback, undo_callback_t callback);
+
+	typedef std::function<bool(const File& file)> file_pred_t;
+
+	/**
+	 * Calculate the pre-to-system or post-to-system status of all files,
+	 * or only of the files the predicate returns true for, in one pass.
+	 * The files are grouped by directory so that every directory is
+	 * opened only once. Up to jobs threads are used, 0 for the number
+	 * of CPUs. Afterwards getStatus() returns the cached statuses.
+	 */
+	void calculateStatus(Cmp cmp, unsigned int jobs, file_pred_t pred = nullptr);
+
 	XAUndoStatistic getXAUndoStatistic() const;
 
     private:
@@ -219,6 +249,7 @@ namespace snapper
 	 * After using push_back, sort must be called before using any find function.
 	 */
 	void push_back(const File& file) { entries.push_back(file); }
+	void push_back(File&& file) { entries.push_back(std::move(file)); }
 
 	void sort();
 
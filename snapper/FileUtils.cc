@@ -40,6 +40,7 @@
 #include <selinux/selinux.h>
 #endif
 #include <algorithm>
+#include <boost/noncopyable.hpp>
 
 #include "snapper/FileUtils.h"
 #include "snapper/AppUtil.h"
@@ -465,75 +466,220 @@ namespace snapper
     }
 
 
-    ssize_t
-    SDir::listxattr(const string& path, char* list, size_t size) const
+    namespace
     {
-	assert(path.find('/') == string::npos);
-	assert(path != "..");
 
-	int fd = ::openat(dirfd, path.c_str(), O_RDONLY | O_NOFOLLOW | O_NONBLOCK | O_NOATIME |
-			  O_CLOEXEC);
-	if (fd >= 0)
+	/*
+	 * Access to the extended attributes of a file. Files that cannot be
+	 * opened (symlinks, device nodes without driver, fifos) are opened
+	 * with O_PATH and accessed via /proc/self/fd since the f*xattr
+	 * functions do not work with O_PATH file descriptors. Only if /proc
+	 * is not available the current working directory is changed.
+	 */
+	class XaFile : private boost::noncopyable
 	{
-	    ssize_t r1 = ::flistxattr(fd, list, size);
-	    ::close(fd);
-	    return r1;
-	}
-	else if (errno == ELOOP || errno == ENXIO || errno == EWOULDBLOCK)
+	public:
+
+	    XaFile(int dirfd, const string& name, boost::mutex& cwd_mutex);
+	    ~XaFile();
+
+	    bool is_open() const { return mode != Mode::NONE; }
+
+	    ssize_t list(char* list, size_t size) const;
+	    ssize_t get(const char* xa_name, void* value, size_t size) const;
+
+	private:
+
+	    enum class Mode { NONE, FD, PROC, CWD };
+
+	    Mode mode = Mode::NONE;
+
+	    const string name;
+
+	    int fd = -1;
+
+	    string proc_path;
+
+	    boost::unique_lock<boost::mutex> cwd_lock;
+
+	};
+
+
+	XaFile::XaFile(int dirfd, const string& name, boost::mutex& cwd_mutex)
+	    : name(name)
 	{
-	    boost::lock_guard<boost::mutex> lock(cwd_mutex);
+	    assert(name.find('/') == string::npos);
+	    assert(name != "..");
 
-	    int r1 = fchdir(dirfd);
-	    if (r1 != 0)
+	    fd = ::openat(dirfd, name.c_str(), O_RDONLY | O_NOFOLLOW | O_NONBLOCK | O_NOATIME |
+			  O_CLOEXEC);
+	    if (fd >= 0)
+	    {
+		mode = Mode::FD;
+		return;
+	    }
+
+	    if (errno != ELOOP && errno != ENXIO && errno != EWOULDBLOCK)
+		return;
+
+	    if (::access("/proc/self/fd", F_OK) == 0)
+	    {
+		fd = ::openat(dirfd, name.c_str(), O_PATH | O_NOFOLLOW | O_CLOEXEC);
+		if (fd < 0)
+		    return;
+
+		proc_path = "/proc/self/fd/" + to_string(fd);
+		mode = Mode::PROC;
+		return;
+	    }
+
+	    cwd_lock = boost::unique_lock<boost::mutex>(cwd_mutex);
+
+	    if (fchdir(dirfd) != 0)
 	    {
 		y2err("fchdir failed errno:" << errno << " (" << stringerror(errno) << ")");
-		return -1;
+		return;
 	    }
 
-	    ssize_t r2 = ::llistxattr(path.c_str(), list, size);
-	    chdir("/");
-	    return r2;
+	    mode = Mode::CWD;
 	}
-	else
+
+
+	XaFile::~XaFile()
+	{
+	    int saved_errno = errno;
+
+	    if (fd >= 0)
+		::close(fd);
+
+	    if (mode == Mode::CWD)
+		chdir("/");
+
+	    errno = saved_errno;
+	}
+
+
+	ssize_t
+	XaFile::list(char* list, size_t size) const
+	{
+	    switch (mode)
+	    {
+		case Mode::FD:
+		    return ::flistxattr(fd, list, size);
+
+		case Mode::PROC:
+		    // Follows the magic link but not the symlink it refers to.
+		    return ::listxattr(proc_path.c_str(), list, size);
+
+		case Mode::CWD:
+		    return ::llistxattr(name.c_str(), list, size);
+
+		case Mode::NONE:
+		    break;
+	    }
+
+	    errno = EBADF;
+	    return -1;
+	}
+
+
+	ssize_t
+	XaFile::get(const char* xa_name, void* value, size_t size) const
 	{
+	    switch (mode)
+	    {
+		case Mode::FD:
+		    return ::fgetxattr(fd, xa_name, value, size);
+
+		case Mode::PROC:
+		    return ::getxattr(proc_path.c_str(), xa_name, value, size);
+
+		case Mode::CWD:
+		    return ::lgetxattr(name.c_str(), xa_name, value, size);
+
+		case Mode::NONE:
+		    break;
+	    }
+
+	    errno = EBADF;
 	    return -1;
 	}
+
+    }
+
+
+    ssize_t
+    SDir::listxattr(const string& path, char* list, size_t size) const
+    {
+	XaFile xa_file(dirfd, path, cwd_mutex);
+	if (!xa_file.is_open())
+	    return -1;
+
+	return xa_file.list(list, size);
     }
 
 
     ssize_t
     SDir::getxattr(const string& path, const char* name, void* value, size_t size) const
     {
-	assert(path.find('/') == string::npos);
-	assert(path != "..");
+	XaFile xa_file(dirfd, path, cwd_mutex);
+	if (!xa_file.is_open())
+	    return -1;
 
-	int fd = ::openat(dirfd, path.c_str(), O_RDONLY | O_NOFOLLOW | O_NONBLOCK | O_NOATIME |
-			  O_CLOEXEC);
-	if (fd >= 0)
+	return xa_file.get(name, value, size);
+    }
+
+
+    bool
+    SDir::readxattrs(const string& path, xattrs_callback_t callback) const
+    {
+	XaFile xa_file(dirfd, path, cwd_mutex);
+	if (!xa_file.is_open())
+	    return false;
+
+	// Start with buffers large enough for typical attributes (e.g. SELinux
+	// labels and ACLs) and only query the size if they are too small.
+
+	vector<char> names(1024);
+
+	ssize_t names_size;
+	while ((names_size = xa_file.list(names.data(), names.size())) < 0)
 	{
-	    ssize_t r1 = ::fgetxattr(fd, name, value, size);
-	    ::close(fd);
-	    return r1;
+	    if (errno != ERANGE)
+		return false;
+
+	    ssize_t tmp = xa_file.list(nullptr, 0);
+	    if (tmp < 0)
+		return false;
+
+	    names.resize(max((size_t) tmp, 2 * names.size()));
 	}
-	else if (errno == ELOOP || errno == ENXIO || errno == EWOULDBLOCK)
+
+	vector<uint8_t> value(1024);
+
+	ssize_t pos = 0;
+	while (pos < names_size)
 	{
-	    boost::lock_guard<boost::mutex> lock(cwd_mutex);
+	    const char* name = names.data() + pos;
+	    pos += strlen(name) + 1;
 
-	    int r1 = fchdir(dirfd);
-	    if (r1 != 0)
+	    ssize_t value_size;
+	    while ((value_size = xa_file.get(name, value.data(), value.size())) < 0)
 	    {
-		y2err("fchdir failed errno:" << errno << " (" << stringerror(errno) << ")");
-		return -1;
+		if (errno != ERANGE)
+		    return false;
+
+		ssize_t tmp = xa_file.get(name, nullptr, 0);
+		if (tmp < 0)
+		    return false;
+
+		value.resize(max((size_t) tmp, 2 * value.size()));
 	    }
 
-	    ssize_t r2 = ::lgetxattr(path.c_str(), name, value, size);
-	    chdir("/");
-	    return r2;
-	}
-	else
-	{
-	    return -1;
+	    callback(name, value.data(), value_size);
 	}
+
+	return true;
     }
 
 
@@ -849,6 +995,13 @@ namespace snapper
     }
 
 
+    bool
+    SFile::readxattrs(SDir::xattrs_callback_t callback) const
+    {
+	return dir.readxattrs(name, callback);
+    }
+
+
     void
     SFile::fsetfilecon(char* con) const
     {
@@ -49,8 +49,9 @@ namespace snapper
     /*
      * The member functions of SDir and SFile are secure (avoid race
      * conditions, see openat(2)) by using either openat and alike functions
-     * or by modifying the current working directory (e.g. mount, umount,
-     * listxattr and getxattr).
+     * or by modifying the current working directory (e.g. mount and umount).
+     * The extended attribute functions only modify the current working
+     * directory if /proc is not available.
      */
 
     class SDir
@@ -104,6 +105,13 @@ namespace snapper
 	ssize_t listxattr(const string& path, char* list, size_t size) const;
 	ssize_t getxattr(const string& path, const char* name, void* value, size_t size) const;
 
+	typedef std::function<void(const char* name, const uint8_t* value, size_t size)> xattrs_callback_t;
+
+	// Reads the names and values of all extended attributes of path
+	// calling callback for each. Usually needs only one syscall per
+	// attribute. Returns false and sets errno on failure.
+	bool readxattrs(const string& path, xattrs_callback_t callback) const;
+
 	bool mount(const string& device, const string& mount_type, unsigned long mount_flags,
 		   const string& mount_data) const;
 	bool umount(const string& mount_point) const;
@@ -146,6 +154,8 @@ namespace snapper
 	ssize_t listxattr(char* list, size_t size) const;
 	ssize_t getxattr(const char* name, void* value, size_t size) const;
 
+	bool readxattrs(SDir::xattrs_callback_t callback) const;
+
 	void fsetfilecon(char* con) const;
 	void restorecon(SelinuxLabelHandle* sh) const;
 
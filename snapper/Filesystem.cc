@@ -157,9 +157,10 @@ namespace snapper
 
 
     void
-    Filesystem::cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb) const
+    Filesystem::cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb,
+			const IgnorePatterns* ignore_patterns) const
     {
-	snapper::cmpDirs(dir1, dir2, cb);
+	snapper::cmpDirs(dir1, dir2, cb, ignore_patterns);
     }
 
 
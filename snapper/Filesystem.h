@@ -81,7 +81,8 @@ namespace snapper
 
 	virtual bool checkSnapshot(unsigned int num) const = 0;
 
-	virtual void cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb) const;
+	virtual void cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb,
+			     const IgnorePatterns* ignore_patterns = nullptr) const;
 
 	virtual bool isDefault(unsigned int num) const;
 
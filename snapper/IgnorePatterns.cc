@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include <fnmatch.h>
+
+#include "snapper/IgnorePatterns.h"
+
+
+namespace snapper
+{
+
+    IgnorePatterns::IgnorePatterns(const vector<string>& patterns)
+	: nodes(1)
+    {
+	for (const string& pattern : patterns)
+	{
+	    string::size_type pos = pattern.find_first_of("*?[\\");
+	    if (pos == string::npos)
+	    {
+		literals.insert(pattern);
+		continue;
+	    }
+
+	    size_t i = 0;
+
+	    for (string::size_type j = 0; j < pos; ++j)
+	    {
+		std::map<char, size_t>::const_iterator it = nodes[i].children.find(pattern[j]);
+		if (it != nodes[i].children.end())
+		{
+		    i = it->second;
+		}
+		else
+		{
+		    nodes[i].children[pattern[j]] = nodes.size();
+		    i = nodes.size();
+		    nodes.emplace_back();
+		}
+	    }
+
+	    nodes[i].globs.push_back(pattern);
+	}
+    }
+
+
+    bool
+    IgnorePatterns::match(const string& name) const
+    {
+	// With FNM_LEADING_DIR a literal pattern matches the name itself and
+	// every prefix of it followed by a slash.
+
+	if (!literals.empty())
+	{
+	    if (literals.count(name))
+		return true;
+
+	    for (string::size_type pos = name.find('/'); pos != string::npos;
+		 pos = name.find('/', pos + 1))
+	    {
+		if (literals.count(string(name, 0, pos)))
+		    return true;
+	    }
+	}
+
+	size_t i = 0;
+
+	for (string::size_type j = 0; ; ++j)
+	{
+	    for (const string& glob : nodes[i].globs)
+	    {
+		if (fnmatch(glob.c_str(), name.c_str(), FNM_LEADING_DIR) == 0)
+		    return true;
+	    }
+
+	    if (j == name.size())
+		break;
+
+	    std::map<char, size_t>::const_iterator it = nodes[i].children.find(name[j]);
+	    if (it == nodes[i].children.end())
+		break;
+
+	    i = it->second;
+	}
+
+	return false;
+    }
+
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef SNAPPER_IGNORE_PATTERNS_H
+#define SNAPPER_IGNORE_PATTERNS_H
+
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_set>
+
+
+namespace snapper
+{
+    using std::string;
+    using std::vector;
+
+
+    /**
+     * Matches filenames against a set of ignore patterns. A filename
+     * matches if fnmatch(pattern, name, FNM_LEADING_DIR) matches for any
+     * pattern.
+     *
+     * Patterns without wildcards are kept in a hash set and looked up for
+     * the name and all its leading directories. Other patterns are kept
+     * in a trie indexed by their literal prefix, so that fnmatch is only
+     * called for patterns whose prefix matches the name.
+     */
+    class IgnorePatterns
+    {
+    public:
+
+	IgnorePatterns(const vector<string>& patterns);
+
+	bool empty() const { return literals.empty() && nodes.size() == 1; }
+
+	bool match(const string& name) const;
+
+    private:
+
+	struct Node
+	{
+	    std::map<char, size_t> children;
+	    vector<string> globs;
+	};
+
+	std::unordered_set<string> literals;
+
+	vector<Node> nodes;
+
+    };
+
+}
+
+
+#endif
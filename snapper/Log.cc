@@ -33,10 +33,32 @@ namespace snapper
     const string* component = new string("libsnapper");
 
 
-    bool
-    testLogLevel(LogLevel level)
+    static const unsigned int log_level_cache_filled = 1U << 31;
+
+    std::atomic<unsigned int> log_level_cache(0);
+
+
+    unsigned int
+    fillLogLevelCache()
+    {
+	unsigned int cache = log_level_cache_filled;
+
+	for (LogLevel level : { DEBUG, MILESTONE, WARNING, ERROR })
+	{
+	    if (callLogQuery(level, *component))
+		cache |= 1U << level;
+	}
+
+	log_level_cache.store(cache, std::memory_order_relaxed);
+
+	return cache;
+    }
+
+
+    void
+    resetLogQueryCache()
     {
-	return callLogQuery(level, *component);
+	log_level_cache.store(0, std::memory_order_relaxed);
     }
 
 
@@ -24,16 +24,44 @@
 #define SNAPPER_LOG_H
 
 #include <sstream>
+#include <atomic>
 
 #include "Logger.h"
 
 
+/*
+ * Log calls below this level are removed at compile time, e.g. use
+ * -DSNAPPER_MIN_LOG_LEVEL=1 to drop all debug logging.
+ */
+#ifndef SNAPPER_MIN_LOG_LEVEL
+#define SNAPPER_MIN_LOG_LEVEL 0
+#endif
+
+
 namespace snapper
 {
     using std::string;
 
 
-    bool testLogLevel(LogLevel level);
+    /*
+     * Cache for the result of the log query for the libsnapper component.
+     * One bit per log level plus a bit indicating that the cache is
+     * filled. Zero means the cache must be filled.
+     */
+    extern std::atomic<unsigned int> log_level_cache;
+
+    unsigned int fillLogLevelCache();
+
+
+    inline bool
+    testLogLevel(LogLevel level)
+    {
+	unsigned int cache = log_level_cache.load(std::memory_order_relaxed);
+	if (__builtin_expect(cache == 0, 0))
+	    cache = fillLogLevelCache();
+
+	return cache & (1U << level);
+    }
 
     void prepareLogStream(std::ostringstream& stream);
 
@@ -49,7 +77,8 @@ namespace snapper
 
 #define y2log_op(level, file, line, func, op)				\
     do {								\
-	if (snapper::testLogLevel(level))				\
+	if ((level) >= SNAPPER_MIN_LOG_LEVEL &&				\
+	    snapper::testLogLevel(level))				\
 	{								\
 	    std::ostringstream* __buf = snapper::logStreamOpen();	\
 	    *__buf << op;						\
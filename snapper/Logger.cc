@@ -22,11 +22,17 @@
 
 
 #include <pwd.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <unistd.h>
 #include <string.h>
+#include <stdlib.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <libxml/tree.h>
 #include <string>
+#include <vector>
+#include <atomic>
 #include <boost/thread.hpp>
 
 #include "snapper/Log.h"
@@ -44,12 +50,157 @@ namespace snapper
     namespace
     {
 
+	/*
+	 * Bounded multi-producer single-consumer queue of log lines. Producers
+	 * never block, if the queue is full push() fails and the caller has
+	 * to write synchronously. The string buffers are swapped in and out
+	 * of the slots so no copies are made.
+	 */
+	class LogQueue
+	{
+	public:
+
+	    LogQueue(size_t capacity)
+		: mask(capacity - 1), slots(capacity), head(0), tail(0)
+	    {
+		for (size_t i = 0; i < capacity; ++i)
+		    slots[i].seq.store(i, memory_order_relaxed);
+	    }
+
+	    bool push(string& text)
+	    {
+		size_t pos = head.load(memory_order_relaxed);
+
+		while (true)
+		{
+		    Slot& slot = slots[pos & mask];
+		    size_t seq = slot.seq.load(memory_order_acquire);
+		    ptrdiff_t diff = (ptrdiff_t)(seq) - (ptrdiff_t)(pos);
+
+		    if (diff == 0)
+		    {
+			if (head.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+			{
+			    slot.text.swap(text);
+			    slot.seq.store(pos + 1, memory_order_release);
+			    return true;
+			}
+		    }
+		    else if (diff < 0)
+		    {
+			return false;
+		    }
+		    else
+		    {
+			pos = head.load(memory_order_relaxed);
+		    }
+		}
+	    }
+
+	    // Must only be called by one thread at a time.
+	    bool pop(string& text)
+	    {
+		size_t pos = tail.load(memory_order_relaxed);
+
+		Slot& slot = slots[pos & mask];
+		if (slot.seq.load(memory_order_acquire) != pos + 1)
+		    return false;
+
+		text.swap(slot.text);
+		slot.text.clear();
+		slot.seq.store(pos + mask + 1, memory_order_release);
+		tail.store(pos + 1, memory_order_release);
+
+		return true;
+	    }
+
+	    // May be called by any thread, the result is only a hint then.
+	    bool empty() const
+	    {
+		size_t pos = tail.load(memory_order_acquire);
+		return slots[pos & mask].seq.load(memory_order_acquire) != pos + 1;
+	    }
+
+	    // May be called by any thread.
+	    size_t size_hint() const
+	    {
+		size_t pos = tail.load(memory_order_acquire);
+		return head.load(memory_order_relaxed) - pos;
+	    }
+
+	    size_t capacity() const { return mask + 1; }
+
+	    // Must only be called by the consumer.
+	    void clear()
+	    {
+		string text;
+		while (pop(text))
+		    ;
+	    }
+
+	private:
+
+	    struct Slot
+	    {
+		atomic<size_t> seq;
+		string text;
+	    };
+
+	    const size_t mask;
+	    vector<Slot> slots;
+
+	    atomic<size_t> head;
+
+	    // Only changed by the consumer, but read by other threads.
+	    atomic<size_t> tail;
+
+	};
+
+
+	/*
+	 * The default logger keeps the log file open and lets a background
+	 * thread write the queued lines. The file is reopened after a request
+	 * via reopenLogFile() or if it was rotated (renamed or removed).
+	 */
 	struct LoggerData
 	{
-	    LoggerData() : filename(LOG_FILENAME), mutex() {}
+	    LoggerData() : filename(LOG_FILENAME), queue(4096) {}
+
+	    void log(LogLevel level, string& text);
+
+	    void flush();
+
+	    void worker();
 
 	    string filename;
+
+	    LogQueue queue;
+
+	    // protects fp, consuming from the queue and filename changes
 	    boost::mutex mutex;
+	    FILE* fp = nullptr;
+	    dev_t dev = 0;
+	    ino_t ino = 0;
+
+	    atomic<bool> reopen { false };
+
+	    boost::mutex wakeup_mutex;
+	    boost::condition_variable wakeup;
+	    atomic<bool> worker_idle { false };
+
+	    boost::once_flag worker_started = BOOST_ONCE_INIT;
+	    bool worker_running = false;
+
+	private:
+
+	    void open();
+	    void close();
+
+	    void check_rotation();
+
+	    // must be called with mutex locked
+	    void drain();
+
 	};
 
 
@@ -58,6 +209,198 @@ namespace snapper
 
 	LoggerData* logger_data = new LoggerData();
 
+
+	void
+	flush_at_exit()
+	{
+	    logger_data->flush();
+	}
+
+
+	/*
+	 * The forked child, e.g. in SystemCmd before exec, has no background
+	 * thread and must neither inherit a locked mutex nor write the queued
+	 * entries of the parent again. So the mutex is held during fork and
+	 * the child logs synchronously with an empty queue.
+	 */
+
+	void
+	prepare_fork()
+	{
+	    logger_data->mutex.lock();
+	}
+
+
+	void
+	parent_after_fork()
+	{
+	    logger_data->mutex.unlock();
+	}
+
+
+	void
+	child_after_fork()
+	{
+	    logger_data->worker_running = false;
+	    logger_data->queue.clear();
+
+	    logger_data->mutex.unlock();
+	}
+
+
+	void
+	start_worker()
+	{
+	    pthread_atfork(prepare_fork, parent_after_fork, child_after_fork);
+
+	    try
+	    {
+		boost::thread thread(boost::bind(&LoggerData::worker, logger_data));
+		thread.detach();
+
+		atexit(flush_at_exit);
+
+		logger_data->worker_running = true;
+	    }
+	    catch (const boost::thread_resource_error& e)
+	    {
+		// continue logging synchronously
+	    }
+	}
+
+
+	void
+	LoggerData::open()
+	{
+	    fp = fopen(filename.c_str(), "ae");
+	    if (!fp)
+		return;
+
+	    struct stat buf;
+	    if (fstat(fileno(fp), &buf) == 0)
+	    {
+		dev = buf.st_dev;
+		ino = buf.st_ino;
+	    }
+	}
+
+
+	void
+	LoggerData::close()
+	{
+	    if (fp)
+	    {
+		fclose(fp);
+		fp = nullptr;
+	    }
+	}
+
+
+	void
+	LoggerData::check_rotation()
+	{
+	    if (reopen.exchange(false))
+	    {
+		close();
+		return;
+	    }
+
+	    if (!fp)
+		return;
+
+	    struct stat buf;
+	    if (stat(filename.c_str(), &buf) != 0 || buf.st_dev != dev || buf.st_ino != ino)
+		close();
+	}
+
+
+	void
+	LoggerData::drain()
+	{
+	    string text;
+
+	    while (queue.pop(text))
+	    {
+		if (!fp)
+		    open();
+
+		if (fp)
+		    fwrite(text.data(), 1, text.size(), fp);
+	    }
+
+	    if (fp)
+		fflush(fp);
+	}
+
+
+	void
+	LoggerData::log(LogLevel level, string& text)
+	{
+	    boost::call_once(worker_started, &start_worker);
+
+	    if (worker_running && level != ERROR && queue.push(text))
+	    {
+		if (worker_idle.load() || queue.size_hint() > queue.capacity() / 2)
+		{
+		    boost::lock_guard<boost::mutex> lock(wakeup_mutex);
+		    wakeup.notify_one();
+		}
+
+		return;
+	    }
+
+	    // Queue is full, no background thread is available or the entry
+	    // is an error that should hit the disk immediately. Write
+	    // synchronously after the queued entries to keep the order.
+
+	    boost::lock_guard<boost::mutex> lock(mutex);
+
+	    check_rotation();
+	    drain();
+
+	    if (!fp)
+		open();
+
+	    if (fp)
+	    {
+		fwrite(text.data(), 1, text.size(), fp);
+		fflush(fp);
+	    }
+	}
+
+
+	void
+	LoggerData::flush()
+	{
+	    boost::lock_guard<boost::mutex> lock(mutex);
+
+	    drain();
+	}
+
+
+	void
+	LoggerData::worker()
+	{
+	    while (true)
+	    {
+		{
+		    boost::unique_lock<boost::mutex> lock(wakeup_mutex);
+
+		    worker_idle.store(true);
+
+		    while (queue.empty() && !reopen.load())
+			wakeup.timed_wait(lock, boost::posix_time::seconds(1));
+
+		    worker_idle.store(false);
+		}
+
+		boost::lock_guard<boost::mutex> lock(mutex);
+
+		check_rotation();
+		drain();
+	    }
+	}
+
     }
 
 
@@ -76,6 +419,8 @@ namespace snapper
     setLogQuery(LogQuery new_log_query)
     {
 	log_query = new_log_query;
+
+	resetLogQueryCache();
     }
 
 
@@ -85,33 +430,35 @@ namespace snapper
     {
 	static const char* ln[4] = { "DEB", "MIL", "WAR", "ERR" };
 
-	string prefix = sformat("%s %s libsnapper(%d) %s(%s):%d", datetime(time(0), false, true).c_str(),
+	string prefix = sformat("%s %s libsnapper(%d) %s(%s):%d - ", datetime(time(0), false, true).c_str(),
 				ln[level], getpid(), file, func, line);
 
-	boost::lock_guard<boost::mutex> lock(logger_data->mutex);
-
-	FILE* f = fopen(logger_data->filename.c_str(), "ae");
-	if (f)
-	{
-	    string tmp = text;
+	// Build all lines of the entry in one buffer.
 
-	    string::size_type pos1 = 0;
-
-	    while (true)
-	    {
-		string::size_type pos2 = tmp.find('\n', pos1);
+	string tmp;
+	tmp.reserve(prefix.size() + text.size() + 1);
 
-		if (pos2 != string::npos || pos1 != tmp.length())
-		    fprintf(f, "%s - %s\n", prefix.c_str(), tmp.substr(pos1, pos2 - pos1).c_str());
+	string::size_type pos1 = 0;
 
-		if (pos2 == string::npos)
-		    break;
+	while (true)
+	{
+	    string::size_type pos2 = text.find('\n', pos1);
 
-		pos1 = pos2 + 1;
+	    if (pos2 != string::npos || pos1 != text.length())
+	    {
+		tmp.append(prefix);
+		tmp.append(text, pos1, pos2 == string::npos ? string::npos : pos2 - pos1);
+		tmp.push_back('\n');
 	    }
 
-	    fclose(f);
+	    if (pos2 == string::npos)
+		break;
+
+	    pos1 = pos2 + 1;
 	}
+
+	if (!tmp.empty())
+	    logger_data->log(level, tmp);
     }
 
 
@@ -143,6 +490,24 @@ namespace snapper
     }
 
 
+    void
+    reopenLogFile()
+    {
+	// Only set the flag here since the function may be called from a
+	// signal handler. The background thread checks it at least once a
+	// second.
+
+	logger_data->reopen.store(true);
+    }
+
+
+    void
+    flushLog()
+    {
+	logger_data->flush();
+    }
+
+
     void
     xml_error_func(void* ctx, const char* msg, ...)
     {
@@ -154,7 +519,7 @@ namespace snapper
     void
     initDefaultLogger()
     {
-	logger_data->filename = LOG_FILENAME;
+	string filename = LOG_FILENAME;
 
 	if (geteuid())
 	{
@@ -162,13 +527,28 @@ namespace snapper
 
 	    if (get_uid_dir(geteuid(), dir))
 	    {
-		logger_data->filename = dir + "/.snapper.log";
+		filename = dir + "/.snapper.log";
 	    }
 	}
 
+	initDefaultLogger(filename);
+    }
+
+
+    void
+    initDefaultLogger(const string& filename)
+    {
+	{
+	    boost::lock_guard<boost::mutex> lock(logger_data->mutex);
+	    logger_data->filename = filename;
+	    logger_data->reopen.store(true);
+	}
+
 	log_do = NULL;
 	log_query = NULL;
 
+	resetLogQueryCache();
+
 	initGenericErrorDefaultFunc(&xml_error_func_ptr);
     }
 
@@ -43,15 +43,42 @@ namespace snapper
 
     void setLogDo(LogDo log_do);
 
+    /*
+     * The result of the log query is cached per log level. If the result
+     * of the function changes resetLogQueryCache() must be called.
+     */
     void setLogQuery(LogQuery log_query);
 
+    void resetLogQueryCache();
+
     void callLogDo(LogLevel level, const string& component, const char* file, int line,
 		   const char* func, const string& text);
 
     bool callLogQuery(LogLevel level, const string& component);
 
+    /*
+     * The default logger writes to the log file asynchronously and keeps
+     * the file open.
+     */
     void initDefaultLogger();
 
+    /*
+     * Like initDefaultLogger() but with a different log file, e.g. for
+     * testing.
+     */
+    void initDefaultLogger(const string& filename);
+
+    /*
+     * Let the default logger reopen the log file, e.g. after log rotation.
+     * Async-signal-safe.
+     */
+    void reopenLogFile();
+
+    /*
+     * Write all pending entries of the default logger to the log file.
+     */
+    void flushLog();
+
 }
 
 #endif
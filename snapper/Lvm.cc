@@ -196,6 +196,17 @@ namespace snapper
     {
 	SDir subvolume_dir = openSubvolumeDir();
 
+	try
+	{
+	    SDir infos_dir(subvolume_dir, ".snapshots");
+	    infos_dir.unlink(SELINUX_STAMP_NAME, 0);
+	    infos_dir.unlink(NEXT_NUMBER_NAME, 0);
+	}
+	catch (const IOErrorException& e)
+	{
+	    SN_CAUGHT(e);
+	}
+
 	int r1 = subvolume_dir.unlink(".snapshots", AT_REMOVEDIR);
 	if (r1 != 0)
 	{
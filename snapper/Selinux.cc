@@ -21,6 +21,7 @@
 
 #include <cerrno>
 #include <map>
+#include <sys/stat.h>
 
 #include <boost/algorithm/string.hpp>
 
@@ -144,6 +145,30 @@ namespace snapper
     }
 
 
+    string
+    selinux_policy_id()
+    {
+	string ret = "policyvers:" + std::to_string(security_policyvers());
+
+	for (const char* path : { selinux_file_context_path(), selinux_file_context_local_path(),
+		    selinux_snapperd_contexts_path() })
+	{
+	    if (!path)
+		continue;
+
+	    ret += " ";
+	    ret += path;
+
+	    struct stat buf;
+	    if (stat(path, &buf) == 0)
+		ret += sformat(":%lld.%09ld:%lld", (long long) buf.st_mtim.tv_sec, buf.st_mtim.tv_nsec,
+			       (long long) buf.st_size);
+	}
+
+	return ret;
+    }
+
+
     SelinuxLabelHandle*
     SelinuxLabelHandle::get_selinux_handle()
     {
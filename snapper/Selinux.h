@@ -47,6 +47,13 @@ namespace snapper
 
     bool _is_selinux_enabled();
 
+    /**
+     * Returns a string identifying the loaded policy and the file
+     * contexts configuration. The string changes whenever the labels
+     * snapper files should get may have changed.
+     */
+    string selinux_policy_id();
+
     class SnapperContexts
     {
     public:
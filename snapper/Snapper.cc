@@ -121,7 +121,7 @@ namespace snapper
 	filesystem = Filesystem::create(*config_info, root_prefix);
 
 	// With btrfs backend, it's useless try syncing snapshot RO subvolumes
-	syncSelinuxContexts(filesystem->fstype() == "btrfs");
+	syncSelinuxContexts(filesystem->fstype() == "btrfs", false);
 
 	bool sync_acl;
 	if (config_info->get_value(KEY_SYNC_ACL, sync_acl) && sync_acl == true)
@@ -234,6 +234,13 @@ namespace snapper
     }
 
 
+    bool
+    Snapper::refreshSnapshots()
+    {
+	return snapshots.refresh();
+    }
+
+
     Snapshots::iterator
     Snapper::createSingleSnapshot(const SCD& scd)
     {
@@ -258,6 +265,17 @@ namespace snapper
     }
 
 
+    vector<Snapshots::iterator>
+    Snapper::createSingleSnapshots(const vector<Snapper*>& snappers, const SCD& scd)
+    {
+	vector<Snapshots*> snapshots;
+	for (Snapper* snapper : snappers)
+	    snapshots.push_back(&snapper->snapshots);
+
+	return Snapshots::createSingleSnapshots(snapshots, scd);
+    }
+
+
     Snapshots::iterator
     Snapper::createPreSnapshot(const SCD& scd)
     {
@@ -282,7 +300,15 @@ namespace snapper
     void
     Snapper::deleteSnapshot(Snapshots::iterator snapshot)
     {
-	snapshots.deleteSnapshot(snapshot);
+	snapshots.deleteSnapshot(snapshot, nullptr, nullptr);
+    }
+
+
+    void
+    Snapper::deleteSnapshot(Snapshots::iterator snapshot, const std::function<void()>& unlock,
+			    const std::function<void()>& lock)
+    {
+	snapshots.deleteSnapshot(snapshot, unlock, lock);
     }
 
 
@@ -912,25 +938,112 @@ namespace snapper
     }
 
 
+#ifdef ENABLE_SELINUX
+
+    /*
+     * The stamp file in the infos dir records the policy and the time of
+     * the last successful sync. Returns false if the stamp is missing or
+     * belongs to a different policy.
+     */
+    static bool
+    read_selinux_stamp(const SDir& infos_dir, const string& policy_id, time_t& since)
+    {
+	int fd = infos_dir.open(SELINUX_STAMP_NAME, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+	if (fd < 0)
+	    return false;
+
+	char buffer[1024];
+	ssize_t r = read(fd, buffer, sizeof(buffer));
+	close(fd);
+
+	if (r <= 0)
+	    return false;
+
+	string content(buffer, r);
+
+	string::size_type pos = content.find('\n');
+	if (pos == string::npos || string(content, pos + 1) != policy_id + "\n")
+	    return false;
+
+	long long tmp;
+	if (sscanf(content.c_str(), "%lld", &tmp) != 1)
+	    return false;
+
+	since = tmp;
+	return true;
+    }
+
+
+    static void
+    write_selinux_stamp(const SDir& infos_dir, const string& policy_id, time_t since)
+    {
+	string tmp_name = SELINUX_STAMP_NAME ".tmp-XXXXXX";
+	const string content = sformat("%lld\n", (long long) since) + policy_id + "\n";
+
+	int fd = infos_dir.mktemp(tmp_name);
+	if (fd < 0)
+	{
+	    y2err("mktemp failed errno:" << errno << " (" << stringerror(errno) << ")");
+	    return;
+	}
+
+	bool ok = write(fd, content.c_str(), content.size()) == (ssize_t) content.size() &&
+	    fchmod(fd, 0644) == 0;
+	close(fd);
+
+	if (!ok || infos_dir.rename(tmp_name, SELINUX_STAMP_NAME) != 0)
+	{
+	    y2err("writing selinux stamp failed");
+	    infos_dir.unlink(tmp_name, 0);
+	}
+    }
+
+#endif
+
+
     void
-    Snapper::syncSelinuxContexts(bool skip_snapshot_dir) const
+    Snapper::syncSelinuxContexts(bool skip_snapshot_dir, bool force) const
     {
 #ifdef ENABLE_SELINUX
+	if (!_is_selinux_enabled())
+	    return;
+
 	try
 	{
 	    SDir subvol_dir = openSubvolumeDir();
 	    SDir infos_dir(subvol_dir, ".snapshots");
 
-	    if (infos_dir.restorecon(selabel_handle))
-	    {
-		syncSelinuxContextsInInfosDir(skip_snapshot_dir);
-	    }
-	    else
+	    if (!infos_dir.restorecon(selabel_handle))
 	    {
 		SnapperContexts scons;
 
-		if (infos_dir.fsetfilecon(scons.subvolume_context()))
-		    syncSelinuxContextsInInfosDir(skip_snapshot_dir);
+		if (!infos_dir.fsetfilecon(scons.subvolume_context()))
+		    return;
+	    }
+
+	    // Unless the policy changed only entries changed since the last
+	    // sync need to be relabelled. Entries changed while syncing are
+	    // relabelled again next time.
+
+	    const string policy_id = selinux_policy_id();
+	    const time_t now = time(nullptr);
+
+	    time_t since = 0;
+	    bool stamp_valid = !force && read_selinux_stamp(infos_dir, policy_id, since);
+	    if (!stamp_valid)
+		since = 0;
+
+	    y2mil("syncing selinux contexts since:" << since);
+
+	    unsigned int synced = syncSelinuxContextsInInfosDir(skip_snapshot_dir, since);
+
+	    // The stamp only needs to be updated if something was relabelled
+	    // or the policy changed.
+
+	    if (!stamp_valid || synced > 0)
+	    {
+		write_selinux_stamp(infos_dir, policy_id, now);
+		SFile(infos_dir, SELINUX_STAMP_NAME).restorecon(selabel_handle);
 	    }
 	}
 	catch (const SelinuxException& e)
@@ -943,8 +1056,17 @@ namespace snapper
 
 
     void
-    Snapper::syncSelinuxContextsInInfosDir(bool skip_snapshot_dir) const
+    Snapper::resyncSelinuxContexts() const
+    {
+	syncSelinuxContexts(filesystem->fstype() == "btrfs", true);
+    }
+
+
+    unsigned int
+    Snapper::syncSelinuxContextsInInfosDir(bool skip_snapshot_dir, time_t since) const
     {
+	unsigned int synced = 0;
+
 #ifdef ENABLE_SELINUX
 	static const regex rx("[0-9]+", regex::extended);
 
@@ -959,6 +1081,16 @@ namespace snapper
 		continue;
 
 	    SDir info_dir(infos_dir, *it1);
+
+	    // Adding or replacing files in the info dir, e.g. info.xml or
+	    // filelists, changes its ctime.
+
+	    struct stat buf;
+	    if (since != 0 && info_dir.stat(&buf) == 0 && buf.st_ctime < since)
+		continue;
+
+	    ++synced;
+
 	    info_dir.restorecon(selabel_handle);
 
 	    SFile info(info_dir, "info.xml");
@@ -977,7 +1109,11 @@ namespace snapper
 		fl.restorecon(selabel_handle);
 	    }
 	}
+
+	y2mil("synced selinux contexts of " << synced << " snapshots");
 #endif
+
+	return synced;
     }
 
 
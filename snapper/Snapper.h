@@ -26,6 +26,7 @@
 
 
 #include <vector>
+#include <functional>
 #include <boost/noncopyable.hpp>
 
 #include "snapper/Snapshot.h"
@@ -140,9 +141,27 @@ namespace snapper
 
 	Snapshots::const_iterator getSnapshotCurrent() const;
 
+	/**
+	 * Brings the snapshot list up to date with changes made by other
+	 * processes without reading all snapshots again. Returns true if
+	 * anything changed.
+	 */
+	bool refreshSnapshots();
+
 	Snapshots::iterator createSingleSnapshot(const SCD& scd);
 	Snapshots::iterator createSingleSnapshot(Snapshots::const_iterator parent, const SCD& scd);
 	Snapshots::iterator createSingleSnapshotOfDefault(const SCD& scd);
+
+	/**
+	 * Creates single snapshots of the current subvolumes of several
+	 * configs together, e.g. to get consistent snapshots of root and
+	 * home. The filesystem snapshots are created back-to-back, the
+	 * infos are written and the hooks are run afterwards. If anything
+	 * fails no snapshot is created. The returned iterators are in the
+	 * order of snappers.
+	 */
+	static vector<Snapshots::iterator> createSingleSnapshots(const vector<Snapper*>& snappers,
+								 const SCD& scd);
 	Snapshots::iterator createPreSnapshot(const SCD& scd);
 	Snapshots::iterator createPostSnapshot(Snapshots::const_iterator pre, const SCD& scd);
 
@@ -150,6 +169,15 @@ namespace snapper
 
 	void deleteSnapshot(Snapshots::iterator snapshot);
 
+	/**
+	 * Same as deleteSnapshot() above but calls unlock before and lock
+	 * after deleting the filesystem snapshot, the lengthy part. Used by
+	 * snapperd to release its lock meanwhile. The caller must ensure
+	 * that the snapshot is not used in the meantime.
+	 */
+	void deleteSnapshot(Snapshots::iterator snapshot, const std::function<void()>& unlock,
+			    const std::function<void()>& lock);
+
 	const vector<string>& getIgnorePatterns() const { return ignore_patterns; }
 
 	static ConfigInfo getConfig(const string& config_name, const string& root_prefix);
@@ -179,6 +207,14 @@ namespace snapper
 
 	FreeSpaceData queryFreeSpaceData() const;
 
+	/**
+	 * Relabel the snapshot infos and filelists with their default
+	 * SELinux contexts regardless of the policy recorded at the last
+	 * sync. Normally only entries changed since the last sync are
+	 * relabelled.
+	 */
+	void resyncSelinuxContexts() const;
+
 	/**
 	 * Calculate used spaces. So far only available for btrfs and
 	 * only if quota is enabled. In that a btrfs rescan and sync
@@ -206,8 +242,8 @@ namespace snapper
 
 	void syncAcl(const vector<uid_t>& uids, const vector<gid_t>& gids) const;
 
-	void syncSelinuxContexts(bool skip_snapshot_dir) const;
-	void syncSelinuxContextsInInfosDir(bool skip_snapshot_dir) const;
+	void syncSelinuxContexts(bool skip_snapshot_dir, bool force) const;
+	unsigned int syncSelinuxContextsInInfosDir(bool skip_snapshot_dir, time_t since) const;
 	void syncInfoDir(SDir& dir) const;
 
 	ConfigInfo* config_info = nullptr;
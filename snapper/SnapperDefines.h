@@ -40,6 +40,12 @@
 #define DEV_DIR "/dev"
 #define DEV_MAPPER_DIR "/dev/mapper"
 
+// stamp of the last SELinux context sync in the infos dir
+#define SELINUX_STAMP_NAME ".selinux-stamp"
+
+// highest snapshot number allocated so far in the infos dir
+#define NEXT_NUMBER_NAME ".next-number"
+
 
 // commands
 
@@ -28,12 +28,16 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <string.h>
+#include <ctype.h>
+#include <limits>
 #include <regex>
+#include <set>
 #include <boost/algorithm/string.hpp>
 
 #include "snapper/Snapshot.h"
 #include "snapper/Snapper.h"
 #include "snapper/AppUtil.h"
+#include "snapper/AsciiFile.h"
 #include "snapper/XmlFile.h"
 #include "snapper/Filesystem.h"
 #ifdef ENABLE_BTRFS
@@ -193,6 +197,102 @@ namespace snapper
     }
 
 
+    bool
+    Snapshots::readInfo(const SDir& infos_dir, const string& name, Snapshot& snapshot) const
+    {
+	try
+	{
+	    SDir info_dir(infos_dir, name);
+	    int fd = info_dir.open("info.xml", O_NOFOLLOW | O_CLOEXEC);
+	    if (fd < 0)
+		SN_THROW(IOErrorException("open info.xml failed"));
+
+	    // the stamp is taken from the opened file so that a concurrent
+	    // replacement is detected by the next refresh
+
+	    struct stat buf;
+	    if (fstat(fd, &buf) != 0)
+	    {
+		::close(fd);
+		SN_THROW(IOErrorException("stat info.xml failed"));
+	    }
+
+	    XmlFile file(fd, "");
+
+	    const xmlNode* node = file.getRootElement();
+
+	    string tmp;
+
+	    SnapshotType type;
+	    if (!getChildValue(node, "type", tmp) || !toValue(tmp, type, true))
+	    {
+		y2err("type missing or invalid. not adding snapshot " << name);
+		return false;
+	    }
+
+	    unsigned int num;
+	    if (!getChildValue(node, "num", num) || num == 0)
+	    {
+		y2err("num missing or invalid. not adding snapshot " << name);
+		return false;
+	    }
+
+	    time_t date;
+	    if (!getChildValue(node, "date", tmp) || (date = scan_datetime(tmp, true)) == (time_t)(-1))
+	    {
+		y2err("date missing or invalid. not adding snapshot " << name);
+		return false;
+	    }
+
+	    snapshot = Snapshot(snapper, type, num, date);
+
+	    name >> num;
+	    if (num != snapshot.num)
+	    {
+		y2err("num mismatch. not adding snapshot " << name);
+		return false;
+	    }
+
+	    getChildValue(node, "uid", snapshot.uid);
+
+	    getChildValue(node, "pre_num", snapshot.pre_num);
+
+	    getChildValue(node, "description", snapshot.description);
+
+	    getChildValue(node, "cleanup", snapshot.cleanup);
+
+	    const list<const xmlNode*> l = getChildNodes(node, "userdata");
+	    for (list<const xmlNode*>::const_iterator it = l.begin(); it != l.end(); ++it)
+	    {
+		string key, value;
+		getChildValue(*it, "key", key);
+		getChildValue(*it, "value", value);
+		if (!key.empty())
+		    snapshot.userdata[key] = value;
+	    }
+
+	    if (!snapper->getFilesystem()->checkSnapshot(snapshot.num))
+	    {
+		y2err("snapshot check failed. not adding snapshot " << name);
+		return false;
+	    }
+
+	    snapshot.info_ino = buf.st_ino;
+	    snapshot.info_mtime = buf.st_mtim;
+
+	    return true;
+	}
+	catch (const Exception& e)
+	{
+	    SN_CAUGHT(e);
+
+	    y2err("loading " << name << " failed");
+
+	    return false;
+	}
+    }
+
+
     void
     Snapshots::read()
     {
@@ -201,91 +301,112 @@ namespace snapper
 	SDir infos_dir = snapper->openInfosDir();
 
 	vector<string> infos = infos_dir.entries();
-	for (vector<string>::const_iterator it1 = infos.begin(); it1 != infos.end(); ++it1)
+	for (vector<string>::const_iterator it = infos.begin(); it != infos.end(); ++it)
 	{
-	    if (!regex_match(*it1, rx))
+	    if (!regex_match(*it, rx))
 		continue;
 
-	    try
-	    {
-		SDir info_dir(infos_dir, *it1);
-		int fd = info_dir.open("info.xml", O_NOFOLLOW | O_CLOEXEC);
-		if (fd < 0)
-		    SN_THROW(IOErrorException("open info.xml failed"));
-
-		XmlFile file(fd, "");
+	    Snapshot snapshot(snapper, SINGLE, 0, (time_t)(-1));
+	    if (readInfo(infos_dir, *it, snapshot))
+		entries.push_back(snapshot);
+	}
 
-		const xmlNode* node = file.getRootElement();
+	entries.sort();
 
-		string tmp;
+	y2mil("found " << entries.size() << " snapshots");
+    }
 
-		SnapshotType type;
-		if (!getChildValue(node, "type", tmp) || !toValue(tmp, type, true))
-		{
-		    y2err("type missing or invalid. not adding snapshot " << *it1);
-		    continue;
-		}
 
-		unsigned int num;
-		if (!getChildValue(node, "num", num) || num == 0)
-		{
-		    y2err("num missing or invalid. not adding snapshot " << *it1);
-		    continue;
-		}
+    bool
+    Snapshots::refresh()
+    {
+	static const regex rx("[0-9]+", regex::extended);
 
-		time_t date;
-		if (!getChildValue(node, "date", tmp) || (date = scan_datetime(tmp, true)) == (time_t)(-1))
-		{
-		    y2err("date missing or invalid. not adding snapshot " << *it1);
-		    continue;
-		}
+	SDir infos_dir = snapper->openInfosDir();
 
-		Snapshot snapshot(snapper, type, num, date);
+	map<unsigned int, iterator> known;
+	for (iterator it = begin(); it != end(); ++it)
+	    if (!it->isCurrent())
+		known.emplace(it->num, it);
 
-		*it1 >> num;
-		if (num != snapshot.num)
-		{
-		    y2err("num mismatch. not adding snapshot " << *it1);
-		    continue;
-		}
+	set<unsigned int> found;
 
-		getChildValue(node, "uid", snapshot.uid);
+	unsigned int reread = 0;
+	unsigned int added = 0;
 
-		getChildValue(node, "pre_num", snapshot.pre_num);
+	vector<string> infos = infos_dir.entries();
+	for (vector<string>::const_iterator it1 = infos.begin(); it1 != infos.end(); ++it1)
+	{
+	    if (!regex_match(*it1, rx))
+		continue;
 
-		getChildValue(node, "description", snapshot.description);
+	    unsigned int num;
+	    *it1 >> num;
 
-		getChildValue(node, "cleanup", snapshot.cleanup);
+	    map<unsigned int, iterator>::iterator it2 = known.find(num);
 
-		const list<const xmlNode*> l = getChildNodes(node, "userdata");
-		for (list<const xmlNode*>::const_iterator it2 = l.begin(); it2 != l.end(); ++it2)
-		{
-		    string key, value;
-		    getChildValue(*it2, "key", key);
-		    getChildValue(*it2, "value", value);
-		    if (!key.empty())
-			snapshot.userdata[key] = value;
-		}
+	    // unchanged info.xml files are not parsed again
 
-		if (!snapper->getFilesystem()->checkSnapshot(snapshot.num))
+	    if (it2 != known.end())
+	    {
+		struct stat buf;
+		if (fstatat(infos_dir.fd(), (*it1 + "/info.xml").c_str(), &buf, AT_SYMLINK_NOFOLLOW) == 0 &&
+		    buf.st_ino == it2->second->info_ino &&
+		    buf.st_mtim.tv_sec == it2->second->info_mtime.tv_sec &&
+		    buf.st_mtim.tv_nsec == it2->second->info_mtime.tv_nsec)
 		{
-		    y2err("snapshot check failed. not adding snapshot " << *it1);
+		    found.insert(num);
 		    continue;
 		}
+	    }
 
-		entries.push_back(snapshot);
+	    Snapshot snapshot(snapper, SINGLE, 0, (time_t)(-1));
+	    if (!readInfo(infos_dir, *it1, snapshot))
+		continue;
+
+	    found.insert(num);
+
+	    if (it2 != known.end())
+	    {
+		// keep the mount state of the already known snapshot
+
+		snapshot.mount_checked = it2->second->mount_checked;
+		snapshot.mount_user_request = it2->second->mount_user_request;
+		snapshot.mount_use_count = it2->second->mount_use_count;
+
+		*it2->second = snapshot;
+		++reread;
 	    }
-	    catch (const Exception& e)
+	    else
 	    {
-		SN_CAUGHT(e);
+		entries.push_back(snapshot);
+		++added;
+	    }
+	}
 
-		y2err("loading " << *it1 << " failed");
+	unsigned int removed = 0;
+
+	for (map<unsigned int, iterator>::const_iterator it = known.begin(); it != known.end(); ++it)
+	{
+	    if (found.find(it->first) == found.end())
+	    {
+		entries.erase(it->second);
+		++removed;
 	    }
 	}
 
-	entries.sort();
+	if (reread == 0 && added == 0 && removed == 0)
+	    return false;
 
-	y2mil("found " << entries.size() << " snapshots");
+	if (added != 0)
+	    entries.sort();
+
+	y2mil("refreshed snapshots reread:" << reread << " added:" << added << " removed:" <<
+	      removed);
+
+	check();
+
+	return true;
     }
 
 
@@ -436,13 +557,113 @@ namespace snapper
     }
 
 
+    static unsigned int
+    read_next_number(const SDir& infos_dir)
+    {
+	int fd = infos_dir.open(NEXT_NUMBER_NAME, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+	if (fd < 0)
+	    return 0;
+
+	char buffer[32];
+	ssize_t r = read(fd, buffer, sizeof(buffer) - 1);
+	close(fd);
+
+	if (r <= 0)
+	    return 0;
+
+	buffer[r] = '\0';
+
+	// Only accept a plain number, sscanf would also accept signs and
+	// wrap around. The number must leave room for the next one.
+
+	char* end;
+	errno = 0;
+	unsigned long num = strtoul(buffer, &end, 10);
+	if (!isdigit(buffer[0]) || (*end != '\0' && strcmp(end, "\n") != 0) || errno == ERANGE ||
+	    num >= std::numeric_limits<unsigned int>::max())
+	{
+	    y2war("invalid " NEXT_NUMBER_NAME " ignored");
+	    return 0;
+	}
+
+	return num;
+    }
+
+
+    static void
+    write_next_number(const SDir& infos_dir, unsigned int num)
+    {
+	string tmp_name = NEXT_NUMBER_NAME ".tmp-XXXXXX";
+	const string content = decString(num) + "\n";
+
+	int fd = infos_dir.mktemp(tmp_name);
+	if (fd < 0)
+	{
+	    y2err("mktemp failed errno:" << errno << " (" << stringerror(errno) << ")");
+	    return;
+	}
+
+	bool ok = write(fd, content.c_str(), content.size()) == (ssize_t) content.size() &&
+	    fchmod(fd, 0644) == 0;
+	close(fd);
+
+	if (!ok || infos_dir.rename(tmp_name, NEXT_NUMBER_NAME) != 0)
+	{
+	    y2err("writing next number failed");
+	    infos_dir.unlink(tmp_name, 0);
+	}
+    }
+
+
+    /*
+     * Also removes temporary files left behind by write_next_number,
+     * e.g. after a crash. A concurrent writer loses its update then, which
+     * only costs another scan later.
+     */
+    static unsigned int
+    scan_highest_number(const SDir& infos_dir)
+    {
+	static const regex rx("[0-9]+", regex::extended);
+
+	unsigned int highest = 0;
+
+	for (const string& name : infos_dir.entries())
+	{
+	    if (boost::starts_with(name, NEXT_NUMBER_NAME ".tmp-"))
+	    {
+		infos_dir.unlink(name, 0);
+		continue;
+	    }
+
+	    if (!regex_match(name, rx))
+		continue;
+
+	    unsigned int num;
+	    name >> num;
+
+	    highest = std::max(highest, num);
+	}
+
+	return highest;
+    }
+
+
     unsigned int
     Snapshots::nextNumber()
     {
-	unsigned int num = entries.empty() ? 0 : entries.rbegin()->num;
-
 	SDir infos_dir = snapper->openInfosDir();
 
+	// Continue after the highest number allocated so far, so that
+	// usually the first mkdir succeeds and numbers of deleted snapshots
+	// are not reused. The number is only reserved by the mkdir. If the
+	// stored number is behind, e.g. after a crash or due to a concurrent
+	// creator, the infos dir is scanned once.
+
+	unsigned int num = std::max(entries.empty() ? 0 : entries.rbegin()->num,
+				    read_next_number(infos_dir));
+
+	bool scanned = false;
+
 	while (true)
 	{
 	    ++num;
@@ -454,7 +675,15 @@ namespace snapper
 		break;
 
 	    if (errno == EEXIST)
+	    {
+		if (!scanned)
+		{
+		    num = std::max(num, scan_highest_number(infos_dir));
+		    scanned = true;
+		}
+
 		continue;
+	    }
 
 	    SN_THROW(IOErrorException(sformat("mkdir failed errno:%d (%s)", errno,
 					      stringerror(errno).c_str())));
@@ -462,6 +691,8 @@ namespace snapper
 
 	infos_dir.chmod(decString(num), 0755, 0);
 
+	write_next_number(infos_dir, num);
+
 	return num;
     }
 
@@ -528,6 +759,15 @@ namespace snapper
 	}
 
 	info_dir.fsync();
+
+	// identify the written info.xml so that refreshing does not read it again
+
+	struct stat buf;
+	if (info_dir.stat(file_name, &buf, AT_SYMLINK_NOFOLLOW) == 0)
+	{
+	    info_ino = buf.st_ino;
+	    info_mtime = buf.st_mtim;
+	}
     }
 
 
@@ -739,6 +979,87 @@ namespace snapper
     }
 
 
+    vector<Snapshots::iterator>
+    Snapshots::createSingleSnapshots(const vector<Snapshots*>& snapshots, const SCD& scd)
+    {
+	for (const Snapshots* tmp : snapshots)
+	    tmp->checkUserdata(scd.userdata);
+
+	// All numbers are allocated first so that the filesystem snapshots
+	// can be created back-to-back. Writing the infos and running the
+	// hooks is deferred until all filesystem snapshots exist.
+
+	const time_t date = time(NULL);
+
+	vector<Snapshot> new_snapshots;
+	new_snapshots.reserve(snapshots.size());
+
+	size_t created = 0;
+
+	try
+	{
+	    for (Snapshots* tmp : snapshots)
+	    {
+		Snapshot snapshot(tmp->snapper, SINGLE, tmp->nextNumber(), date);
+		snapshot.uid = scd.uid;
+		snapshot.description = scd.description;
+		snapshot.cleanup = scd.cleanup;
+		snapshot.userdata = scd.userdata;
+
+		new_snapshots.push_back(snapshot);
+	    }
+
+	    for (; created < snapshots.size(); ++created)
+		new_snapshots[created].createFilesystemSnapshot(snapshots[created]->getSnapshotCurrent()->getNum(),
+								 scd.read_only, scd.empty);
+
+	    for (const Snapshot& snapshot : new_snapshots)
+		snapshot.writeInfo();
+	}
+	catch (const Exception& e)
+	{
+	    SN_CAUGHT(e);
+
+	    for (size_t i = 0; i < new_snapshots.size(); ++i)
+		snapshots[i]->discardSnapshot(new_snapshots[i], i < created);
+
+	    SN_RETHROW(e);
+	}
+
+	vector<iterator> ret;
+	ret.reserve(snapshots.size());
+
+	for (size_t i = 0; i < snapshots.size(); ++i)
+	    ret.push_back(snapshots[i]->entries.insert(snapshots[i]->entries.end(), new_snapshots[i]));
+
+	for (const Snapshots* tmp : snapshots)
+	    Hooks::create_snapshot(tmp->snapper->subvolumeDir(), tmp->snapper->getFilesystem());
+
+	return ret;
+    }
+
+
+    void
+    Snapshots::discardSnapshot(const Snapshot& snapshot, bool filesystem_snapshot) const
+    {
+	try
+	{
+	    if (filesystem_snapshot)
+		snapshot.deleteFilesystemSnapshot();
+
+	    SDir info_dir = snapshot.openInfoDir();
+	    info_dir.unlink("info.xml", 0);
+
+	    SDir infos_dir = snapper->openInfosDir();
+	    infos_dir.unlink(decString(snapshot.getNum()), AT_REMOVEDIR);
+	}
+	catch (const Exception& e)
+	{
+	    SN_CAUGHT(e);
+	}
+    }
+
+
     void
     Snapshots::modifySnapshot(iterator snapshot, const SMD& smd)
     {
@@ -758,13 +1079,18 @@ namespace snapper
 
 
     void
-    Snapshots::deleteSnapshot(iterator snapshot)
+    Snapshots::deleteSnapshot(iterator snapshot, const std::function<void()>& unlock,
+			      const std::function<void()>& lock)
     {
 	if (snapshot == entries.end() || snapshot->isCurrent() || snapshot->isDefault() ||
 	    snapshot->isActive())
 	    SN_THROW(IllegalSnapshotException());
 
-	snapshot->deleteFilesystemSnapshot();
+	{
+	    Unlocker unlocker(unlock, lock);
+
+	    snapshot->deleteFilesystemSnapshot();
+	}
 
 	SDir info_dir = snapshot->openInfoDir();
 
@@ -784,8 +1110,8 @@ namespace snapper
 	    {
 		SDir tmp2 = it->openInfoDir();
 		string name = filelist_name(snapshot->getNum());
-		tmp2.unlink(name, 0);
-		tmp2.unlink(name + ".gz", 0);
+		for (Compression compression : { Compression::NONE, Compression::GZIP, Compression::ZSTD })
+		    tmp2.unlink(add_extension(compression, name), 0);
 	    }
 	}
 
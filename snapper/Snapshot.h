@@ -31,6 +31,8 @@
 #include <string>
 #include <list>
 #include <map>
+#include <vector>
+#include <functional>
 
 #include "snapper/Exception.h"
 
@@ -40,6 +42,7 @@ namespace snapper
     using std::string;
     using std::list;
     using std::map;
+    using std::vector;
 
 
     class Snapper;
@@ -158,6 +161,10 @@ namespace snapper
 	mutable bool mount_user_request = false;
 	mutable unsigned int mount_use_count = 0;
 
+	// identifies the info.xml the snapshot was read from
+	mutable ino_t info_ino = 0;
+	mutable struct timespec info_mtime = { 0, 0 };
+
 	void writeInfo() const;
 
 	void createFilesystemSnapshot(unsigned int num_parent, bool read_only, bool empty) const;
@@ -263,6 +270,15 @@ namespace snapper
 
 	void read();
 
+	/**
+	 * Rereads only snapshots whose info.xml was replaced since the
+	 * last read and drops or adds snapshots deleted or created by
+	 * others. Returns true if anything changed.
+	 */
+	bool refresh();
+
+	bool readInfo(const SDir& infos_dir, const string& name, Snapshot& snapshot) const;
+
 	void check() const;
 
 	void checkUserdata(const map<string, string>& userdata) const;
@@ -276,9 +292,19 @@ namespace snapper
 	iterator createHelper(Snapshot& snapshot, const_iterator parent, bool read_only,
 			      bool empty = false);
 
+	static vector<iterator> createSingleSnapshots(const vector<Snapshots*>& snapshots,
+						      const SCD& scd);
+
+	/**
+	 * Removes the info directory and optionally the filesystem snapshot
+	 * of a snapshot not yet added to the list. Errors are ignored.
+	 */
+	void discardSnapshot(const Snapshot& snapshot, bool filesystem_snapshot) const;
+
 	void modifySnapshot(iterator snapshot, const SMD& smd);
 
-	void deleteSnapshot(iterator snapshot);
+	void deleteSnapshot(iterator snapshot, const std::function<void()>& unlock,
+			    const std::function<void()>& lock);
 
 	unsigned int nextNumber();
 
@@ -147,66 +147,20 @@ namespace snapper
     {
 	y2deb("entering Xattributes(path=" << file.fullname(true) << ") constructor");
 
-	ssize_t size = file.listxattr(NULL, 0);
-	if (size < 0)
-	{
-	    y2err("Couldn't get xattributes names-list size. link: " << file.fullname(true) <<
-		  ", error: " << stringerror(errno));
-	    SN_THROW(XAttributesException());
-	}
-
-	y2deb("XAttributes names-list size is: " << size);
-
-	if (size == 0)
-	    return;
-
-	boost::scoped_array<char> names(new char[size]);
-
-	size = file.listxattr(names.get(), size);
-	if (size < 0)
-	{
-	    y2err("Couldn't get xattributes names-list. link: " << file.fullname(true) <<
-		  ", error: " << stringerror(errno));
-	    SN_THROW(XAttributesException());
-	}
-
-	ssize_t pos = 0;
-	while (pos < size)
-	{
-	    string name = string(names.get() + pos);
-	    // move beyond separating '\0' char
-	    pos += name.length() + 1;
-
-	    ssize_t v_size = file.getxattr(name.c_str(), NULL, 0);
-	    if (v_size < 0)
-	    {
-		y2err("Couldn't get a xattribute value size for the xattribute name '" <<
-		      name << "': " << stringerror(errno));
-		SN_THROW(XAttributesException());
-	    }
-
-	    y2deb("XAttribute value size for xattribute name: '" << name << "' is " << v_size);
-
-	    boost::scoped_array<uint8_t> buffer(new uint8_t[v_size]);
-
-	    if (v_size > 0)
-	    {
-		v_size = file.getxattr(name.c_str(), buffer.get(), v_size);
-		if (v_size < 0)
-		{
-		    y2err("Couldn't get xattribute value for the xattribute name '" << name << "': ");
-		    SN_THROW(XAttributesException());
-		}
-	    }
-
-	    if (!xamap.insert(make_pair(name, xa_value_t(buffer.get(), buffer.get() + v_size))).second)
+	bool ok = file.readxattrs([this](const char* name, const uint8_t* value, size_t size) {
+	    if (!xamap.emplace(name, xa_value_t(value, value + size)).second)
 	    {
 		y2err("Duplicite extended attribute name in source file!");
 		SN_THROW(XAttributesException());
 	    }
-	}
+	});
 
-	assert(pos == size);
+	if (!ok)
+	{
+	    y2err("Couldn't get xattributes. link: " << file.fullname(true) << ", error: " <<
+		  stringerror(errno));
+	    SN_THROW(XAttributesException());
+	}
     }
 
 
@@ -0,0 +1,90 @@
+
+#include <unistd.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include <snapper/AsciiFile.h>
+
+using namespace std;
+using namespace std::chrono;
+using namespace snapper;
+
+
+// Compares save and load time and size of a filelist with one million
+// lines for all available compressions. Loading is done both with and
+// without copying the lines.
+
+
+int
+main()
+{
+    vector<string> lines;
+
+    lines.push_back("snapper-0.10.0-list-1-begin");
+    for (unsigned int i = 0; i < 1000000; ++i)
+	lines.push_back("c..... /usr/share/locale/" + to_string(i % 300) + "/LC_MESSAGES/package-" +
+			to_string(i) + ".mo");
+    lines.push_back("snapper-0.10.0-list-1-end");
+
+    for (Compression compression : { Compression::NONE, Compression::GZIP, Compression::ZSTD })
+    {
+	if (!is_available(compression))
+	    continue;
+
+	string name = add_extension(compression, "filelist");
+
+	try
+	{
+	    steady_clock::time_point t0 = steady_clock::now();
+
+	    AsciiFileWriter writer(name, compression);
+	    for (const string& line : lines)
+		writer.write_line(line);
+	    writer.close();
+
+	    steady_clock::time_point t1 = steady_clock::now();
+
+	    size_t n = 0;
+
+	    AsciiFileReader reader(name, compression);
+	    string line;
+	    while (reader.read_line(line))
+		++n;
+	    reader.close();
+
+	    steady_clock::time_point t2 = steady_clock::now();
+
+	    size_t m = 0;
+
+	    AsciiFileReader view_reader(name, compression);
+	    const char* data;
+	    size_t size;
+	    while (view_reader.read_line(data, size))
+		++m;
+	    view_reader.close();
+
+	    steady_clock::time_point t3 = steady_clock::now();
+
+	    struct stat buf;
+	    stat(name.c_str(), &buf);
+
+	    cout << name << ": save " << duration_cast<milliseconds>(t1 - t0).count() << " ms, "
+		 << "load " << duration_cast<milliseconds>(t2 - t1).count() << " ms, "
+		 << "load without copy " << duration_cast<milliseconds>(t3 - t2).count() << " ms, "
+		 << "size " << buf.st_size << " bytes, " << n << " lines" << endl;
+
+	    if (m != n)
+		cerr << "line count mismatch" << endl;
+	}
+	catch (const Exception& e)
+	{
+	    SN_CAUGHT(e);
+
+	    cerr << e.what() << '\n';
+	}
+
+	unlink(name.c_str());
+    }
+}
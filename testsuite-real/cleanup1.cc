@@ -0,0 +1,105 @@
+
+#include "common.h"
+
+#include <snapper/Snapper.h>
+
+#include "proxy/proxy-lib.h"
+#include "proxy/cleanup.h"
+
+using namespace std;
+using namespace snapper;
+
+
+extern Snapper* sh;
+
+extern Snapshots::iterator first;
+extern Snapshots::iterator second;
+
+
+bool
+exists(unsigned int num)
+{
+    return sh->getSnapshots().find(num) != sh->getSnapshots().end();
+}
+
+
+int
+main()
+{
+    setup();
+
+    string min_age = "1800";
+    sh->getConfigInfo().get_value("EMPTY_PRE_POST_MIN_AGE", min_age);
+    sh->setConfigInfo({ { "EMPTY_PRE_POST_MIN_AGE", "0" } });
+
+    run_command("echo test > file");
+
+    first_snapshot();
+
+    second_snapshot();
+
+    unsigned int num1 = first->getNum();
+    unsigned int num2 = second->getNum();
+
+    SCD scd;
+    scd.description = CONFIG;
+    scd.cleanup = "number";
+
+    Snapshots::iterator pre = sh->createPreSnapshot(scd);
+
+    run_command("echo changed > file");
+
+    Snapshots::iterator post = sh->createPostSnapshot(pre, scd);
+
+    // only the empty pre and post pair is deleted
+
+    ProxySnapperLib proxy_snapper(sh);
+    do_cleanup(&proxy_snapper, "empty-pre-post", false);
+
+    check_true(!exists(num1));
+    check_true(!exists(num2));
+    check_true(exists(pre->getNum()));
+    check_true(exists(post->getNum()));
+
+    // the lock functions must be called exactly once around deleting the
+    // filesystem snapshot, invalid snapshots are detected before unlocking
+
+    unsigned int unlocked = 0, locked = 0;
+
+    std::function<void()> unlock = [&unlocked, &locked]() {
+	check_equal(unlocked, locked);
+	++unlocked;
+    };
+
+    std::function<void()> lock = [&unlocked, &locked]() {
+	++locked;
+	check_equal(locked, unlocked);
+    };
+
+    try
+    {
+	sh->deleteSnapshot(sh->getSnapshots().end(), unlock, lock);
+	check_true(false);
+    }
+    catch (const IllegalSnapshotException& e)
+    {
+    }
+
+    check_equal(unlocked, 0U);
+    check_equal(locked, 0U);
+
+    unsigned int num3 = post->getNum();
+    sh->deleteSnapshot(post, unlock, lock);
+
+    check_true(!exists(num3));
+    check_equal(unlocked, 1U);
+    check_equal(locked, 1U);
+
+    sh->deleteSnapshot(pre);
+
+    sh->setConfigInfo({ { "EMPTY_PRE_POST_MIN_AGE", min_age } });
+
+    delete sh;
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,125 @@
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include <snapper/AppUtil.h>
+
+using namespace std;
+using namespace std::chrono;
+using namespace snapper;
+
+
+// Compares copying a 1 GiB file with copyfile() and with the former
+// implementation looping over sendfile in 64 KiB chunks, once for a
+// dense file and once for a sparse file with 64 MiB of data. The files
+// are created in the current directory, so run it on the filesystem of
+// interest.
+
+
+const off_t size = 1024 * 1024 * 1024;
+
+
+bool
+former_copyfile(int src_fd, int dest_fd)
+{
+    posix_fadvise(src_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    while (true)
+    {
+	ssize_t r1 = sendfile(dest_fd, src_fd, NULL, 0x10000);
+	if (r1 == 0)
+	    return true;
+
+	if (r1 < 0)
+	    return false;
+    }
+}
+
+
+int
+create_file(bool sparse)
+{
+    char name[] = "copyfile-bench-XXXXXX";
+    int fd = mkstemp(name);
+    if (fd < 0)
+    {
+	cerr << "mkstemp failed" << endl;
+	exit(EXIT_FAILURE);
+    }
+    unlink(name);
+
+    // write 1 MiB of data, in the sparse case only every 16 MiB
+
+    const vector<char> data(1024 * 1024, 'x');
+
+    for (off_t offset = 0; offset < size; offset += sparse ? 16 * data.size() : data.size())
+    {
+	if (pwrite(fd, data.data(), data.size(), offset) != (ssize_t) data.size())
+	{
+	    cerr << "pwrite failed" << endl;
+	    exit(EXIT_FAILURE);
+	}
+    }
+
+    if (ftruncate(fd, size) != 0 || fsync(fd) != 0)
+    {
+	cerr << "ftruncate failed" << endl;
+	exit(EXIT_FAILURE);
+    }
+
+    return fd;
+}
+
+
+void
+run(const char* name, int src_fd, bool (*copy)(int src_fd, int dest_fd))
+{
+    char dest_name[] = "copyfile-bench-XXXXXX";
+    int dest_fd = mkstemp(dest_name);
+    if (dest_fd < 0)
+    {
+	cerr << "mkstemp failed" << endl;
+	exit(EXIT_FAILURE);
+    }
+    unlink(dest_name);
+
+    lseek(src_fd, 0, SEEK_SET);
+
+    steady_clock::time_point t0 = steady_clock::now();
+
+    if (!copy(src_fd, dest_fd) || fsync(dest_fd) != 0)
+	cerr << "copying failed" << endl;
+
+    steady_clock::time_point t1 = steady_clock::now();
+
+    struct stat buf;
+    fstat(dest_fd, &buf);
+
+    cout << name << " " << duration_cast<milliseconds>(t1 - t0).count() << " ms, "
+	 << buf.st_blocks * 512 / (1024 * 1024) << " MiB allocated" << endl;
+
+    close(dest_fd);
+}
+
+
+int
+main()
+{
+    for (bool sparse : { false, true })
+    {
+	int src_fd = create_file(sparse);
+
+	cout << (sparse ? "sparse" : "dense") << " file" << endl;
+
+	run("former", src_fd, former_copyfile);
+	run("copyfile", src_fd, copyfile);
+
+	close(src_fd);
+    }
+}
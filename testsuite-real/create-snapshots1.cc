@@ -0,0 +1,108 @@
+
+#include "common.h"
+
+#include <unistd.h>
+
+#include <snapper/Snapper.h>
+#include <snapper/Exception.h>
+
+#include "proxy/proxy.h"
+
+using namespace std;
+using namespace snapper;
+
+
+extern Snapper* sh;
+
+
+#define SECOND_CONFIG CONFIG "-second"
+#define SECOND_SUBVOLUME SUBVOLUME "/second"
+
+
+bool
+exists(const string& path)
+{
+    return access(path.c_str(), F_OK) == 0;
+}
+
+
+unsigned int
+highest(ProxySnapper* proxy_snapper)
+{
+    unsigned int num = 0;
+    for (const ProxySnapshot& proxy_snapshot : proxy_snapper->getSnapshots())
+	num = max(num, proxy_snapshot.getNum());
+    return num;
+}
+
+
+int
+main()
+{
+    setup();
+
+    run_command("btrfs subvolume create " SECOND_SUBVOLUME " > /dev/null");
+    Snapper::createConfig(SECOND_CONFIG, "/", SECOND_SUBVOLUME, "btrfs", "default");
+
+    ProxySnappers proxy_snappers(ProxySnappers::createLib("/"));
+
+    const vector<string> config_names = { CONFIG, SECOND_CONFIG };
+    vector<ProxySnapper*> tmp = proxy_snappers.getSnappers(config_names);
+
+    SCD scd;
+    scd.description = CONFIG;
+    scd.cleanup = "number";
+
+    // both snapshots are created with the same date
+
+    vector<ProxySnapshots::const_iterator> snapshots = proxy_snappers.createSingleSnapshots(config_names, scd);
+
+    check_equal(snapshots.size(), (size_t) 2);
+    check_equal(snapshots[0]->getDate(), snapshots[1]->getDate());
+
+    unsigned int num1 = snapshots[0]->getNum();
+    unsigned int num2 = snapshots[1]->getNum();
+
+    check_true(exists(SUBVOLUME "/.snapshots/" + to_string(num1) + "/snapshot"));
+    check_true(exists(SECOND_SUBVOLUME "/.snapshots/" + to_string(num2) + "/snapshot"));
+
+    // a failure for the second config removes the snapshot already
+    // allocated for the first config
+
+    unsigned int highest1 = highest(tmp[0]);
+    unsigned int highest2 = highest(tmp[1]);
+
+    run_command("chattr +i " SECOND_SUBVOLUME "/.snapshots");
+
+    try
+    {
+	proxy_snappers.createSingleSnapshots(config_names, scd);
+	check_true(false);
+    }
+    catch (const Exception& e)
+    {
+    }
+
+    run_command("chattr -i " SECOND_SUBVOLUME "/.snapshots");
+
+    check_equal(highest(tmp[0]), highest1);
+    check_equal(highest(tmp[1]), highest2);
+
+    check_true(!exists(SUBVOLUME "/.snapshots/" + to_string(highest1 + 1)));
+    check_true(!exists(SECOND_SUBVOLUME "/.snapshots/" + to_string(highest2 + 1)));
+
+    {
+	Snapper snapper(CONFIG, "/");
+	check_true(snapper.getSnapshots().find(highest1 + 1) == snapper.getSnapshots().end());
+    }
+
+    tmp[0]->deleteSnapshots({ tmp[0]->getSnapshots().find(num1) }, false);
+    tmp[1]->deleteSnapshots({ tmp[1]->getSnapshots().find(num2) }, false);
+
+    Snapper::deleteConfig(SECOND_CONFIG, "/");
+    run_command("btrfs subvolume delete " SECOND_SUBVOLUME " > /dev/null");
+
+    delete sh;
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,128 @@
+
+#include <stdio.h>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include <dbus/DBusMessage.h>
+
+using namespace std;
+using namespace std::chrono;
+using namespace DBus;
+
+
+// Marshals and unmarshals one million file entries, with the signature
+// used by GetFiles, into a DBus message without sending it. Escaping of
+// the names is compared with the former implementation using snprintf
+// for every escaped character and copying strings needing no escaping.
+
+
+struct Entry
+{
+    string name;
+    dbus_uint32_t status;
+};
+
+
+string
+former_escape(const string& in)
+{
+    string out;
+
+    for (const char c : in)
+    {
+	if (c == '\\')
+	{
+	    out += "\\\\";
+	}
+	else if ((unsigned char)(c) > 127)
+	{
+	    char s[5];
+	    snprintf(s, 5, "\\x%02x", (unsigned char)(c));
+	    out += string(s);
+	}
+	else
+	{
+	    out += c;
+	}
+    }
+
+    return out;
+}
+
+
+int
+main()
+{
+    vector<Entry> entries;
+
+    // every hundredth name needs escaping
+
+    for (unsigned int i = 0; i < 1000000; ++i)
+	entries.push_back({ "/usr/share/locale/" + string(i % 100 == 0 ? "fr_Fröhlich" : "de") +
+			    "/LC_MESSAGES/package-" + to_string(i) + ".mo", i % 64 });
+
+    steady_clock::time_point t0 = steady_clock::now();
+
+    size_t size1 = 0;
+    for (const Entry& entry : entries)
+	size1 += former_escape(entry.name).size();
+
+    steady_clock::time_point t1 = steady_clock::now();
+
+    size_t size2 = 0;
+    for (const Entry& entry : entries)
+	size2 += Hoho::escape(entry.name).size();
+
+    steady_clock::time_point t2 = steady_clock::now();
+
+    MessageMethodCall msg("org.opensuse.Snapper", "/org/opensuse/Snapper",
+			  "org.opensuse.Snapper", "Bench");
+
+    {
+	Hoho hoho(msg);
+	hoho.open_array("(su)");
+	for (const Entry& entry : entries)
+	{
+	    hoho.open_struct();
+	    hoho << entry.name << entry.status;
+	    hoho.close_struct();
+	}
+	hoho.close_array();
+    }
+
+    steady_clock::time_point t3 = steady_clock::now();
+
+    vector<Entry> result;
+
+    {
+	Hihi hihi(msg);
+	hihi.open_recurse();
+	while (hihi.get_type() != DBUS_TYPE_INVALID)
+	{
+	    Entry entry;
+	    hihi.open_recurse();
+	    hihi >> entry.name >> entry.status;
+	    hihi.close_recurse();
+	    result.push_back(entry);
+	}
+	hihi.close_recurse();
+    }
+
+    steady_clock::time_point t4 = steady_clock::now();
+
+    cout << entries.size() << " entries" << endl;
+
+    cout << "former escape " << duration_cast<milliseconds>(t1 - t0).count() << " ms, "
+	 << "escape " << duration_cast<milliseconds>(t2 - t1).count() << " ms" << endl;
+
+    cout << "marshalling " << duration_cast<milliseconds>(t3 - t2).count() << " ms, "
+	 << "unmarshalling " << duration_cast<milliseconds>(t4 - t3).count() << " ms" << endl;
+
+    if (size1 != size2)
+	cerr << "escape results differ" << endl;
+
+    if (result.size() != entries.size() || result.back().name != entries.back().name ||
+	result.front().name != entries.front().name)
+	cerr << "unmarshalled entries differ" << endl;
+}
@@ -0,0 +1,82 @@
+
+#include "common.h"
+
+#include <snapper/Snapper.h>
+#include <snapper/Comparison.h>
+
+using namespace std;
+using namespace snapper;
+
+
+extern Snapper* sh;
+
+extern Snapshots::iterator first;
+extern Snapshots::iterator second;
+
+
+int
+main()
+{
+    setup();
+
+    run_command("echo test > file");
+
+    first_snapshot();
+
+    second_snapshot();
+
+    run_command("echo changed > file");
+
+    SCD scd;
+    scd.description = CONFIG;
+    Snapshots::iterator third = sh->createSingleSnapshot(scd);
+
+    const vector<Comparison::snapshot_pair_t> pairs = {
+	{ first, second }, { second, third }, { first, third }, { third, sh->getSnapshotCurrent() }
+    };
+
+    // the lock functions must be called exactly once around comparing
+
+    unsigned int unlocked = 0, locked = 0;
+
+    for (unsigned int jobs : { 1, 4 })
+    {
+	vector<bool> empty = Comparison::areEmpty(sh, pairs, jobs, [&unlocked, &locked]() {
+	    check_equal(unlocked, locked);
+	    ++unlocked;
+	}, [&unlocked, &locked]() {
+	    ++locked;
+	    check_equal(locked, unlocked);
+	});
+
+	check_equal(empty.size(), pairs.size());
+	check_true(empty[0]);
+	check_true(!empty[1]);
+	check_true(!empty[2]);
+	check_true(empty[3]);
+    }
+
+    check_equal(unlocked, 2U);
+    check_equal(locked, 2U);
+
+    // invalid pairs are detected before unlocking
+
+    try
+    {
+	Comparison::areEmpty(sh, { { first, first } }, 1, [&unlocked]() { ++unlocked; },
+			     [&locked]() { ++locked; });
+	check_true(false);
+    }
+    catch (const IllegalSnapshotException& e)
+    {
+    }
+
+    check_equal(unlocked, 2U);
+    check_equal(locked, 2U);
+
+    sh->deleteSnapshot(third);
+
+    cleanup();
+
+    exit(EXIT_SUCCESS);
+}
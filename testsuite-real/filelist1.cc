@@ -0,0 +1,103 @@
+
+#include "common.h"
+
+#include <unistd.h>
+
+#include <snapper/Snapper.h>
+#include <snapper/Comparison.h>
+#include <snapper/AsciiFile.h>
+
+using namespace std;
+using namespace snapper;
+
+
+extern Snapper* sh;
+
+extern Snapshots::iterator first;
+extern Snapshots::iterator second;
+
+
+#define INFOS_DIR SUBVOLUME "/.snapshots/"
+
+
+bool
+exists(const string& path)
+{
+    return access(path.c_str(), F_OK) == 0;
+}
+
+
+string
+filelist(unsigned int num1, unsigned int num2)
+{
+    return INFOS_DIR + to_string(num2) + "/filelist-" + to_string(num1) + ".txt.zst";
+}
+
+
+int
+main()
+{
+    if (!is_available(Compression::ZSTD))
+    {
+	cout << "zstd not available" << endl;
+	exit(EXIT_SUCCESS);
+    }
+
+    setup();
+
+    string compression = "gzip";
+    sh->getConfigInfo().get_value("COMPRESSION", compression);
+    sh->setConfigInfo({ { "COMPRESSION", "zstd" } });
+
+    run_command("echo test > file");
+
+    first_snapshot();
+
+    run_command("echo changed > file");
+
+    second_snapshot();
+
+    SCD scd;
+    scd.description = CONFIG;
+    scd.cleanup = "number";
+
+    Snapshots::iterator third = sh->createSingleSnapshot(scd);
+
+    unsigned int num1 = first->getNum();
+    unsigned int num2 = second->getNum();
+    unsigned int num3 = third->getNum();
+
+    // the comparisons save zstd compressed filelists
+
+    {
+	Comparison comparison1(sh, first, second, false);
+	Comparison comparison2(sh, second, third, false);
+    }
+
+    check_true(exists(filelist(num1, num2)));
+    check_true(exists(filelist(num2, num3)));
+
+    // deleting the second snapshot removes its info directory completely
+    // and its filelist in the info directory of the third snapshot
+
+    sh->deleteSnapshot(second);
+
+    check_true(!exists(INFOS_DIR + to_string(num2)));
+    check_true(!exists(filelist(num2, num3)));
+
+    // a reload does not find a half deleted snapshot
+
+    {
+	Snapper snapper(CONFIG, "/");
+	check_true(snapper.getSnapshots().find(num2) == snapper.getSnapshots().end());
+    }
+
+    sh->deleteSnapshot(third);
+    sh->deleteSnapshot(first);
+
+    sh->setConfigInfo({ { "COMPRESSION", compression } });
+
+    delete sh;
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,68 @@
+
+#include <chrono>
+#include <iostream>
+
+#include <snapper/Log.h>
+
+using namespace std;
+using namespace std::chrono;
+using namespace snapper;
+
+
+// Compares 100 million disabled debug log calls with the cached log
+// level and with the former implementation calling the log query
+// function for every log call.
+
+
+const unsigned int calls = 100000000;
+
+
+bool
+log_query(LogLevel level, const string& component)
+{
+    return level != DEBUG;
+}
+
+
+__attribute__((noinline)) bool
+former_test_log_level(LogLevel level)
+{
+    static const string component = "libsnapper";
+
+    return callLogQuery(level, component);
+}
+
+
+#define former_y2deb(op)						\
+    do {								\
+	if (former_test_log_level(snapper::DEBUG))			\
+	{								\
+	    std::ostringstream* __buf = snapper::logStreamOpen();	\
+	    *__buf << op;						\
+	    snapper::logStreamClose(snapper::DEBUG, __FILE__, __LINE__, __FUNCTION__, __buf); \
+	}								\
+    } while (0)
+
+
+int
+main()
+{
+    setLogQuery(log_query);
+
+    steady_clock::time_point t0 = steady_clock::now();
+
+    for (volatile unsigned int i = 0; i < calls; ++i)
+	former_y2deb("log-level-bench call:" << i);
+
+    steady_clock::time_point t1 = steady_clock::now();
+
+    for (volatile unsigned int i = 0; i < calls; ++i)
+	y2deb("log-level-bench call:" << i);
+
+    steady_clock::time_point t2 = steady_clock::now();
+
+    cout << calls << " disabled log calls" << endl;
+
+    cout << "former " << duration_cast<milliseconds>(t1 - t0).count() << " ms, "
+	 << "cached " << duration_cast<milliseconds>(t2 - t1).count() << " ms" << endl;
+}
@@ -0,0 +1,144 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <iostream>
+#include <boost/thread.hpp>
+
+#include <snapper/Log.h>
+#include <snapper/AppUtil.h>
+#include <snapper/SystemCmd.h>
+
+using namespace std;
+using namespace std::chrono;
+using namespace snapper;
+
+
+// Compares four threads logging 20000 two-line entries each with the
+// default logger and with the former implementation opening and closing
+// the log file for every entry while holding a global mutex. Both write
+// to temporary files. Finally a command is run while logging to check
+// that forking does not deadlock.
+
+
+const unsigned int threads = 4;
+const unsigned int entries = 20000;
+
+string former_filename;
+boost::mutex former_mutex;
+
+
+void
+former_log_do(LogLevel level, const string& component, const char* file, int line,
+	      const char* func, const string& text)
+{
+    static const char* ln[4] = { "DEB", "MIL", "WAR", "ERR" };
+
+    string prefix = sformat("%s %s libsnapper(%d) %s(%s):%d", datetime(time(0), false, true).c_str(),
+			    ln[level], getpid(), file, func, line);
+
+    boost::lock_guard<boost::mutex> lock(former_mutex);
+
+    FILE* f = fopen(former_filename.c_str(), "ae");
+    if (f)
+    {
+	string::size_type pos1 = 0;
+	while (true)
+	{
+	    string::size_type pos2 = text.find('\n', pos1);
+
+	    if (pos2 != string::npos || pos1 != text.length())
+		fprintf(f, "%s - %s\n", prefix.c_str(), text.substr(pos1, pos2 - pos1).c_str());
+
+	    if (pos2 == string::npos)
+		break;
+	    pos1 = pos2 + 1;
+	}
+
+	fclose(f);
+    }
+}
+
+
+string
+create_tmp_file()
+{
+    char tmp[] = "/tmp/snapper-logger-bench-XXXXXX";
+    int fd = mkstemp(tmp);
+    if (fd < 0)
+    {
+	cerr << "mkstemp failed" << endl;
+	exit(EXIT_FAILURE);
+    }
+    close(fd);
+
+    return tmp;
+}
+
+
+double
+run()
+{
+    steady_clock::time_point t0 = steady_clock::now();
+
+    boost::thread_group group;
+
+    for (unsigned int i = 0; i < threads; ++i)
+    {
+	group.create_thread([i]() {
+	    for (unsigned int j = 0; j < entries; ++j)
+		y2mil("logger-bench thread:" << i << " entry:" << j << "\nsecond line");
+	});
+    }
+
+    group.join_all();
+
+    steady_clock::time_point t1 = steady_clock::now();
+
+    flushLog();
+
+    return duration_cast<nanoseconds>(t1 - t0).count() / 1000.0 / (threads * entries);
+}
+
+
+int
+main()
+{
+    former_filename = create_tmp_file();
+
+    setLogDo(former_log_do);
+
+    double former = run();
+
+    const string filename = create_tmp_file();
+
+    initDefaultLogger(filename);
+
+    double async = run();
+
+    unlink(former_filename.c_str());
+
+    cout << threads << " threads, " << entries << " entries each" << endl;
+
+    cout << "former " << former << " us per entry, "
+	 << "asynchronous " << async << " us per entry" << endl;
+
+    boost::thread logging([]() {
+	for (unsigned int j = 0; j < entries; ++j)
+	    y2mil("logger-bench fork entry:" << j);
+    });
+
+    for (unsigned int j = 0; j < 100; ++j)
+    {
+	SystemCmd cmd("/bin/true");
+	if (cmd.retcode() != 0)
+	    cerr << "running command failed" << endl;
+    }
+
+    logging.join();
+
+    flushLog();
+
+    unlink(filename.c_str());
+}
@@ -0,0 +1,120 @@
+
+#include "common.h"
+
+#include <unistd.h>
+#include <sys/stat.h>
+#include <fstream>
+
+#include <snapper/Snapper.h>
+#include <snapper/SnapperDefines.h>
+
+using namespace std;
+using namespace snapper;
+
+
+extern Snapper* sh;
+
+
+#define INFOS_DIR SUBVOLUME "/.snapshots"
+#define HINT INFOS_DIR "/" NEXT_NUMBER_NAME
+
+
+vector<unsigned int> nums;
+
+
+unsigned int
+highest()
+{
+    unsigned int num = 0;
+    for (const Snapshot& snapshot : sh->getSnapshots())
+	num = max(num, snapshot.getNum());
+    return num;
+}
+
+
+void
+write_hint(const string& content)
+{
+    ofstream(HINT) << content;
+}
+
+
+string
+read_hint()
+{
+    string content;
+    getline(ifstream(HINT), content);
+    return content;
+}
+
+
+unsigned int
+create()
+{
+    SCD scd;
+    scd.description = CONFIG;
+    scd.cleanup = "number";
+
+    unsigned int num = sh->createSingleSnapshot(scd)->getNum();
+    nums.push_back(num);
+
+    check_equal(read_hint(), to_string(num));
+
+    return num;
+}
+
+
+int
+main()
+{
+    setup();
+
+    // missing
+
+    unlink(HINT);
+    unsigned int num = highest();
+    check_equal(create(), num + 1);
+
+    // smaller than the highest snapshot
+
+    write_hint("1\n");
+    num = highest();
+    check_equal(create(), num + 1);
+
+    // ahead of the highest snapshot, numbers are not reused
+
+    num = highest();
+    write_hint(to_string(num + 10) + "\n");
+    check_equal(create(), num + 11);
+
+    // stale, a directory was created behind the back of the hint, also
+    // removes a left over temporary file
+
+    num = highest();
+    write_hint(to_string(num) + "\n");
+    check_zero(mkdir((INFOS_DIR "/" + to_string(num + 1)).c_str(), 0755));
+    check_zero(mkdir((INFOS_DIR "/" + to_string(num + 2)).c_str(), 0755));
+    ofstream(INFOS_DIR "/" NEXT_NUMBER_NAME ".tmp-abcdef") << num << endl;
+    check_equal(create(), num + 3);
+    check_true(access(INFOS_DIR "/" NEXT_NUMBER_NAME ".tmp-abcdef", F_OK) != 0);
+    check_zero(rmdir((INFOS_DIR "/" + to_string(num + 1)).c_str()));
+    check_zero(rmdir((INFOS_DIR "/" + to_string(num + 2)).c_str()));
+
+    // corrupt
+
+    for (const string& content : { string("garbage\n"), string("-5\n"), string(" 7\n"),
+				   string("12abc\n"), string("4294967295\n"),
+				   string("99999999999999999999\n"), string("") })
+    {
+	write_hint(content);
+	num = highest();
+	check_equal(create(), num + 1);
+    }
+
+    for (unsigned int tmp : nums)
+	sh->deleteSnapshot(sh->getSnapshots().find(tmp));
+
+    delete sh;
+
+    exit(EXIT_SUCCESS);
+}
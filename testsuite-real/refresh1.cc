@@ -0,0 +1,114 @@
+#include "common.h"
+
+#include <snapper/Snapper.h>
+#include <snapper/Filesystem.h>
+
+using namespace std;
+using namespace snapper;
+
+
+extern Snapper* sh;
+
+
+void
+check_snapshots(const Snapshots& snapshots1, const Snapshots& snapshots2)
+{
+    check_equal(snapshots1.size(), snapshots2.size());
+
+    Snapshots::const_iterator it1 = snapshots1.begin();
+    Snapshots::const_iterator it2 = snapshots2.begin();
+
+    for (; it1 != snapshots1.end(); ++it1, ++it2)
+    {
+	check_equal(it1->getNum(), it2->getNum());
+	check_equal(it1->getType(), it2->getType());
+	check_equal(it1->getDate(), it2->getDate());
+	check_equal(it1->getUid(), it2->getUid());
+	check_equal(it1->getPreNum(), it2->getPreNum());
+	check_equal(it1->getDescription(), it2->getDescription());
+	check_equal(it1->getCleanup(), it2->getCleanup());
+	check_true(it1->getUserdata() == it2->getUserdata());
+    }
+}
+
+
+void
+check_refreshed()
+{
+    Snapper snapper(CONFIG, "/");
+    check_snapshots(sh->getSnapshots(), snapper.getSnapshots());
+}
+
+
+int
+main()
+{
+    setup();
+
+    SCD scd;
+    scd.description = CONFIG;
+    scd.cleanup = "number";
+
+    unsigned int num1 = sh->createSingleSnapshot(scd)->getNum();
+    unsigned int num2 = sh->createSingleSnapshot(scd)->getNum();
+    unsigned int num3 = sh->createSingleSnapshot(scd)->getNum();
+
+    Snapshots::iterator snapshot1 = sh->getSnapshots().find(num1);
+
+    // nothing changed, so nothing is refreshed
+
+    check_true(!sh->refreshSnapshots());
+    check_refreshed();
+
+    snapshot1->mountFilesystemSnapshot(false);
+
+    // modify, delete and create snapshots behind the back of sh
+
+    unsigned int num4;
+
+    {
+	Snapper snapper(CONFIG, "/");
+	Snapshots& snapshots = snapper.getSnapshots();
+
+	SMD smd;
+	smd.description = "changed";
+	smd.cleanup = "number";
+	smd.userdata = { { "key", "value" } };
+	snapper.modifySnapshot(snapshots.find(num1), smd);
+
+	snapper.deleteSnapshot(snapshots.find(num2));
+
+	num4 = snapper.createSingleSnapshot(scd)->getNum();
+    }
+
+    check_true(sh->refreshSnapshots());
+    check_refreshed();
+
+    // the replaced info.xml is read again into the same snapshot object
+
+    check_true(sh->getSnapshots().find(num1) == snapshot1);
+    check_equal(snapshot1->getDescription(), string("changed"));
+
+    check_true(sh->getSnapshots().find(num2) == sh->getSnapshots().end());
+    check_true(sh->getSnapshots().find(num4) != sh->getSnapshots().end());
+
+    // the mount state of the reread snapshot is kept, so it is still
+    // mounted until the last user unmounts it
+
+    snapshot1->handleUmountFilesystemSnapshot();
+    check_true(sh->getFilesystem()->isSnapshotMounted(num1));
+
+    snapshot1->umountFilesystemSnapshot(false);
+    snapshot1->handleUmountFilesystemSnapshot();
+
+    check_true(!sh->refreshSnapshots());
+    check_refreshed();
+
+    sh->deleteSnapshot(sh->getSnapshots().find(num4));
+    sh->deleteSnapshot(sh->getSnapshots().find(num3));
+    sh->deleteSnapshot(sh->getSnapshots().find(num1));
+
+    delete sh;
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,90 @@
+#include "common.h"
+
+#include <unistd.h>
+#include <algorithm>
+
+#include <snapper/Snapper.h>
+#include <snapper/SnapperDefines.h>
+
+#include "MetaSnapper.h"
+
+using namespace std;
+using namespace snapper;
+
+
+extern Snapper* sh;
+
+
+#define FILTER_FILE ETC_FILTERS_DIR "/testsuite-refresh2.txt"
+#define FILTER_PATTERN "/testsuite-refresh2"
+
+
+bool
+has_pattern(const Snapper* snapper)
+{
+    const vector<string>& patterns = snapper->getIgnorePatterns();
+    return find(patterns.begin(), patterns.end(), FILTER_PATTERN) != patterns.end();
+}
+
+
+int
+main()
+{
+    setup();
+
+    meta_snappers.init();
+
+    MetaSnappers::iterator meta_snapper = meta_snappers.find(CONFIG);
+
+    check_true(!has_pattern(meta_snapper->getSnapper()));
+
+    // a snapshot created behind the back of the meta snapper is found by
+    // the refresh
+
+    SCD scd;
+    scd.description = CONFIG;
+    scd.cleanup = "number";
+
+    unsigned int num1 = sh->createSingleSnapshot(scd)->getNum();
+
+    meta_snapper->mark_stale();
+
+    Snapshots& snapshots = meta_snapper->getSnapper()->getSnapshots();
+    check_true(snapshots.find(num1) != snapshots.end());
+
+    // an added filter file reloads the snapper object
+
+    run_command("echo " FILTER_PATTERN " > " FILTER_FILE);
+
+    meta_snapper->mark_stale();
+    check_true(has_pattern(meta_snapper->getSnapper()));
+
+    // so does a removed one
+
+    check_zero(unlink(FILTER_FILE));
+
+    meta_snapper->mark_stale();
+    check_true(!has_pattern(meta_snapper->getSnapper()));
+
+    // and a changed config file
+
+    string number_limit = "50";
+    sh->getConfigInfo().get_value("NUMBER_LIMIT", number_limit);
+    sh->setConfigInfo({ { "NUMBER_LIMIT", "42" } });
+
+    meta_snapper->mark_stale();
+
+    string value;
+    check_true(meta_snapper->getSnapper()->getConfigInfo().get_value("NUMBER_LIMIT", value));
+    check_equal(value, string("42"));
+
+    sh->setConfigInfo({ { "NUMBER_LIMIT", number_limit } });
+
+    meta_snappers.unload();
+
+    sh->deleteSnapshot(sh->getSnapshots().find(num1));
+
+    delete sh;
+
+    exit(EXIT_SUCCESS);
+}
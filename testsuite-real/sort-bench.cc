@@ -0,0 +1,59 @@
+
+#include <chrono>
+#include <iostream>
+#include <locale>
+#include <algorithm>
+
+#include <snapper/File.h>
+
+using namespace std;
+using namespace std::chrono;
+using namespace snapper;
+
+
+namespace snapper
+{
+    bool cmp_lt(const string& lhs, const string& rhs);
+}
+
+
+// Compares sorting 500000 file names with Files::sort, using collation
+// keys, and with the former implementation comparing every pair of names
+// with cmp_lt. The locale is taken from the environment, e.g. run it
+// with LC_ALL=C.UTF-8.
+
+
+int
+main()
+{
+    std::locale::global(std::locale(""));
+
+    vector<File> entries;
+
+    for (unsigned int i = 0; i < 500000; ++i)
+	entries.emplace_back(nullptr, "/usr/share/locale/" + to_string(i % 300) + "/LC_MESSAGES/"
+			     "Package-" + to_string((i * 7919) % 500000) + ".mo", 0);
+
+    steady_clock::time_point t0 = steady_clock::now();
+
+    vector<File> tmp = entries;
+    sort(tmp.begin(), tmp.end(), [](const File& lhs, const File& rhs) {
+	return cmp_lt(lhs.getName(), rhs.getName());
+    });
+
+    steady_clock::time_point t1 = steady_clock::now();
+
+    Files files(nullptr, entries);
+
+    steady_clock::time_point t2 = steady_clock::now();
+
+    cout << entries.size() << " names, locale " << std::locale().name() << endl;
+
+    cout << "former " << duration_cast<milliseconds>(t1 - t0).count() << " ms, "
+	 << "collation keys " << duration_cast<milliseconds>(t2 - t1).count() << " ms" << endl;
+
+    if (!equal(tmp.begin(), tmp.end(), files.begin(), [](const File& lhs, const File& rhs) {
+	return lhs.getName() == rhs.getName();
+    }))
+	cerr << "orders differ" << endl;
+}
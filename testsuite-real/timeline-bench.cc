@@ -0,0 +1,123 @@
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <functional>
+#include <algorithm>
+
+#include "../utils/equal-date.h"
+#include "../utils/Timeline.h"
+
+using namespace std;
+using namespace std::chrono;
+using namespace snapper;
+
+
+// Compares the timeline cleanup candidate selection of 100000 hourly
+// snapshots with the former implementation calling localtime_r for every
+// comparison. The cleanup with a condition used to recalculate the
+// candidates after every removal; that is timed for the first 100
+// removals.
+
+
+bool
+is_first(const vector<time_t>& dates, size_t i,
+	 std::function<bool(const struct tm& tmp1, const struct tm& tmp2)> pred)
+{
+    struct tm tmp1;
+    localtime_r(&dates[i], &tmp1);
+
+    for (size_t j = i + 1; j < dates.size(); ++j)
+    {
+	struct tm tmp2;
+	localtime_r(&dates[j], &tmp2);
+
+	if (!pred(tmp1, tmp2))
+	    return true;
+
+	if (dates[i] > dates[j])
+	    return false;
+    }
+
+    return true;
+}
+
+
+vector<bool>
+former_keep(const vector<time_t>& dates, const TimelineLimits& limits)
+{
+    vector<bool> ret(dates.size(), false);
+
+    size_t num_hourly = 0, num_daily = 0, num_weekly = 0, num_monthly = 0, num_yearly = 0;
+
+    for (size_t i = 0; i < dates.size(); ++i)
+    {
+	if (num_hourly < limits.hourly && is_first(dates, i, equal_hour))
+	    ++num_hourly, ret[i] = true;
+	if (num_daily < limits.daily && is_first(dates, i, equal_day))
+	    ++num_daily, ret[i] = true;
+	if (num_weekly < limits.weekly && is_first(dates, i, equal_week))
+	    ++num_weekly, ret[i] = true;
+	if (num_monthly < limits.monthly && is_first(dates, i, equal_month))
+	    ++num_monthly, ret[i] = true;
+	if (num_yearly < limits.yearly && is_first(dates, i, equal_year))
+	    ++num_yearly, ret[i] = true;
+    }
+
+    return ret;
+}
+
+
+// Removes the oldest candidate.
+
+void
+remove_oldest(vector<time_t>& dates, const vector<bool>& keep)
+{
+    for (size_t i = dates.size(); i-- > 0;)
+    {
+	if (!keep[i])
+	{
+	    dates.erase(dates.begin() + i);
+	    return;
+	}
+    }
+}
+
+
+int
+main()
+{
+    const TimelineLimits limits = { 10, 10, 0, 10, 10 };
+
+    vector<time_t> dates;
+    for (unsigned int i = 0; i < 100000; ++i)
+	dates.push_back(1700000000 - i * 3600);
+
+    steady_clock::time_point t0 = steady_clock::now();
+
+    vector<bool> keep1 = former_keep(dates, limits);
+
+    steady_clock::time_point t1 = steady_clock::now();
+
+    vector<bool> keep2 = timeline_keep(dates, limits);
+
+    steady_clock::time_point t2 = steady_clock::now();
+
+    vector<time_t> tmp = dates;
+    for (unsigned int i = 0; i < 100; ++i)
+	remove_oldest(tmp, former_keep(tmp, limits));
+
+    steady_clock::time_point t3 = steady_clock::now();
+
+    cout << dates.size() << " snapshots, "
+	 << count(keep2.begin(), keep2.end(), false) << " candidates" << endl;
+
+    cout << "former candidates " << duration_cast<milliseconds>(t1 - t0).count() << " ms, "
+	 << "bucketed candidates " << duration_cast<milliseconds>(t2 - t1).count() << " ms" << endl;
+
+    cout << "former removal order " << duration_cast<milliseconds>(t3 - t2).count() << " ms "
+	 << "for 100 removals, bucketed removal order calculated once" << endl;
+
+    if (keep1 != keep2)
+	cerr << "results differ" << endl;
+}
@@ -0,0 +1,151 @@
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/xattr.h>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include <snapper/FileUtils.h>
+#include <snapper/File.h>
+#include <snapper/XAttributes.h>
+#include <snapper/Compare.h>
+
+using namespace std;
+using namespace std::chrono;
+using namespace snapper;
+
+
+// Compares the extended attributes of 10000 files with four attributes
+// each in two identical trees: with the former implementation building
+// the XAttributes objects, with cmpFilesXattrs() comparing flat buffers
+// and with cmpFiles(). The files of the two trees are distinct, so
+// cmpFiles() cannot skip the comparison due to an unchanged ctime. The
+// trees are created in the current directory, so run it on a filesystem
+// supporting user extended attributes.
+
+
+const unsigned int files = 10000;
+
+
+unsigned int
+former_cmp_files_xattrs(const SFile& file1, const SFile& file2)
+{
+    XAttributes xa(file1);
+    XAttributes xb(file2);
+
+    if (xa == xb)
+	return 0;
+
+    CompareAcls acl_a(xa);
+    CompareAcls acl_b(xb);
+
+    return (acl_a == acl_b) ? XATTRS : (XATTRS | ACL);
+}
+
+
+void
+create_tree(const SDir& dir, vector<SFile>& entries)
+{
+    for (unsigned int i = 0; i < files; ++i)
+    {
+	string name = "file-" + to_string(i);
+
+	int fd = dir.open(name, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0)
+	{
+	    cerr << "creating file failed" << endl;
+	    exit(EXIT_FAILURE);
+	}
+
+	for (unsigned int j = 0; j < 4; ++j)
+	{
+	    string key = "user.bench-" + to_string(j);
+	    string value = "value-" + to_string(i) + "-" + to_string(j);
+	    if (fsetxattr(fd, key.c_str(), value.c_str(), value.size(), 0) != 0)
+	    {
+		cerr << "setting extended attribute failed" << endl;
+		exit(EXIT_FAILURE);
+	    }
+	}
+
+	close(fd);
+
+	entries.emplace_back(dir, name);
+    }
+}
+
+
+void
+remove_tree(const SDir& dir)
+{
+    for (unsigned int i = 0; i < files; ++i)
+	dir.unlink("file-" + to_string(i), 0);
+}
+
+
+int
+main()
+{
+    char tmp[] = "xattrs-bench-XXXXXX";
+    if (!mkdtemp(tmp))
+    {
+	cerr << "mkdtemp failed" << endl;
+	exit(EXIT_FAILURE);
+    }
+
+    SDir dir(tmp);
+
+    if (dir.mkdir("1", 0755) != 0 || dir.mkdir("2", 0755) != 0)
+    {
+	cerr << "creating directories failed" << endl;
+	exit(EXIT_FAILURE);
+    }
+
+    SDir dir1(dir, "1");
+    SDir dir2(dir, "2");
+
+    vector<SFile> entries1;
+    vector<SFile> entries2;
+
+    create_tree(dir1, entries1);
+    create_tree(dir2, entries2);
+
+    unsigned int differ1 = 0, differ2 = 0, differ3 = 0;
+
+    steady_clock::time_point t0 = steady_clock::now();
+
+    for (unsigned int i = 0; i < files; ++i)
+	if (former_cmp_files_xattrs(entries1[i], entries2[i]) != 0)
+	    ++differ1;
+
+    steady_clock::time_point t1 = steady_clock::now();
+
+    for (unsigned int i = 0; i < files; ++i)
+	if (cmpFilesXattrs(entries1[i], entries2[i]) != 0)
+	    ++differ2;
+
+    steady_clock::time_point t2 = steady_clock::now();
+
+    for (unsigned int i = 0; i < files; ++i)
+	if (cmpFiles(entries1[i], entries2[i]) != 0)
+	    ++differ3;
+
+    steady_clock::time_point t3 = steady_clock::now();
+
+    remove_tree(dir1);
+    remove_tree(dir2);
+    dir.unlink("1", AT_REMOVEDIR);
+    dir.unlink("2", AT_REMOVEDIR);
+    rmdir(tmp);
+
+    cout << files << " files" << endl;
+
+    cout << "former " << duration_cast<milliseconds>(t1 - t0).count() << " ms, "
+	 << "flat " << duration_cast<milliseconds>(t2 - t1).count() << " ms, "
+	 << "cmpFiles " << duration_cast<milliseconds>(t3 - t2).count() << " ms" << endl;
+
+    if (differ1 != 0 || differ2 != 0 || differ3 != 0)
+	cerr << "files differ" << endl;
+}
@@ -0,0 +1,125 @@
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE ascii_file
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <snapper/AsciiFile.h>
+
+
+using namespace std;
+using namespace snapper;
+
+
+vector<string>
+make_lines()
+{
+    vector<string> lines = { "", "first", "", string(100000, 'x'), "last" };
+
+    for (unsigned int i = 0; i < 100000; ++i)
+	lines.push_back("+..... /usr/lib/some/file-" + to_string(i));
+
+    return lines;
+}
+
+
+string
+tmp_name(Compression compression)
+{
+    char tmp[] = "/tmp/snapper-ascii-file-XXXXXX";
+    int fd = mkstemp(tmp);
+    BOOST_REQUIRE(fd >= 0);
+    close(fd);
+    unlink(tmp);
+
+    return add_extension(compression, tmp);
+}
+
+
+void
+check_round_trip(Compression compression)
+{
+    if (!is_available(compression))
+	return;
+
+    const vector<string> lines = make_lines();
+
+    string name = tmp_name(compression);
+
+    AsciiFileWriter writer(name, compression);
+    for (const string& line : lines)
+	writer.write_line(line);
+    writer.close();
+
+    vector<string> result1;
+
+    AsciiFileReader reader1(name, compression);
+    string line;
+    while (reader1.read_line(line))
+	result1.push_back(line);
+    reader1.close();
+
+    BOOST_REQUIRE_EQUAL(result1.size(), lines.size());
+    BOOST_CHECK(result1 == lines);
+
+    // lines longer than the buffer span several refills
+
+    vector<string> result2;
+
+    AsciiFileReader reader2(name, compression);
+    const char* data;
+    size_t size;
+    while (reader2.read_line(data, size))
+	result2.emplace_back(data, size);
+    reader2.close();
+
+    BOOST_REQUIRE_EQUAL(result2.size(), lines.size());
+    BOOST_CHECK(result2 == lines);
+
+    unlink(name.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE(none)
+{
+    check_round_trip(Compression::NONE);
+}
+
+
+BOOST_AUTO_TEST_CASE(gzip)
+{
+    check_round_trip(Compression::GZIP);
+}
+
+
+BOOST_AUTO_TEST_CASE(zstd)
+{
+    check_round_trip(Compression::ZSTD);
+}
+
+
+BOOST_AUTO_TEST_CASE(zstd_truncated)
+{
+    if (!is_available(Compression::ZSTD))
+	return;
+
+    string name = tmp_name(Compression::ZSTD);
+
+    AsciiFileWriter writer(name, Compression::ZSTD);
+    for (const string& line : make_lines())
+	writer.write_line(line);
+    writer.close();
+
+    BOOST_REQUIRE(truncate(name.c_str(), 1000) == 0);
+
+    AsciiFileReader reader(name, Compression::ZSTD);
+
+    string line;
+    BOOST_CHECK_THROW({ while (reader.read_line(line)); }, IOErrorException);
+
+    unlink(name.c_str());
+}
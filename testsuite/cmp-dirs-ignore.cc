@@ -0,0 +1,123 @@
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE cmp_dirs_ignore
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <fnmatch.h>
+#include <map>
+#include <algorithm>
+
+#include <snapper/Compare.h>
+#include <snapper/IgnorePatterns.h>
+
+
+using namespace std;
+using namespace snapper;
+
+
+void
+write_file(const string& path, const string& content)
+{
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    BOOST_REQUIRE(fd >= 0);
+    BOOST_REQUIRE(write(fd, content.data(), content.size()) == (ssize_t) content.size());
+    close(fd);
+}
+
+
+BOOST_AUTO_TEST_CASE(prune)
+{
+    char tmp[] = "/tmp/snapper-cmp-dirs-XXXXXX";
+    BOOST_REQUIRE(mkdtemp(tmp));
+
+    const string path1 = string(tmp) + "/1";
+    const string path2 = string(tmp) + "/2";
+
+    for (const string& path : { path1, path2 })
+    {
+	mkdir(path.c_str(), 0755);
+	mkdir((path + "/var").c_str(), 0755);
+	mkdir((path + "/var/cache").c_str(), 0755);
+	mkdir((path + "/etc").c_str(), 0755);
+    }
+
+    // changes in ignored and not ignored places, including a directory
+    // only in one tree
+
+    write_file(path2 + "/var/cache/a", "a");
+    mkdir((path2 + "/var/cache/dir").c_str(), 0755);
+    write_file(path2 + "/var/cache/dir/b", "b");
+    write_file(path2 + "/var/log", "log");
+    write_file(path2 + "/etc/mtab", "mtab");
+    write_file(path2 + "/etc/passwd", "passwd");
+    mkdir((path2 + "/new").c_str(), 0755);
+    write_file(path2 + "/new/c.swp", "c");
+    write_file(path2 + "/new/d", "d");
+
+    const vector<string> patterns = { "/var/cache", "/etc/mtab", "*.swp" };
+
+    map<string, unsigned int> all;
+    cmpDirs(SDir(path1), SDir(path2), [&all](const string& name, unsigned int status) {
+	all[name] = status;
+    });
+
+    map<string, unsigned int> expected;
+    for (const map<string, unsigned int>::value_type& value : all)
+    {
+	if (none_of(patterns.begin(), patterns.end(), [&value](const string& pattern) {
+	    return fnmatch(pattern.c_str(), value.first.c_str(), FNM_LEADING_DIR) == 0;
+	}))
+	    expected.insert(value);
+    }
+
+    IgnorePatterns ignore_patterns(patterns);
+
+    map<string, unsigned int> pruned;
+    cmpDirs(SDir(path1), SDir(path2), [&pruned](const string& name, unsigned int status) {
+	pruned[name] = status;
+    }, &ignore_patterns);
+
+    BOOST_CHECK(pruned == expected);
+    BOOST_CHECK(pruned.count("/new/d"));
+    BOOST_CHECK(!pruned.count("/var/cache/dir/b"));
+
+    system((string("rm -rf ") + tmp).c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE(stop_early)
+{
+    // Comparison::areEmpty() stops comparing by throwing from the
+    // callback.
+
+    char tmp[] = "/tmp/snapper-cmp-dirs-XXXXXX";
+    BOOST_REQUIRE(mkdtemp(tmp));
+
+    const string path1 = string(tmp) + "/1";
+    const string path2 = string(tmp) + "/2";
+
+    mkdir(path1.c_str(), 0755);
+    mkdir(path2.c_str(), 0755);
+
+    for (const string& name : { "/a", "/b", "/c" })
+	write_file(path2 + name, "new");
+
+    struct Found {};
+
+    unsigned int calls = 0;
+
+    BOOST_CHECK_THROW(cmpDirs(SDir(path1), SDir(path2), [&calls](const string& name,
+								unsigned int status) {
+	++calls;
+	throw Found();
+    }), Found);
+
+    BOOST_CHECK_EQUAL(calls, 1);
+
+    system((string("rm -rf ") + tmp).c_str());
+}
@@ -74,3 +74,35 @@ BOOST_AUTO_TEST_CASE(test4)
 
     BOOST_CHECK_EQUAL(v, vector<string>({ "\344", "a" }));
 }
+
+
+BOOST_AUTO_TEST_CASE(test5)
+{
+    // Files::sort uses collation keys, the order must be the same as with cmp_lt
+
+    vector<string> names = { "/a", "/B", "/b", "/A", "/a/b", "/a b", "/a-b", "/ä", "/\344", "/Z",
+			     "/10", "/9", "/.x" };
+
+    for (const char* name : { "C", "en_US.UTF-8", "de_DE.UTF-8" })
+    {
+	std::locale::global(std::locale(name));
+
+	vector<string> v = names;
+	sort(v.begin(), v.end(), cmp_lt);
+
+	vector<File> entries;
+	for (const string& tmp : names)
+	    entries.emplace_back(nullptr, tmp, 0);
+
+	Files files(nullptr, entries);
+
+	vector<string> w;
+	for (const File& file : files)
+	    w.push_back(file.getName());
+
+	BOOST_CHECK_EQUAL(w, v);
+
+	for (const string& tmp : names)
+	    BOOST_CHECK(files.find(tmp) != files.end());
+    }
+}
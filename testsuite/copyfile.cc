@@ -0,0 +1,94 @@
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE copyfile
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <snapper/AppUtil.h>
+
+
+using namespace std;
+using namespace snapper;
+
+
+string
+read_all(int fd)
+{
+    string ret;
+
+    char buffer[4096];
+    ssize_t n;
+    for (off_t offset = 0; (n = pread(fd, buffer, sizeof(buffer), offset)) > 0; offset += n)
+	ret.append(buffer, n);
+
+    return ret;
+}
+
+
+void
+check_copyfile(const vector<pair<off_t, string>>& chunks, off_t size)
+{
+    char src_name[] = "/tmp/snapper-copyfile-XXXXXX";
+    int src_fd = mkstemp(src_name);
+    BOOST_REQUIRE(src_fd >= 0);
+    unlink(src_name);
+
+    char dest_name[] = "/tmp/snapper-copyfile-XXXXXX";
+    int dest_fd = mkstemp(dest_name);
+    BOOST_REQUIRE(dest_fd >= 0);
+    unlink(dest_name);
+
+    for (const pair<off_t, string>& chunk : chunks)
+	BOOST_REQUIRE(pwrite(src_fd, chunk.second.data(), chunk.second.size(), chunk.first) ==
+		      (ssize_t) chunk.second.size());
+
+    BOOST_REQUIRE(ftruncate(src_fd, size) == 0);
+
+    BOOST_CHECK(copyfile(src_fd, dest_fd));
+
+    struct stat src_st, dest_st;
+    BOOST_REQUIRE(fstat(src_fd, &src_st) == 0);
+    BOOST_REQUIRE(fstat(dest_fd, &dest_st) == 0);
+
+    BOOST_CHECK_EQUAL(dest_st.st_size, src_st.st_size);
+    BOOST_CHECK(read_all(dest_fd) == read_all(src_fd));
+
+    // holes are preserved, allow some slack for filesystems with
+    // different allocation granularity
+
+    BOOST_CHECK_LE(dest_st.st_blocks, src_st.st_blocks + 64);
+
+    close(dest_fd);
+    close(src_fd);
+}
+
+
+BOOST_AUTO_TEST_CASE(empty)
+{
+    check_copyfile({}, 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(dense)
+{
+    check_copyfile({ { 0, string(100000, 'a') } }, 100000);
+}
+
+
+BOOST_AUTO_TEST_CASE(sparse)
+{
+    // leading, inner and trailing holes
+
+    check_copyfile({ { 1 << 20, string(5000, 'b') }, { 8 << 20, string(4096, 'c') } }, 16 << 20);
+}
+
+
+BOOST_AUTO_TEST_CASE(only_hole)
+{
+    check_copyfile({}, 16 << 20);
+}
@@ -4,7 +4,7 @@
 
 #include <boost/test/unit_test.hpp>
 
-#include "../client/utils/CsvFormatter.h"
+#include "../utils/CsvFormatter.h"
 
 
 using namespace std;
@@ -13,6 +13,9 @@ using namespace DBus;
 
 BOOST_AUTO_TEST_CASE(hoho_escape)
 {
+    BOOST_CHECK_EQUAL(Hoho::escape(""), "");
+    BOOST_CHECK_EQUAL(Hoho::escape("/usr/lib"), "/usr/lib");
+
     BOOST_CHECK_EQUAL(Hoho::escape("\\"), "\\\\");
 
     BOOST_CHECK_EQUAL(Hoho::escape("ä"), "\\xc3\\xa4");
@@ -24,12 +27,16 @@ BOOST_AUTO_TEST_CASE(hoho_escape)
 
 BOOST_AUTO_TEST_CASE(hihi_unescape)
 {
+    BOOST_CHECK_EQUAL(Hihi::unescape(""), "");
+    BOOST_CHECK_EQUAL(Hihi::unescape("/usr/lib"), "/usr/lib");
+
     BOOST_CHECK_EQUAL(Hihi::unescape("\\\\"), "\\");
 
     BOOST_CHECK_EQUAL(Hihi::unescape("\\xc3\\xa4"), "ä");
     BOOST_CHECK_EQUAL(Hihi::unescape("0\\xc3\\xa40"), "0ä0");
 
     BOOST_CHECK_EQUAL(Hihi::unescape("\\xff"), "\xff");
+    BOOST_CHECK_EQUAL(Hihi::unescape("\\xC3\\xA4"), "ä");
 
     BOOST_CHECK_THROW(Hihi::unescape("\\"), MarshallingException);
     BOOST_CHECK_THROW(Hihi::unescape("\\x"), MarshallingException);
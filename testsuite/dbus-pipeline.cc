@@ -0,0 +1,253 @@
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE dbus_pipeline
+
+#include <boost/test/unit_test.hpp>
+
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+
+#include <dbus/DBusConnection.h>
+#include <client/commands.h>
+
+
+using namespace std;
+
+
+/**
+ * Runs a private dbus-daemon for the duration of the test.
+ */
+class PrivateBus
+{
+public:
+
+    PrivateBus()
+    {
+	int fds[2];
+	if (pipe(fds) != 0)
+	    return;
+
+	pid = fork();
+	if (pid == 0)
+	{
+	    close(fds[0]);
+	    string print_address = "--print-address=" + to_string(fds[1]);
+	    execlp("dbus-daemon", "dbus-daemon", "--session", "--nofork", print_address.c_str(),
+		   nullptr);
+	    _exit(127);
+	}
+
+	close(fds[1]);
+
+	FILE* fin = fdopen(fds[0], "r");
+
+	char* buffer = nullptr;
+	size_t len = 0;
+
+	ssize_t n = getline(&buffer, &len, fin);
+	if (n > 0)
+	    address = string(buffer, buffer[n - 1] == '\n' ? n - 1 : n);
+
+	free(buffer);
+	fclose(fin);
+    }
+
+    ~PrivateBus()
+    {
+	if (pid > 0)
+	{
+	    kill(pid, SIGTERM);
+	    waitpid(pid, nullptr, 0);
+	}
+    }
+
+    string address;
+
+private:
+
+    pid_t pid = -1;
+
+};
+
+
+/**
+ * The tests need the dbus-daemon binary, otherwise they are skipped.
+ */
+struct HaveDbusDaemon
+{
+    boost::test_tools::assertion_result operator()(boost::unit_test::test_unit_id) const
+    {
+	return system("dbus-daemon --version > /dev/null 2>&1") == 0;
+    }
+};
+
+
+/**
+ * Minimal snapperd only knowing GetUsedSpace. Method calls are collected
+ * until batch_size calls are pending and then answered in reverse order.
+ * Thus the calls are only answered if the client sends them without
+ * waiting for the replies. The used space of snapshot n is n * 1000,
+ * snapshot 13 does not exist.
+ */
+class MockSnapperd : public DBus::Connection
+{
+public:
+
+    MockSnapperd(const string& address, size_t batch_size)
+	: DBus::Connection(address), batch_size(batch_size)
+    {
+	request_name("org.opensuse.Snapper", DBUS_NAME_FLAG_REPLACE_EXISTING);
+	thread = boost::thread(boost::bind(&MockSnapperd::worker, this));
+    }
+
+    ~MockSnapperd()
+    {
+	stop = true;
+	thread.join();
+    }
+
+private:
+
+    void worker()
+    {
+	vector<DBus::Message> batch;
+
+	while (!stop)
+	{
+	    DBusMessage* tmp = pop_message();
+	    if (!tmp)
+	    {
+		boost::lock_guard<boost::mutex> lock(mutex);
+		dbus_connection_read_write(conn, 50);
+		continue;
+	    }
+
+	    DBus::Message msg(tmp, false);
+	    if (msg.is_method_call("org.opensuse.Snapper", "GetUsedSpace"))
+		batch.push_back(msg);
+
+	    if (batch.size() < batch_size)
+		continue;
+
+	    for (vector<DBus::Message>::reverse_iterator it = batch.rbegin(); it != batch.rend(); ++it)
+		reply(*it);
+
+	    batch.clear();
+	}
+    }
+
+    void reply(DBus::Message& msg)
+    {
+	string config_name;
+	unsigned int num;
+
+	DBus::Hihi hihi(msg);
+	hihi >> config_name >> num;
+
+	if (num == 13)
+	{
+	    DBus::MessageError reply(msg, "error.illegal_snapshot", DBUS_ERROR_FAILED);
+	    send(reply);
+	    return;
+	}
+
+	DBus::MessageMethodReturn reply(msg);
+
+	DBus::Hoho hoho(reply);
+	hoho << (uint64_t)(num * 1000);
+
+	send(reply);
+    }
+
+    const size_t batch_size;
+
+    std::atomic<bool> stop { false };
+
+    boost::thread thread;
+
+};
+
+
+DBus::Message
+get_used_space_call(unsigned int num)
+{
+    DBus::MessageMethodCall call("org.opensuse.Snapper", "/org/opensuse/Snapper",
+				 "org.opensuse.Snapper", "GetUsedSpace");
+
+    DBus::Hoho hoho(call);
+    hoho << "root" << num;
+
+    return call;
+}
+
+
+uint64_t
+used_space(DBus::Message reply)
+{
+    uint64_t used_space;
+
+    DBus::Hihi hihi(reply);
+    hihi >> used_space;
+
+    return used_space;
+}
+
+
+BOOST_AUTO_TEST_CASE(out_of_order, * boost::unit_test::precondition(HaveDbusDaemon()))
+{
+    PrivateBus private_bus;
+    BOOST_REQUIRE(!private_bus.address.empty());
+
+    MockSnapperd mock_snapperd(private_bus.address, 4);
+
+    DBus::Connection conn(private_bus.address);
+
+    vector<DBus::PendingCall> pending_calls;
+    for (unsigned int num : { 1, 2, 3, 13 })
+    {
+	DBus::Message call = get_used_space_call(num);
+	pending_calls.push_back(conn.send_with_reply(call));
+    }
+
+    BOOST_CHECK_EQUAL(used_space(pending_calls[2].get_reply()), 3000);
+    BOOST_CHECK_EQUAL(used_space(pending_calls[0].get_reply()), 1000);
+    BOOST_CHECK_EQUAL(used_space(pending_calls[1].get_reply()), 2000);
+
+    try
+    {
+	pending_calls[3].get_reply();
+	BOOST_FAIL("no exception thrown");
+    }
+    catch (const DBus::ErrorException& e)
+    {
+	BOOST_CHECK_EQUAL(e.name(), "error.illegal_snapshot");
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(used_spaces, * boost::unit_test::precondition(HaveDbusDaemon()))
+{
+    PrivateBus private_bus;
+    BOOST_REQUIRE(!private_bus.address.empty());
+
+    // 200 calls are sent in chunks of 64, so every chunk is a multiple of 8.
+
+    MockSnapperd mock_snapperd(private_bus.address, 8);
+
+    DBus::Connection conn(private_bus.address);
+
+    vector<unsigned int> nums;
+    for (unsigned int num = 100; num < 300; ++num)
+	nums.push_back(num);
+
+    vector<uint64_t> used_spaces = command_get_used_spaces(conn, "root", nums);
+
+    BOOST_REQUIRE_EQUAL(used_spaces.size(), nums.size());
+    for (size_t i = 0; i < nums.size(); ++i)
+	BOOST_CHECK_EQUAL(used_spaces[i], nums[i] * 1000);
+}
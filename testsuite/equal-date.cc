@@ -4,7 +4,7 @@
 
 #include <boost/test/unit_test.hpp>
 
-#include "../client/utils/equal-date.h"
+#include "../utils/equal-date.h"
 #include "../snapper/AppUtil.h"
 
 using namespace snapper;
@@ -75,3 +75,39 @@ BOOST_AUTO_TEST_CASE(test5)
     BOOST_CHECK(!equal_week("2017-12-31 00:00:00", "2018-01-01 00:00:00"));
     BOOST_CHECK(!equal_week("2018-01-01 00:00:00", "2017-12-31 00:00:00"));
 }
+
+
+BOOST_AUTO_TEST_CASE(keys)
+{
+    // the keys must agree with the equal_* functions, also around the turn
+    // of centuries
+
+    vector<time_t> times;
+    for (const char* s : { "1999-12-20 00:00:00", "2000-12-20 00:00:00", "2011-12-20 00:00:00",
+		"2100-12-20 00:00:00" })
+    {
+	time_t t = scan_datetime(s, true);
+	for (unsigned int i = 0; i < 30 * 24; i += 5)
+	    times.push_back(t + i * 3600);
+    }
+
+    for (time_t t1 : times)
+    {
+	struct tm tmp1;
+	gmtime_r(&t1, &tmp1);
+	DateKeys keys1(tmp1);
+
+	for (time_t t2 : times)
+	{
+	    struct tm tmp2;
+	    gmtime_r(&t2, &tmp2);
+	    DateKeys keys2(tmp2);
+
+	    BOOST_CHECK_EQUAL(keys1.year == keys2.year, equal_year(tmp1, tmp2));
+	    BOOST_CHECK_EQUAL(keys1.month == keys2.month, equal_month(tmp1, tmp2));
+	    BOOST_CHECK_EQUAL(keys1.week == keys2.week, equal_week(tmp1, tmp2));
+	    BOOST_CHECK_EQUAL(keys1.day == keys2.day, equal_day(tmp1, tmp2));
+	    BOOST_CHECK_EQUAL(keys1.hour == keys2.hour, equal_hour(tmp1, tmp2));
+	}
+    }
+}
@@ -4,7 +4,7 @@
 
 #include <boost/test/unit_test.hpp>
 
-#include "../client/utils/GetOpts.h"
+#include "../utils/GetOpts.h"
 
 using namespace snapper;
 
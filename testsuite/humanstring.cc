@@ -7,7 +7,7 @@
 #include <locale>
 
 #include <snapper/Exception.h>
-#include "../client/utils/HumanString.h"
+#include "../utils/HumanString.h"
 
 
 using namespace std;
@@ -0,0 +1,73 @@
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE ignore_patterns
+
+#include <boost/test/unit_test.hpp>
+
+#include <fnmatch.h>
+
+#include <snapper/IgnorePatterns.h>
+
+
+using namespace std;
+using namespace snapper;
+
+
+bool
+reference(const vector<string>& patterns, const string& name)
+{
+    for (const string& pattern : patterns)
+	if (fnmatch(pattern.c_str(), name.c_str(), FNM_LEADING_DIR) == 0)
+	    return true;
+
+    return false;
+}
+
+
+const vector<string> patterns = {
+    "/etc/adjtime", "/etc/mtab", "/var/lib/misc/random-seed", "/etc/lvm/archive/*",
+    "/etc/lvm/backup/*", "/var/log/*.log", "/home/*/.cache", "/tmp?", "/dev/[a-c]d*",
+    "*.swp", "/etc/foo\\*bar", "/srv/"
+};
+
+
+const vector<string> names = {
+    "/", "/etc", "/etc/adjtime", "/etc/adjtime/x", "/etc/adjtimex", "/etc/mtab", "/etc/mta",
+    "/var/lib/misc/random-seed", "/var/lib/misc", "/etc/lvm/archive", "/etc/lvm/archive/",
+    "/etc/lvm/archive/vg0", "/etc/lvm/archive/vg0/x", "/etc/lvm/backup/vg0", "/var/log/messages",
+    "/var/log/zypper.log", "/var/log/old/zypper.log", "/home/user/.cache", "/home/user/.cache/x",
+    "/home/user/.cachex", "/home/.cache", "/tmp1", "/tmp", "/tmp12", "/dev/sda", "/dev/bd0",
+    "/dev/hda", "/root/.x.swp", "/root/.x.swp/y", "/etc/foo*bar", "/etc/fooxbar", "/srv",
+    "/srv/", "/srv/www"
+};
+
+
+BOOST_AUTO_TEST_CASE(same_as_fnmatch)
+{
+    IgnorePatterns ignore_patterns(patterns);
+
+    for (const string& name : names)
+	BOOST_CHECK_MESSAGE(ignore_patterns.match(name) == reference(patterns, name), name);
+}
+
+
+BOOST_AUTO_TEST_CASE(single_patterns)
+{
+    for (const string& pattern : patterns)
+    {
+	IgnorePatterns ignore_patterns({ pattern });
+
+	for (const string& name : names)
+	    BOOST_CHECK_MESSAGE(ignore_patterns.match(name) == reference({ pattern }, name),
+				pattern << " " << name);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(empty)
+{
+    IgnorePatterns ignore_patterns({});
+
+    BOOST_CHECK(ignore_patterns.empty());
+    BOOST_CHECK(!ignore_patterns.match("/etc/mtab"));
+}
@@ -5,7 +5,7 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/algorithm/string.hpp>
 
-#include "../client/utils/JsonFormatter.h"
+#include "../utils/JsonFormatter.h"
 
 
 using namespace std;
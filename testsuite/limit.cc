@@ -7,8 +7,8 @@
 #include <locale>
 
 #include <snapper/Exception.h>
-#include "../client/utils/Limit.h"
-#include "../client/utils/HumanString.h"
+#include "../utils/Limit.h"
+#include "../utils/HumanString.h"
 
 
 using namespace std;
@@ -0,0 +1,53 @@
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE log_level
+
+#include <boost/test/unit_test.hpp>
+
+#include <snapper/Log.h>
+
+
+using namespace snapper;
+
+
+int queries = 0;
+LogLevel min_level = MILESTONE;
+
+
+bool
+log_query(LogLevel level, const string& component)
+{
+    ++queries;
+    return level >= min_level;
+}
+
+
+BOOST_AUTO_TEST_CASE(cached)
+{
+    setLogQuery(&log_query);
+
+    BOOST_CHECK(!testLogLevel(DEBUG));
+    BOOST_CHECK(testLogLevel(MILESTONE));
+    BOOST_CHECK(testLogLevel(ERROR));
+
+    int tmp = queries;
+
+    for (int i = 0; i < 100; ++i)
+	y2deb("not logged " << i);
+
+    BOOST_CHECK_EQUAL(queries, tmp);
+}
+
+
+BOOST_AUTO_TEST_CASE(reset)
+{
+    setLogQuery(&log_query);
+
+    BOOST_CHECK(!testLogLevel(DEBUG));
+
+    min_level = DEBUG;
+    BOOST_CHECK(!testLogLevel(DEBUG));
+
+    resetLogQueryCache();
+    BOOST_CHECK(testLogLevel(DEBUG));
+}
@@ -0,0 +1,96 @@
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE mounts
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fstream>
+
+#include "../client/mounts.h"
+
+using namespace std;
+
+
+vector<pair<string, string>>
+read_mounts_from_text(const string& text)
+{
+    char name[] = "/tmp/snapper-mountinfo-XXXXXX";
+    int fd = mkstemp(name);
+    BOOST_REQUIRE(fd >= 0);
+    close(fd);
+
+    ofstream(name) << text;
+
+    vector<pair<string, string>> mounts = read_mounts(name);
+
+    unlink(name);
+
+    return mounts;
+}
+
+
+const string mountinfo =
+    "22 1 0:31 /@/.snapshots/1/snapshot / rw,relatime shared:1 - btrfs /dev/vda2 rw,subvol=/@/.snapshots/1/snapshot\n"
+    "45 22 0:31 /@/home /home rw,relatime shared:25 - btrfs /dev/vda2 rw,subvol=/@/home\n"
+    "46 22 0:31 /@/var /var rw,relatime shared:26 master:3 - btrfs /dev/vda2 rw,subvol=/@/var\n"
+    "47 22 253:3 / /data rw,relatime - ext4 /dev/vda3 rw\n"
+    "48 47 0:40 / /data/pool rw,relatime shared:30 - btrfs /dev/vdb rw,subvol=/\n"
+    "49 22 0:41 / /dev/shm rw - tmpfs tmpfs rw\n"
+    "broken line\n"
+    "50 22 0:42 / /no-separator rw shared:31 btrfs /dev/vdc rw\n";
+
+
+BOOST_AUTO_TEST_CASE(parse)
+{
+    vector<pair<string, string>> mounts = read_mounts_from_text(mountinfo);
+
+    BOOST_REQUIRE_EQUAL(mounts.size(), 6U);
+
+    BOOST_CHECK_EQUAL(mounts[0].first, "/");
+    BOOST_CHECK_EQUAL(mounts[0].second, "btrfs /dev/vda2");
+
+    // several optional fields
+    BOOST_CHECK_EQUAL(mounts[2].first, "/var");
+    BOOST_CHECK_EQUAL(mounts[2].second, "btrfs /dev/vda2");
+
+    // no optional fields
+    BOOST_CHECK_EQUAL(mounts[3].first, "/data");
+    BOOST_CHECK_EQUAL(mounts[3].second, "ext4 /dev/vda3");
+}
+
+
+BOOST_AUTO_TEST_CASE(missing)
+{
+    BOOST_CHECK(read_mounts("/tmp/snapper-does-not-exist/mountinfo").empty());
+}
+
+
+BOOST_AUTO_TEST_CASE(grouping)
+{
+    vector<pair<string, string>> mounts = read_mounts_from_text(mountinfo);
+
+    // all subvolumes of a btrfs are in one group
+
+    BOOST_CHECK_EQUAL(filesystem_id(mounts, "/"), "btrfs /dev/vda2");
+    BOOST_CHECK_EQUAL(filesystem_id(mounts, "/home"), "btrfs /dev/vda2");
+    BOOST_CHECK_EQUAL(filesystem_id(mounts, "/var/lib/machines"), "btrfs /dev/vda2");
+
+    // the longest mount point wins, also when nested below another
+    // filesystem
+
+    BOOST_CHECK_EQUAL(filesystem_id(mounts, "/data"), "ext4 /dev/vda3");
+    BOOST_CHECK_EQUAL(filesystem_id(mounts, "/data/pool"), "btrfs /dev/vdb");
+    BOOST_CHECK_EQUAL(filesystem_id(mounts, "/data/pool/vm"), "btrfs /dev/vdb");
+
+    // only complete path components match
+
+    BOOST_CHECK_EQUAL(filesystem_id(mounts, "/database"), "btrfs /dev/vda2");
+    BOOST_CHECK_EQUAL(filesystem_id(mounts, "/data/poolside"), "ext4 /dev/vda3");
+
+    // without mounts the configs are not grouped
+
+    BOOST_CHECK_EQUAL(filesystem_id({}, "/home"), "/home");
+    BOOST_CHECK_EQUAL(filesystem_id({}, "/"), "/");
+}
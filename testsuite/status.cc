@@ -0,0 +1,232 @@
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE status
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/resource.h>
+
+#include <snapper/File.h>
+#include <snapper/Compare.h>
+#include <snapper/Exception.h>
+
+
+using namespace std;
+using namespace snapper;
+
+
+void
+write_file(const string& path, const string& content)
+{
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    BOOST_REQUIRE(fd >= 0);
+    BOOST_REQUIRE(write(fd, content.data(), content.size()) == (ssize_t) content.size());
+    close(fd);
+
+    // files in pre are old, so that the content is compared
+
+    if (path.find("/pre/") != string::npos)
+    {
+	struct timespec times[2] = { { 0, 0 }, { 0, 0 } };
+	BOOST_REQUIRE(utimensat(AT_FDCWD, path.c_str(), times, AT_SYMLINK_NOFOLLOW) == 0);
+    }
+}
+
+
+struct Trees
+{
+    Trees()
+    {
+	BOOST_REQUIRE(mkdtemp(tmp));
+
+	file_paths.pre_path = string(tmp) + "/pre";
+	file_paths.system_path = string(tmp) + "/system";
+
+	for (const string& path : { file_paths.pre_path, file_paths.system_path })
+	{
+	    mkdir(path.c_str(), 0755);
+	    mkdir((path + "/a").c_str(), 0755);
+	    write_file(path + "/a/same", "same");
+	    write_file(path + "/top", "top");
+	}
+
+	write_file(file_paths.pre_path + "/a/changed", "old");
+	write_file(file_paths.system_path + "/a/changed", "newer");
+
+	// /b only in pre, /c only in system
+
+	mkdir((file_paths.pre_path + "/b").c_str(), 0755);
+	write_file(file_paths.pre_path + "/b/file", "b");
+
+	mkdir((file_paths.system_path + "/c").c_str(), 0755);
+	write_file(file_paths.system_path + "/c/file", "c");
+
+	for (const string& name : { "/a", "/a/changed", "/a/same", "/b", "/b/file", "/c",
+		    "/c/file", "/top" })
+	    entries.emplace_back(&file_paths, name, 0);
+    }
+
+    ~Trees()
+    {
+	system((string("rm -rf ") + tmp).c_str());
+    }
+
+    char tmp[32] = "/tmp/snapper-status-XXXXXX";
+
+    FilePaths file_paths;
+
+    vector<File> entries;
+};
+
+
+void
+check_statuses(Files& files)
+{
+    BOOST_CHECK_EQUAL(files.find("/a/same")->getStatus(CMP_PRE_TO_SYSTEM), 0);
+    BOOST_CHECK_EQUAL(files.find("/a/changed")->getStatus(CMP_PRE_TO_SYSTEM), CONTENT);
+    BOOST_CHECK_EQUAL(files.find("/b")->getStatus(CMP_PRE_TO_SYSTEM), DELETED);
+    BOOST_CHECK_EQUAL(files.find("/b/file")->getStatus(CMP_PRE_TO_SYSTEM), DELETED);
+    BOOST_CHECK_EQUAL(files.find("/c")->getStatus(CMP_PRE_TO_SYSTEM), CREATED);
+    BOOST_CHECK_EQUAL(files.find("/c/file")->getStatus(CMP_PRE_TO_SYSTEM), CREATED);
+    BOOST_CHECK_EQUAL(files.find("/top")->getStatus(CMP_PRE_TO_SYSTEM), 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(single)
+{
+    Trees trees;
+
+    Files files(&trees.file_paths, trees.entries);
+
+    check_statuses(files);
+}
+
+
+BOOST_AUTO_TEST_CASE(bulk)
+{
+    Trees trees;
+
+    for (unsigned int jobs : { 1, 4 })
+    {
+	Files files(&trees.file_paths, trees.entries);
+
+	files.calculateStatus(CMP_PRE_TO_SYSTEM, jobs);
+
+	// the statuses are cached, so changes are not seen anymore
+
+	write_file(trees.file_paths.system_path + "/a/same", "changed content");
+
+	check_statuses(files);
+
+	write_file(trees.file_paths.system_path + "/a/same", "same");
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(filtered)
+{
+    Trees trees;
+
+    Files files(&trees.file_paths, trees.entries);
+
+    files.calculateStatus(CMP_PRE_TO_SYSTEM, 2, [](const File& file) {
+	return file.getName() == "/top";
+    });
+
+    write_file(trees.file_paths.system_path + "/top", "changed content");
+    write_file(trees.file_paths.system_path + "/a/same", "changed content");
+
+    BOOST_CHECK_EQUAL(files.find("/top")->getStatus(CMP_PRE_TO_SYSTEM), 0);
+    BOOST_CHECK_EQUAL(files.find("/a/same")->getStatus(CMP_PRE_TO_SYSTEM), CONTENT);
+}
+
+
+/*
+ * Limits the number of open file descriptors to the currently open ones
+ * plus extra.
+ */
+struct LimitFds
+{
+    LimitFds(unsigned int extra)
+    {
+	BOOST_REQUIRE(getrlimit(RLIMIT_NOFILE, &old_limit) == 0);
+
+	rlim_t used = 0;
+
+	DIR* dir = opendir("/proc/self/fd");
+	BOOST_REQUIRE(dir);
+	while (readdir(dir))
+	    ++used;
+	closedir(dir);
+
+	// . and .. and the fd of dir itself
+
+	struct rlimit limit = old_limit;
+	limit.rlim_cur = used - 3 + extra;
+	BOOST_REQUIRE(setrlimit(RLIMIT_NOFILE, &limit) == 0);
+    }
+
+    ~LimitFds()
+    {
+	setrlimit(RLIMIT_NOFILE, &old_limit);
+    }
+
+    struct rlimit old_limit;
+};
+
+
+BOOST_AUTO_TEST_CASE(many_directories)
+{
+    Trees trees;
+
+    vector<File> entries = trees.entries;
+
+    for (unsigned int i = 0; i < 200; ++i)
+    {
+	string name = "/many-" + to_string(i);
+
+	for (const string& path : { trees.file_paths.pre_path, trees.file_paths.system_path })
+	{
+	    mkdir((path + name).c_str(), 0755);
+	    write_file(path + name + "/file", "file");
+	}
+
+	entries.emplace_back(&trees.file_paths, name, 0);
+	entries.emplace_back(&trees.file_paths, name + "/file", 0);
+    }
+
+    Files files(&trees.file_paths, entries);
+
+    {
+	// far less file descriptors than directories
+
+	LimitFds limit_fds(16);
+
+	files.calculateStatus(CMP_PRE_TO_SYSTEM, 1);
+    }
+
+    check_statuses(files);
+
+    for (unsigned int i = 0; i < 200; ++i)
+	BOOST_CHECK_EQUAL(files.find("/many-" + to_string(i) + "/file")->getStatus(CMP_PRE_TO_SYSTEM), 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(open_failure)
+{
+    Trees trees;
+
+    Files files(&trees.file_paths, trees.entries);
+
+    // only the base directories and /a in pre can be opened, failing to
+    // open /a in system must not report /a/same as deleted
+
+    LimitFds limit_fds(3);
+
+    BOOST_CHECK_THROW(files.find("/a/same")->getStatus(CMP_PRE_TO_SYSTEM), IOErrorException);
+}
@@ -4,7 +4,7 @@
 
 #include <boost/test/unit_test.hpp>
 
-#include "../client/utils/TableFormatter.h"
+#include "../utils/TableFormatter.h"
 
 
 using namespace std;
@@ -8,7 +8,7 @@
 #include <numeric>
 #include <iomanip>
 
-#include "../client/utils/Table.h"
+#include "../utils/Table.h"
 
 
 using namespace std;
@@ -0,0 +1,113 @@
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE timeline
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdlib.h>
+#include <functional>
+
+#include "../utils/equal-date.h"
+#include "../utils/Timeline.h"
+
+using namespace std;
+using namespace snapper;
+
+
+// The former implementation comparing every snapshot with the following
+// ones using localtime_r.
+
+bool
+is_first(const vector<time_t>& dates, size_t i,
+	 std::function<bool(const struct tm& tmp1, const struct tm& tmp2)> pred)
+{
+    struct tm tmp1;
+    localtime_r(&dates[i], &tmp1);
+
+    for (size_t j = i + 1; j < dates.size(); ++j)
+    {
+	struct tm tmp2;
+	localtime_r(&dates[j], &tmp2);
+
+	if (!pred(tmp1, tmp2))
+	    return true;
+
+	if (dates[i] > dates[j])
+	    return false;
+    }
+
+    return true;
+}
+
+
+vector<bool>
+reference_keep(const vector<time_t>& dates, const TimelineLimits& limits)
+{
+    vector<bool> ret(dates.size(), false);
+
+    size_t num_hourly = 0, num_daily = 0, num_weekly = 0, num_monthly = 0, num_yearly = 0;
+
+    for (size_t i = 0; i < dates.size(); ++i)
+    {
+	if (num_hourly < limits.hourly && is_first(dates, i, equal_hour))
+	    ++num_hourly, ret[i] = true;
+	if (num_daily < limits.daily && is_first(dates, i, equal_day))
+	    ++num_daily, ret[i] = true;
+	if (num_weekly < limits.weekly && is_first(dates, i, equal_week))
+	    ++num_weekly, ret[i] = true;
+	if (num_monthly < limits.monthly && is_first(dates, i, equal_month))
+	    ++num_monthly, ret[i] = true;
+	if (num_yearly < limits.yearly && is_first(dates, i, equal_year))
+	    ++num_yearly, ret[i] = true;
+    }
+
+    return ret;
+}
+
+
+void
+check_keep(const vector<time_t>& dates)
+{
+    for (const TimelineLimits& limits : { TimelineLimits { 10, 10, 0, 10, 10 },
+		TimelineLimits { 0, 5, 4, 3, 1 }, TimelineLimits { 1000, 1000, 1000, 1000, 1000 } })
+    {
+	BOOST_CHECK(timeline_keep(dates, limits) == reference_keep(dates, limits));
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(empty)
+{
+    check_keep({});
+}
+
+
+BOOST_AUTO_TEST_CASE(hourly)
+{
+    // two years of hourly snapshots, newest first, with some gaps
+
+    vector<time_t> dates;
+    for (time_t t = 1700000000 + 2 * 365 * 24 * 3600; t > 1700000000; t -= 3600)
+    {
+	if (t % 7 != 0)
+	    dates.push_back(t);
+    }
+
+    check_keep(dates);
+}
+
+
+BOOST_AUTO_TEST_CASE(unordered)
+{
+    // dates not ordered by number, e.g. due to clock changes, and equal dates
+
+    srand(42);
+
+    vector<time_t> dates;
+    for (unsigned int i = 0; i < 2000; ++i)
+	dates.push_back(1700000000 - i * 1800 + (rand() % 10) * 3000);
+
+    dates.push_back(dates.back());
+
+    check_keep(dates);
+}
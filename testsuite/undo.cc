@@ -0,0 +1,172 @@
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE undo
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <set>
+
+#include <snapper/File.h>
+#include <snapper/AppUtil.h>
+
+
+using namespace std;
+using namespace snapper;
+
+
+bool
+exists(const string& path)
+{
+    struct stat buf;
+    return lstat(path.c_str(), &buf) == 0;
+}
+
+
+void
+touch(const string& path)
+{
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    BOOST_REQUIRE(fd >= 0);
+    close(fd);
+}
+
+
+void
+check_undo(unsigned int jobs, bool fail)
+{
+    char tmp[] = "/tmp/snapper-undo-XXXXXX";
+    BOOST_REQUIRE(mkdtemp(tmp));
+
+    FilePaths file_paths;
+    file_paths.pre_path = string(tmp) + "/pre";
+    file_paths.system_path = string(tmp) + "/system";
+
+    // pre contains a tree deleted in system, system contains a tree
+    // created after pre
+
+    mkdir(file_paths.pre_path.c_str(), 0755);
+    mkdir(file_paths.system_path.c_str(), 0755);
+
+    vector<File> entries;
+
+    for (const string& dir : { "/a", "/b" })
+    {
+	mkdir((file_paths.pre_path + dir).c_str(), 0755);
+	entries.emplace_back(&file_paths, dir, DELETED);
+
+	for (const string& sub : { "/x", "/y" })
+	{
+	    mkdir((file_paths.pre_path + dir + sub).c_str(), 0755);
+	    entries.emplace_back(&file_paths, dir + sub, DELETED);
+
+	    for (const string& file : { "/1", "/2", "/3" })
+	    {
+		touch(file_paths.pre_path + dir + sub + file);
+		entries.emplace_back(&file_paths, dir + sub + file, DELETED);
+	    }
+	}
+    }
+
+    mkdir((file_paths.system_path + "/c").c_str(), 0755);
+    entries.emplace_back(&file_paths, "/c", CREATED);
+
+    for (const string& sub : { "/x", "/y" })
+    {
+	mkdir((file_paths.system_path + "/c" + sub).c_str(), 0755);
+	entries.emplace_back(&file_paths, "/c" + sub, CREATED);
+
+	touch(file_paths.system_path + "/c" + sub + "/1");
+	entries.emplace_back(&file_paths, "/c" + sub + "/1", CREATED);
+    }
+
+    // an unknown file lets deleting /c/x fail, all creations must still
+    // be done
+
+    if (fail)
+	touch(file_paths.system_path + "/c/x/unknown");
+
+    Files files(&file_paths, entries);
+    for (File& file : files)
+	file.setUndo(true);
+
+    vector<string> order;
+    set<string> started;
+    set<string> failed;
+    unsigned int calls = 0;
+
+    bool ok = files.doUndo(jobs, [&order, &started](const File& file) {
+	order.push_back(file.getName());
+	BOOST_CHECK(started.insert(file.getName()).second);
+    }, [&started, &failed, &calls](const File& file, bool ok) {
+	BOOST_CHECK(started.count(file.getName()) == 1);
+	if (!ok)
+	    failed.insert(file.getName());
+	++calls;
+    });
+
+    // every step is reported, serially in the order of getUndoSteps()
+
+    BOOST_CHECK_EQUAL(started.size(), entries.size());
+    BOOST_CHECK_EQUAL(calls, entries.size());
+
+    if (jobs == 1)
+    {
+	vector<UndoStep> undo_steps = files.getUndoSteps();
+	BOOST_REQUIRE_EQUAL(undo_steps.size(), order.size());
+	for (size_t i = 0; i < order.size(); ++i)
+	    BOOST_CHECK_EQUAL(undo_steps[i].name, order[i]);
+    }
+
+    BOOST_CHECK(exists(file_paths.system_path + "/a/x/1"));
+    BOOST_CHECK(exists(file_paths.system_path + "/b/y/3"));
+    BOOST_CHECK(!exists(file_paths.system_path + "/c/y"));
+
+    if (!fail)
+    {
+	BOOST_CHECK(ok);
+	BOOST_CHECK(failed.empty());
+
+	BOOST_CHECK(!exists(file_paths.system_path + "/c"));
+    }
+    else
+    {
+	// the failure does not stop the undo, only deleting the parent
+	// /c is skipped and reported as failed
+
+	BOOST_CHECK(!ok);
+	BOOST_CHECK(failed == set<string>({ "/c/x", "/c" }));
+
+	BOOST_CHECK(exists(file_paths.system_path + "/c/x"));
+	BOOST_CHECK(!exists(file_paths.system_path + "/c/x/1"));
+    }
+
+    system((string("rm -rf ") + tmp).c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE(serial)
+{
+    check_undo(1, false);
+}
+
+
+BOOST_AUTO_TEST_CASE(parallel)
+{
+    check_undo(4, false);
+}
+
+
+BOOST_AUTO_TEST_CASE(serial_failure)
+{
+    check_undo(1, true);
+}
+
+
+BOOST_AUTO_TEST_CASE(parallel_failure)
+{
+    check_undo(4, true);
+}
@@ -23,7 +23,7 @@
 #include <boost/algorithm/string/join.hpp>
 #include <boost/algorithm/string/replace.hpp>
 
-#include "client/utils/CsvFormatter.h"
+#include "utils/CsvFormatter.h"
 
 
 namespace snapper
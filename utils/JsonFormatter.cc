@@ -20,7 +20,7 @@
  */
 
 
-#include "client/utils/JsonFormatter.h"
+#include "utils/JsonFormatter.h"
 
 
 namespace snapper
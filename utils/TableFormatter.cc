@@ -20,7 +20,7 @@
  */
 
 
-#include "client/utils/TableFormatter.h"
+#include "utils/TableFormatter.h"
 
 
 namespace snapper
@@ -27,7 +27,7 @@
 #include <vector>
 #include <ostream>
 
-#include "client/utils/Table.h"
+#include "utils/Table.h"
 
 
 namespace snapper
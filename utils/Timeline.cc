@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact Novell, Inc.
+ *
+ * To contact Novell about this file by physical or electronic mail, you may
+ * find current contact information at www.novell.com.
+ */
+
+
+#include <algorithm>
+
+#include "equal-date.h"
+#include "Timeline.h"
+
+
+namespace snapper
+{
+
+    using namespace std;
+
+
+    /*
+     * A snapshot is the first of its period if no snapshot following it
+     * without interruption by another period is older. Computed from the
+     * end with the minimal date of the following snapshots of the period.
+     */
+    static vector<bool>
+    is_first(const vector<time_t>& dates, const vector<DateKeys>& keys, long DateKeys::*key)
+    {
+	size_t n = dates.size();
+
+	vector<bool> ret(n, true);
+
+	time_t min_date = 0;
+
+	for (size_t i = n; i-- > 0;)
+	{
+	    if (i + 1 < n && keys[i].*key == keys[i + 1].*key)
+	    {
+		ret[i] = min_date >= dates[i];
+		min_date = min(min_date, dates[i]);
+	    }
+	    else
+	    {
+		min_date = dates[i];
+	    }
+	}
+
+	return ret;
+    }
+
+
+    vector<bool>
+    timeline_keep(const vector<time_t>& dates, const TimelineLimits& limits)
+    {
+	vector<DateKeys> keys;
+	keys.reserve(dates.size());
+
+	for (time_t date : dates)
+	{
+	    struct tm tmp;
+	    localtime_r(&date, &tmp);
+	    keys.emplace_back(tmp);
+	}
+
+	const struct
+	{
+	    long DateKeys::*key;
+	    size_t limit;
+	} periods[] = {
+	    { &DateKeys::hour, limits.hourly },
+	    { &DateKeys::day, limits.daily },
+	    { &DateKeys::week, limits.weekly },
+	    { &DateKeys::month, limits.monthly },
+	    { &DateKeys::year, limits.yearly }
+	};
+
+	vector<bool> ret(dates.size(), false);
+
+	for (const auto& period : periods)
+	{
+	    if (period.limit == 0)
+		continue;
+
+	    vector<bool> first = is_first(dates, keys, period.key);
+
+	    size_t num = 0;
+
+	    for (size_t i = 0; i < dates.size() && num < period.limit; ++i)
+	    {
+		if (first[i])
+		{
+		    ret[i] = true;
+		    ++num;
+		}
+	    }
+	}
+
+	return ret;
+    }
+
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact Novell, Inc.
+ *
+ * To contact Novell about this file by physical or electronic mail, you may
+ * find current contact information at www.novell.com.
+ */
+
+
+#ifndef SNAPPER_TIMELINE_H
+#define SNAPPER_TIMELINE_H
+
+
+#include <time.h>
+#include <vector>
+
+
+namespace snapper
+{
+    using namespace std;
+
+
+    struct TimelineLimits
+    {
+	size_t hourly;
+	size_t daily;
+	size_t weekly;
+	size_t monthly;
+	size_t yearly;
+    };
+
+
+    /*
+     * Decides which timeline snapshots are kept. The dates must be ordered
+     * from the snapshot with the highest number to the one with the lowest
+     * number. A snapshot is kept if it is the oldest one of its hour, day,
+     * week, month or year and the limit for that period is not yet reached.
+     *
+     * Every date is converted only once and the periods are compared via
+     * DateKeys, so the runtime is linear in the number of snapshots.
+     */
+    vector<bool>
+    timeline_keep(const vector<time_t>& dates, const TimelineLimits& limits);
+
+}
+
+#endif
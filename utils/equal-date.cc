@@ -83,3 +83,28 @@ equal_hour(const struct tm& tmp1, const struct tm& tmp2)
 {
     return equal_day(tmp1, tmp2) && tmp1.tm_hour == tmp2.tm_hour;
 }
+
+
+static long
+floor_div(long a, long b)
+{
+    return a / b - (a % b < 0 ? 1 : 0);
+}
+
+
+// Number of days before the year as counted by days_in_year.
+
+static long
+days_before_year(long year)
+{
+    return 365 * year + floor_div(year + 3, 4) - floor_div(year + 99, 100) +
+	floor_div(year + 399, 400);
+}
+
+
+DateKeys::DateKeys(const struct tm& tmp)
+    : year(tmp.tm_year), month(12 * year + tmp.tm_mon),
+      week(days_before_year(tmp.tm_year) + yday_of_weeks_monday(tmp)),
+      day(31 * month + tmp.tm_mday), hour(24 * day + tmp.tm_hour)
+{
+}
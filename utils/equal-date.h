@@ -42,3 +42,20 @@ equal_day(const struct tm& tmp1, const struct tm& tmp2);
 bool
 equal_hour(const struct tm& tmp1, const struct tm& tmp2);
 
+
+
+/*
+ * Integer keys for the year, month, week, day and hour of a time. Two times
+ * have equal keys iff the corresponding equal_* function returns true, so
+ * times can be grouped without comparing struct tm's pairwise.
+ */
+struct DateKeys
+{
+    DateKeys(const struct tm& tmp);
+
+    long year;
+    long month;
+    long week;
+    long day;
+    long hour;
+};